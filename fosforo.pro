@@ -35,12 +35,13 @@ win32:QMAKE_LIBDIR += "$$_PRO_FILE_PWD_\..\ffmpeg-8.0.1-msvc\lib"
 win32:INCLUDEPATH += "..\libremidi\include"
 win32:INCLUDEPATH += "C:\Program Files (x86)\Windows Kits\10\Include\10.0.26100.0\cppwinrt"
 
-QT += widgets openglwidgets multimedia opengl
+QT += widgets openglwidgets multimedia opengl concurrent
 
 RESOURCES += ./resources/resources.qrc
 
 HEADERS += \
     src/applicationcontroller.h \
+    src/binaryconfig.h \
     src/colorpath.h \
     src/configparser.h \
     src/controlwidget.h \
@@ -63,8 +64,10 @@ HEADERS += \
     src/midisignals.h \
     src/node.h \
     src/nodemanager.h \
+    src/operationbenchmark.h \
     src/operationbuilder.h \
     src/operationparser.h \
+    src/operationsorter.h \
     src/operationwidget.h \
     src/outputwindow.h \
     src/overlay.h \
@@ -75,11 +78,14 @@ HEADERS += \
     src/parameters/uniformmat4parameter.h \
     src/parameters/uniformparameter.h \
     src/plotswidget.h \
+    src/presetbank.h \
+    src/proberecorder.h \
     src/recorder.h \
     src/rendermanager.h \
     src/rgbwidget.h \
     src/seed.h \
     src/seedwidget.h \
+    src/sortbenchmark.h \
     src/texformat.h \
     src/videoinputcontrol.h \
     src/widgets/focuswidgets.h \
@@ -91,6 +97,7 @@ HEADERS += \
 
 SOURCES += \
     src/applicationcontroller.cpp \
+    src/binaryconfig.cpp \
     src/colorpath.cpp \
     src/configparser.cpp \
     src/controlwidget.cpp \
@@ -112,8 +119,10 @@ SOURCES += \
     src/midilistwidget.cpp \
     src/node.cpp \
     src/nodemanager.cpp \
+    src/operationbenchmark.cpp \
     src/operationbuilder.cpp \
     src/operationparser.cpp \
+    src/operationsorter.cpp \
     src/operationwidget.cpp \
     src/outputwindow.cpp \
     src/overlay.cpp \
@@ -122,11 +131,14 @@ SOURCES += \
     src/parameters/uniformmat4parameter.cpp \
     src/parameters/uniformparameter.cpp \
     src/plotswidget.cpp \
+    src/presetbank.cpp \
+    src/proberecorder.cpp \
     src/recorder.cpp \
     src/rendermanager.cpp \
     src/rgbwidget.cpp \
     src/seed.cpp \
     src/seedwidget.cpp \
+    src/sortbenchmark.cpp \
     src/videoinputcontrol.cpp \
     src/widgets/uniformmat4widget.cpp \
     src/widgets/uniformwidget.cpp
@@ -0,0 +1,18 @@
+#version 330 core
+
+in vec2 texCoords;
+out vec4 fragColor;
+
+uniform sampler2D inTexture;
+uniform sampler3D lut;
+uniform float lutSize;
+
+void main()
+{
+    // Input colour addresses LUT between centres of first and last texels
+
+    vec3 srcColor = clamp(texture(inTexture, texCoords).rgb, 0.0, 1.0);
+    vec3 lutCoords = (srcColor * (lutSize - 1.0) + 0.5) / lutSize;
+
+    fragColor = vec4(texture(lut, lutCoords).rgb, 1.0);
+}
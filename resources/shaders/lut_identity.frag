@@ -0,0 +1,15 @@
+#version 330 core
+
+out vec4 fragColor;
+
+uniform int lutSize;
+
+void main()
+{
+    // Identity cube laid out as slices side by side: texel (r + size * b, g)
+
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 color = vec3(texel.x % lutSize, texel.y, texel.x / lutSize) / float(lutSize - 1);
+
+    fragColor = vec4(color, 1.0);
+}
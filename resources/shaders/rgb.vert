@@ -1,15 +1,20 @@
-#version 330 core
-
-layout (location = 0) in vec2 texCoord;
+#version 450 core
 
 out vec3 texColor;
 
 uniform sampler2D texSampler;
 uniform mat4 transform;
+uniform ivec2 gridSize;
+uniform int sampleStep;
 
 void main()
 {
-    vec4 color = texture(texSampler, texCoord);
+    // Texel generated from vertex index, no vertex attributes needed
+
+    ivec2 gridPos = ivec2(gl_VertexID % gridSize.x, gl_VertexID / gridSize.x);
+    ivec2 texel = min(gridPos * sampleStep, textureSize(texSampler, 0) - 1);
+
+    vec4 color = texelFetch(texSampler, texel, 0);
     gl_Position = transform * vec4(color.rgb, 1.0);
     texColor = color.rgb;
 }
@@ -0,0 +1,9 @@
+#version 450 core
+
+in vec4 binColor;
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = binColor;
+}
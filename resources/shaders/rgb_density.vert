@@ -0,0 +1,31 @@
+#version 450 core
+
+layout (std430, binding = 0) readonly buffer Density
+{
+    uint maxCount;
+    uint density[];
+};
+
+out vec4 binColor;
+
+uniform mat4 transform;
+uniform uint numBins;
+uniform float pointSize;
+
+void main()
+{
+    uint index = uint(gl_VertexID);
+    uint count = density[index];
+
+    vec3 pos = (vec3(index % numBins, (index / numBins) % numBins, index / (numBins * numBins)) + 0.5) / float(numBins);
+
+    float weight = 0.0;
+    if (count > 0)
+        weight = min(log(1.0 + float(count)) / log(1.0 + float(max(maxCount, 1))), 1.0);
+
+    // Empty bins placed outside clip volume
+
+    gl_Position = count > 0 ? transform * vec4(pos, 1.0) : vec4(2.0, 2.0, 2.0, 1.0);
+    gl_PointSize = max(1.0, pointSize * weight);
+    binColor = vec4(pos, weight);
+}
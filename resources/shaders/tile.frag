@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 texCoords;
+out vec4 fragColor;
+
+uniform sampler2D inTexture;
+uniform vec4 region;
+
+void main()
+{
+    // Region of input texture: (left, bottom, right, top) in texture coordinates
+
+    fragColor = texture(inTexture, mix(region.xy, region.zw, texCoords));
+}
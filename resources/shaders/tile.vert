@@ -0,0 +1,13 @@
+#version 330 core
+
+out vec2 texCoords;
+
+void main()
+{
+    // Viewport-filling triangle strip from vertex index
+
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    gl_Position = vec4(2.0 * corner - 1.0, 0.0, 1.0);
+    texCoords = corner;
+}
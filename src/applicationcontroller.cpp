@@ -1,5 +1,7 @@
 #include "applicationcontroller.h"
 
+#include <QDebug>
+
 
 
 ApplicationController::ApplicationController()
@@ -32,6 +34,9 @@ ApplicationController::ApplicationController()
     plotsWidget = new PlotsWidget(renderManager);
     plotsWidget->setVisible(false);
 
+    histogramWidget = new HistogramWidget();
+    histogramWidget->setVisible(false);
+
     graphWidget = new GraphWidget(factory, nodeManager);
     graphWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
 
@@ -39,6 +44,8 @@ ApplicationController::ApplicationController()
 
     configParser = new ConfigurationParser(factory, nodeManager, renderManager, graphWidget, &midiLinkManager);
 
+    presetBank = new PresetBank(configParser, renderManager);
+
     midiControl = new MidiControl();
     midiListWidget = new MidiListWidget();
 
@@ -60,6 +67,7 @@ ApplicationController::ApplicationController()
     connect(graphWidget, &GraphWidget::selectedNodesChanged, controlWidget, &ControlWidget::selectOpsTableRows);
 
     connect(renderManager, &RenderManager::frameReady, outputWindow, &OutputWindow::render);
+    connect(renderManager, &RenderManager::frameReady, histogramWidget, &HistogramWidget::compute);
 
     connect(&updateViewTimer, &QTimer::timeout, outputWindow, &OutputWindow::updateView);
 
@@ -73,6 +81,7 @@ ApplicationController::ApplicationController()
     connect(outputWindow, &OutputWindow::renderDone, this, &ApplicationController::measureFps);
     connect(outputWindow, &OutputWindow::renderDone, plotsWidget, &PlotsWidget::updatePlots);
     connect(outputWindow, &OutputWindow::supportedTexFormats, controlWidget, &ControlWidget::populateTexFormatComboBox);
+    connect(outputWindow, &OutputWindow::supportedTexFormats, factory, &Factory::setSupportedTexFormats);
     connect(outputWindow, &OutputWindow::fullScreenToggled, controlWidget, &ControlWidget::toggleFullScreenAction);
     connect(outputWindow, &OutputWindow::screenshot, controlWidget, &ControlWidget::screenshot);
     connect(outputWindow, &OutputWindow::record, controlWidget, &ControlWidget::toggleRecording);
@@ -88,12 +97,19 @@ ApplicationController::ApplicationController()
 
     connect(renderManager, &RenderManager::texturesChanged, nodeManager, &NodeManager::onTexturesChanged);
     connect(renderManager, &RenderManager::frameRecorded, controlWidget, &ControlWidget::setVideoCaptureElapsedTimeLabel);
+    connect(renderManager, &RenderManager::stillRendered, controlWidget, &ControlWidget::stillRendered);
+    connect(renderManager, &RenderManager::statisticsReady, nodeManager, &NodeManager::statisticsReady);
+    connect(renderManager, &RenderManager::effectiveSizeChanged, this, [=, this](GLuint width, GLuint height) {
+        overlay->addMessage(resolutionMessageId, "Display", "Resolution", QString("%1 x %2").arg(width).arg(height));
+    });
 
     connect(nodeManager, &NodeManager::outputTextureChanged, renderManager, &RenderManager::setOutputTextureId);
     connect(nodeManager, &NodeManager::outputTextureChanged, outputWindow, &OutputWindow::setOutputTextureId);
     connect(nodeManager, &NodeManager::outputTextureChanged, plotsWidget, &PlotsWidget::setTextureID);
+    connect(nodeManager, &NodeManager::outputTextureChanged, histogramWidget, &HistogramWidget::setTextureID);
     connect(nodeManager, &NodeManager::sortedOperationsChanged, renderManager, &RenderManager::setSortedOperations);
     connect(nodeManager, &NodeManager::operationEdited, renderManager, &RenderManager::adjustOperationOrtho);
+    connect(nodeManager, &NodeManager::operationTexturesChanged, renderManager, &RenderManager::updateOperationTextures);
     connect(nodeManager, &NodeManager::parameterValueChanged, overlay, &Overlay::addMessage);
     connect(nodeManager, &NodeManager::midiSignalsCreated, &midiLinkManager, &MidiLinkManager::addMidiSignals);
     connect(nodeManager, &NodeManager::midiSignalsRemoved, &midiLinkManager, &MidiLinkManager::removeMidiSignals);
@@ -104,16 +120,35 @@ ApplicationController::ApplicationController()
     connect(controlWidget, &ControlWidget::startRecording, renderManager, &RenderManager::startRecording);
     connect(controlWidget, &ControlWidget::stopRecording, renderManager, &RenderManager::stopRecording);
     connect(controlWidget, &ControlWidget::takeScreenshot, renderManager, &RenderManager::takeScreenshot);
+    connect(controlWidget, &ControlWidget::renderStill, renderManager, &RenderManager::renderStill);
     connect(controlWidget, &ControlWidget::texFormatChanged, renderManager, &RenderManager::setTextureFormat);
     connect(controlWidget, &ControlWidget::imageSizeChanged, this, &ApplicationController::setSize);
     connect(controlWidget, &ControlWidget::showPlotsWidget, plotsWidget, &QWidget::show);
+    connect(controlWidget, &ControlWidget::showHistogramWidget, histogramWidget, &QWidget::show);
     connect(controlWidget, &ControlWidget::overlayToggled, overlay, &Overlay::enable);
     connect(controlWidget, &ControlWidget::configRead, renderManager, &RenderManager::resetIterationNumer);
     connect(controlWidget, &ControlWidget::readConfig, configParser, &ConfigurationParser::read);
     connect(controlWidget, &ControlWidget::writeConfig, configParser, &ConfigurationParser::write);
+    connect(controlWidget, &ControlWidget::preloadPreset, presetBank, &PresetBank::preload);
+    connect(controlWidget, &ControlWidget::activatePreset, presetBank, &PresetBank::activate);
+    connect(controlWidget, &ControlWidget::activateNextPreset, presetBank, &PresetBank::activateNext);
+    connect(controlWidget, &ControlWidget::presetCarryOverToggled, presetBank, &PresetBank::setCarryOver);
+    connect(controlWidget, &ControlWidget::presetBankCapacityChanged, presetBank, &PresetBank::setCapacity);
+    connect(controlWidget, &ControlWidget::clearPresetBank, presetBank, &PresetBank::clear);
+    connect(presetBank, &PresetBank::presetsChanged, controlWidget, &ControlWidget::populatePresetBankMenu);
+    connect(outputWindow, &OutputWindow::presetSelected, presetBank, &PresetBank::activate);
+    connect(outputWindow, &OutputWindow::nextPresetSelected, presetBank, &PresetBank::activateNext);
     connect(controlWidget, &ControlWidget::nodesSelected, graphWidget, &GraphWidget::markNodes);
     connect(controlWidget, &ControlWidget::fullScreenToggled, outputWindow, &OutputWindow::toggleFullScreen);
     connect(controlWidget, &ControlWidget::autoResizeWindow, outputWindow, &OutputWindow::toggleAutoResize);
+    connect(controlWidget, &ControlWidget::adaptiveResolutionToggled, renderManager, &RenderManager::setAdaptiveResolution);
+    connect(controlWidget, &ControlWidget::iterationsPerFrameChanged, renderManager, &RenderManager::setIterationsPerFrame);
+    connect(controlWidget, &ControlWidget::incrementalRenderToggled, renderManager, &RenderManager::setIncrementalRender);
+    connect(controlWidget, &ControlWidget::lutBakingToggled, renderManager, &RenderManager::setLutBaking);
+    connect(controlWidget, &ControlWidget::regionRenderingToggled, renderManager, &RenderManager::setRegionRendering);
+    connect(controlWidget, &ControlWidget::convergenceDetectionToggled, renderManager, &RenderManager::setConvergenceDetection);
+
+    connect(renderManager, &RenderManager::convergenceChanged, controlWidget, &ControlWidget::updateConvergence);
 
     connect(configParser, &ConfigurationParser::newImageSizeRead, controlWidget, &ControlWidget::updateWindowSizeLineEdits);
     connect(configParser, &ConfigurationParser::newImageSizeRead, this, &ApplicationController::setSize);
@@ -129,7 +164,9 @@ ApplicationController::ApplicationController()
 
 ApplicationController::~ApplicationController()
 {
+    delete presetBank;
     delete plotsWidget;
+    delete histogramWidget;
     delete controlWidget;
     delete configParser;
     delete nodeManager;
@@ -143,6 +180,38 @@ ApplicationController::~ApplicationController()
 
 
 
+void ApplicationController::setConvergenceAction(QString action)
+{
+    if (action == "stop") {
+        controlWidget->setConvergenceAction(ConvergenceAction::Stop);
+    }
+    else if (action == "reseed") {
+        controlWidget->setConvergenceAction(ConvergenceAction::Reseed);
+    }
+    else if (action == "next") {
+        controlWidget->setConvergenceAction(ConvergenceAction::NextPreset);
+    }
+    else {
+        controlWidget->setConvergenceAction(ConvergenceAction::None);
+    }
+
+    // Detected state reported on standard output
+
+    connect(renderManager, &RenderManager::convergenceChanged, this, [=, this](int period) {
+        if (period == 0) {
+            qInfo().noquote() << QString("Iteration %1: no convergence").arg(renderManager->iterationNumber());
+        }
+        else if (period == 1) {
+            qInfo().noquote() << QString("Iteration %1: fixed point").arg(renderManager->iterationNumber());
+        }
+        else {
+            qInfo().noquote() << QString("Iteration %1: cycle of period %2").arg(renderManager->iterationNumber()).arg(period);
+        }
+    });
+}
+
+
+
 void ApplicationController::measureFps()
 {
     stepEnd = std::chrono::steady_clock::now();
@@ -219,6 +288,7 @@ void ApplicationController::closeAll()
     renderManager->stop();
 
     plotsWidget->close();
+    histogramWidget->close();
     graphWidget->close();
 }
 
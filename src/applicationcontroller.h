@@ -9,8 +9,10 @@
 #include "outputwindow.h"
 #include "graphwidget.h"
 #include "configparser.h"
+#include "presetbank.h"
 #include "controlwidget.h"
 #include "plotswidget.h"
+#include "histogramwidget.h"
 #include "midicontrol.h"
 #include "midilistwidget.h"
 #include "midilinkmanager.h"
@@ -30,6 +32,8 @@ public:
     ApplicationController();
     ~ApplicationController();
 
+    void setConvergenceAction(QString action);
+
 signals:
     void outputTextureChanged(GLuint id);
 
@@ -43,8 +47,10 @@ private:
     OutputWindow* outputWindow;
     GraphWidget* graphWidget;
     ConfigurationParser* configParser;
+    PresetBank* presetBank;
     ControlWidget* controlWidget;
     PlotsWidget* plotsWidget;
+    HistogramWidget* histogramWidget;
     MidiControl* midiControl;
     MidiListWidget* midiListWidget;
     MidiLinkManager midiLinkManager;
@@ -60,6 +66,8 @@ private:
 
     QTimer updateViewTimer;
 
+    QUuid resolutionMessageId = QUuid::createUuid();
+
     void closeAll();
 
 private slots:
@@ -0,0 +1,792 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include "binaryconfig.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QUuid>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#include <cstring>
+#include <limits>
+
+
+
+const char BinaryConfig::mMagic[4] = { 'F', 'O', 'S', 'B' };
+
+
+
+bool BinaryConfig::isBinary(const uchar* data, qint64 size)
+{
+    return data && size >= 6 && memcmp(data, mMagic, 4) == 0;
+}
+
+
+
+QByteArray BinaryConfig::encode(const QByteArray& xml)
+{
+    BinaryConfig codec;
+
+    QXmlStreamReader reader(xml);
+
+    // Indentation between elements dropped: writer with auto formatting restores it
+    // Whitespace kept only when it is the whole text of an element
+
+    QString pendingWhitespace;
+    bool afterStart = false;
+    bool shaderText = false;
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+
+        if (reader.isStartElement())
+        {
+            codec.mStream.append(static_cast<char>(StartElement));
+            writeVarint(codec.mStream, codec.nameIndex(reader.name()));
+
+            const QXmlStreamAttributes attributes = reader.attributes();
+
+            writeVarint(codec.mStream, attributes.size());
+
+            for (const QXmlStreamAttribute& attribute : attributes)
+            {
+                writeVarint(codec.mStream, codec.nameIndex(attribute.name()));
+                codec.writeValue(attribute.value(), false);
+            }
+
+            shaderText = reader.name() == QLatin1StringView("vertex_shader") ||
+                reader.name() == QLatin1StringView("fragment_shader") ||
+                reader.name() == QLatin1StringView("compute_shader");
+
+            pendingWhitespace.clear();
+            afterStart = true;
+        }
+        else if (reader.isEndElement())
+        {
+            if (afterStart && !pendingWhitespace.isEmpty())
+            {
+                codec.mStream.append(static_cast<char>(Characters));
+                codec.writeValue(pendingWhitespace, false);
+            }
+
+            codec.mStream.append(static_cast<char>(EndElement));
+
+            pendingWhitespace.clear();
+            afterStart = false;
+            shaderText = false;
+        }
+        else if (reader.isCharacters())
+        {
+            if (reader.isWhitespace()) {
+                pendingWhitespace.append(reader.text());
+            }
+            else
+            {
+                codec.mStream.append(static_cast<char>(Characters));
+                codec.writeValue(reader.text(), shaderText);
+
+                afterStart = false;
+            }
+        }
+    }
+
+    if (reader.hasError()) {
+        return QByteArray();
+    }
+
+    codec.mStream.append(static_cast<char>(End));
+
+    // Header, tables and token stream
+
+    QByteArray out;
+    out.append(mMagic, 4);
+
+    quint16 version = qToLittleEndian(mVersion);
+    out.append(reinterpret_cast<const char*>(&version), sizeof(version));
+
+    writeVarint(out, codec.mNames.size());
+
+    foreach (QByteArray name, codec.mNames) {
+        writeBytes(out, name);
+    }
+
+    writeVarint(out, codec.mShaders.size());
+
+    foreach (QByteArray shader, codec.mShaders) {
+        writeBytes(out, shader);
+    }
+
+    out.append(codec.mStream);
+
+    return out;
+}
+
+
+
+int BinaryConfig::nameIndex(QStringView name)
+{
+    QByteArray latin1 = name.toLatin1();
+
+    auto it = mNameIndices.constFind(latin1);
+    if (it != mNameIndices.constEnd()) {
+        return it.value();
+    }
+
+    mNames.append(latin1);
+    mNameIndices.insert(latin1, mNames.size() - 1);
+
+    return mNames.size() - 1;
+}
+
+
+
+void BinaryConfig::writeValue(QStringView text, bool shader)
+{
+    if (text.isEmpty())
+    {
+        mStream.append(static_cast<char>(Empty));
+        return;
+    }
+
+    // Shader sources stored once, referenced by index
+
+    if (shader)
+    {
+        QByteArray base64 = text.toLatin1();
+        QByteArray source = QByteArray::fromBase64(base64);
+
+        if (source.toBase64() == base64)
+        {
+            int index = mShaderIndices.value(source, -1);
+
+            if (index < 0)
+            {
+                mShaders.append(source);
+                index = mShaders.size() - 1;
+                mShaderIndices.insert(source, index);
+            }
+
+            mStream.append(static_cast<char>(Shader));
+            writeVarint(mStream, index);
+            return;
+        }
+    }
+
+    // Numbers and ids packed only if they print back to the very same text
+
+    bool ok;
+
+    qlonglong intValue = text.toLongLong(&ok);
+    if (ok && QString::number(intValue) == text)
+    {
+        mStream.append(static_cast<char>(Int));
+        writeVarint(mStream, (static_cast<quint64>(intValue) << 1) ^ static_cast<quint64>(intValue >> 63));
+        return;
+    }
+
+    double doubleValue = text.toDouble(&ok);
+    if (ok)
+    {
+        float floatValue = static_cast<float>(doubleValue);
+
+        if (QString::number(floatValue) == text)
+        {
+            float value = qToLittleEndian(floatValue);
+            mStream.append(static_cast<char>(Float));
+            mStream.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            return;
+        }
+        if (QString::number(doubleValue) == text)
+        {
+            double value = qToLittleEndian(doubleValue);
+            mStream.append(static_cast<char>(Double));
+            mStream.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            return;
+        }
+    }
+
+    if (text.startsWith(u'{'))
+    {
+        QUuid uuid(text);
+        if (!uuid.isNull() && uuid.toString() == text)
+        {
+            mStream.append(static_cast<char>(Uuid));
+            mStream.append(uuid.toRfc4122());
+            return;
+        }
+    }
+
+    mStream.append(static_cast<char>(String));
+    writeBytes(mStream, text.toUtf8());
+}
+
+
+
+void BinaryConfig::writeVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80)
+    {
+        out.append(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+
+    out.append(static_cast<char>(value));
+}
+
+
+
+void BinaryConfig::writeBytes(QByteArray& out, QByteArrayView bytes)
+{
+    writeVarint(out, bytes.size());
+    out.append(bytes);
+}
+
+
+
+QByteArray BinaryConfig::decode(const uchar* data, qint64 size)
+{
+    BinaryConfigReader reader(data, size);
+
+    if (reader.hasError()) {
+        return QByteArray();
+    }
+
+    QByteArray xml;
+
+    QXmlStreamWriter writer(&xml);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+
+    while (!reader.hasError())
+    {
+        Token token = reader.readNext();
+
+        if (token == StartElement)
+        {
+            writer.writeStartElement(reader.name());
+
+            foreach (auto attribute, reader.attributes().mAttributes) {
+                writer.writeAttribute(reader.attributes().mNames->at(attribute.first), attribute.second.toString());
+            }
+        }
+        else if (token == EndElement) {
+            writer.writeEndElement();
+        }
+        else if (token == Characters) {
+            writer.writeCharacters(reader.text().toString());
+        }
+        else {
+            break;
+        }
+    }
+
+    if (reader.hasError()) {
+        return QByteArray();
+    }
+
+    writer.writeEndDocument();
+
+    return xml;
+}
+
+
+
+bool BinaryConfig::convert(QString inFilename, QString outFilename)
+{
+    QFile inFile(inFilename);
+    if (!inFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray in = inFile.readAll();
+    inFile.close();
+
+    bool inBinary = isBinary(reinterpret_cast<const uchar*>(in.constData()), in.size());
+    bool outBinary = outFilename.endsWith(".fosb");
+
+    QByteArray xml = inBinary ? decode(reinterpret_cast<const uchar*>(in.constData()), in.size()) : in;
+    QByteArray out = outBinary ? encode(xml) : xml;
+
+    if (out.isEmpty()) {
+        return false;
+    }
+
+    QSaveFile outFile(outFilename);
+    if (!outFile.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    outFile.write(out);
+
+    qInfo().noquote() << QString("%1 (%2 bytes) -> %3 (%4 bytes)").arg(inFilename).arg(in.size()).arg(outFilename).arg(out.size());
+
+    return outFile.commit();
+}
+
+
+
+QString BinaryConfigValue::toString() const
+{
+    switch (mType)
+    {
+        case BinaryConfig::String: return mBytes.isNull() ? mText : QString::fromUtf8(mBytes);
+        case BinaryConfig::Int: return QString::number(mInt);
+        case BinaryConfig::Float: return QString::number(mFloat);
+        case BinaryConfig::Double: return QString::number(mDouble);
+        case BinaryConfig::Uuid: return QUuid::fromRfc4122(mBytes).toString();
+        case BinaryConfig::Shader: return QString::fromLatin1(QByteArray::fromRawData(mBytes.data(), mBytes.size()).toBase64());
+        default: return QString();
+    }
+}
+
+
+
+int BinaryConfigValue::toInt() const
+{
+    if (mType == BinaryConfig::Int && mInt >= std::numeric_limits<int>::min() && mInt <= std::numeric_limits<int>::max()) {
+        return static_cast<int>(mInt);
+    }
+
+    return toString().toInt();
+}
+
+
+
+unsigned int BinaryConfigValue::toUInt() const
+{
+    if (mType == BinaryConfig::Int && mInt >= 0 && mInt <= std::numeric_limits<unsigned int>::max()) {
+        return static_cast<unsigned int>(mInt);
+    }
+
+    return toString().toUInt();
+}
+
+
+
+float BinaryConfigValue::toFloat() const
+{
+    switch (mType)
+    {
+        case BinaryConfig::Int: return static_cast<float>(mInt);
+        case BinaryConfig::Float: return mFloat;
+        case BinaryConfig::Double: return static_cast<float>(mDouble);
+        default: return toString().toFloat();
+    }
+}
+
+
+
+BinaryConfigValue::operator QString() const
+{
+    return toString();
+}
+
+
+
+bool BinaryConfigValue::operator==(const char* text) const
+{
+    return toString() == QLatin1StringView(text);
+}
+
+
+
+BinaryConfigValue BinaryConfigAttributes::value(const char* name) const
+{
+    foreach (auto attribute, mAttributes)
+    {
+        if (mNames->at(attribute.first) == QLatin1StringView(name)) {
+            return attribute.second;
+        }
+    }
+
+    return BinaryConfigValue();
+}
+
+
+
+bool BinaryConfigAttributes::hasAttribute(const char* name) const
+{
+    foreach (auto attribute, mAttributes)
+    {
+        if (mNames->at(attribute.first) == QLatin1StringView(name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+
+BinaryConfigReader::BinaryConfigReader(const uchar* data, qint64 size) :
+    mTables { &mOwnTables },
+    mBegin { data },
+    mData { data },
+    mEnd { data + size }
+{
+    mAttributes.mNames = &mOwnTables.names;
+
+    if (!BinaryConfig::isBinary(data, size))
+    {
+        mError = true;
+        return;
+    }
+
+    mData += 4;
+
+    quint16 version = qFromLittleEndian<quint16>(readBytes(sizeof(quint16)).data());
+    if (version != BinaryConfig::mVersion)
+    {
+        mError = true;
+        return;
+    }
+
+    // Tables point into data: no copies
+    // Each entry takes at least one byte, which bounds counts read from corrupt data
+
+    quint64 numNames = readVarint();
+    if (numNames > static_cast<quint64>(mEnd - mData))
+    {
+        mError = true;
+        return;
+    }
+
+    mOwnTables.names.resize(numNames);
+
+    for (qsizetype i = 0; i < mOwnTables.names.size() && !mError; i++)
+    {
+        QByteArrayView name = readBytes(readVarint());
+        mOwnTables.names[i] = QLatin1StringView(name.data(), name.size());
+    }
+
+    quint64 numShaders = readVarint();
+    if (numShaders > static_cast<quint64>(mEnd - mData))
+    {
+        mError = true;
+        return;
+    }
+
+    mOwnTables.shaderSources.resize(numShaders);
+    mOwnTables.shaders.resize(numShaders);
+
+    for (qsizetype i = 0; i < mOwnTables.shaderSources.size() && !mError; i++)
+    {
+        mOwnTables.shaderSources[i] = readBytes(readVarint());
+        mOwnTables.shaders[i] = QString::fromUtf8(mOwnTables.shaderSources[i]);
+    }
+}
+
+
+
+BinaryConfigReader::BinaryConfigReader(const BinaryConfigReader& reader, qint64 offset) :
+    mTables { reader.mTables },
+    mBegin { reader.mBegin },
+    mData { reader.mBegin + offset },
+    mEnd { reader.mEnd }
+{
+    mAttributes.mNames = &mTables->names;
+    mError = reader.mError || offset < 0 || offset > mEnd - mBegin;
+}
+
+
+
+BinaryConfig::Token BinaryConfigReader::readNext()
+{
+    if (mError || mData >= mEnd)
+    {
+        mError = true;
+        return BinaryConfig::End;
+    }
+
+    BinaryConfig::Token token = static_cast<BinaryConfig::Token>(*mData++);
+
+    if (token == BinaryConfig::StartElement)
+    {
+        quint64 index = readVarint();
+        quint64 numAttributes = readVarint();
+
+        if (index >= static_cast<quint64>(mTables->names.size()) || numAttributes > static_cast<quint64>(mEnd - mData))
+        {
+            mError = true;
+            return BinaryConfig::End;
+        }
+
+        mNameIndex = static_cast<int>(index);
+        mAttributes.mAttributes.clear();
+
+        for (quint64 i = 0; i < numAttributes && !mError; i++)
+        {
+            quint64 attrIndex = readVarint();
+
+            if (attrIndex >= static_cast<quint64>(mTables->names.size()))
+            {
+                mError = true;
+                break;
+            }
+
+            mAttributes.mAttributes.append(qMakePair(static_cast<int>(attrIndex), readValue()));
+        }
+    }
+    else if (token == BinaryConfig::Characters) {
+        mText = readValue();
+    }
+    else if (token != BinaryConfig::EndElement && token != BinaryConfig::End) {
+        mError = true;
+    }
+
+    return mError ? BinaryConfig::End : token;
+}
+
+
+
+bool BinaryConfigReader::readNextStartElement()
+{
+    while (true)
+    {
+        BinaryConfig::Token token = readNext();
+
+        if (token == BinaryConfig::StartElement) {
+            return true;
+        }
+        else if (token != BinaryConfig::Characters) {
+            return false;
+        }
+    }
+}
+
+
+
+void BinaryConfigReader::skipCurrentElement()
+{
+    int depth = 1;
+
+    while (depth > 0)
+    {
+        BinaryConfig::Token token = readNext();
+
+        if (token == BinaryConfig::StartElement) {
+            depth++;
+        }
+        else if (token == BinaryConfig::EndElement) {
+            depth--;
+        }
+        else if (token == BinaryConfig::End) {
+            return;
+        }
+    }
+}
+
+
+
+QLatin1StringView BinaryConfigReader::name() const
+{
+    return mNameIndex >= 0 ? mTables->names.at(mNameIndex) : QLatin1StringView();
+}
+
+
+
+const BinaryConfigAttributes& BinaryConfigReader::attributes() const
+{
+    return mAttributes;
+}
+
+
+
+BinaryConfigValue BinaryConfigReader::readElementText()
+{
+    // Text is usually a single value: kept packed, pieces joined otherwise
+
+    BinaryConfigValue text;
+    int numPieces = 0;
+
+    while (true)
+    {
+        BinaryConfig::Token token = readNext();
+
+        if (token == BinaryConfig::Characters)
+        {
+            if (numPieces++ == 0) {
+                text = mText;
+            }
+            else
+            {
+                text.mText = text.toString() + mText.toString();
+                text.mType = BinaryConfig::String;
+                text.mBytes = QByteArrayView();
+            }
+        }
+        else
+        {
+            // Child elements not expected, as with QXmlStreamReader
+
+            if (token == BinaryConfig::StartElement) {
+                mError = true;
+            }
+
+            return text;
+        }
+    }
+}
+
+
+
+QString BinaryConfigReader::readShader()
+{
+    // Source taken from table, shared by all nodes using it
+
+    BinaryConfigValue text = readElementText();
+
+    if (text.mType == BinaryConfig::Shader) {
+        return mTables->shaders.at(text.mInt);
+    }
+
+    return QString::fromUtf8(QByteArray::fromBase64(text.toString().toUtf8()));
+}
+
+
+
+const BinaryConfigValue& BinaryConfigReader::text() const
+{
+    return mText;
+}
+
+
+
+qint64 BinaryConfigReader::offset() const
+{
+    return mData - mBegin;
+}
+
+
+
+bool BinaryConfigReader::hasError() const
+{
+    return mError;
+}
+
+
+
+quint64 BinaryConfigReader::readVarint()
+{
+    quint64 value = 0;
+    int shift = 0;
+
+    while (mData < mEnd && shift < 64)
+    {
+        uchar byte = *mData++;
+        value |= static_cast<quint64>(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80)) {
+            return value;
+        }
+
+        shift += 7;
+    }
+
+    mError = true;
+    return 0;
+}
+
+
+
+QByteArrayView BinaryConfigReader::readBytes(qint64 size)
+{
+    if (mError || size < 0 || size > mEnd - mData)
+    {
+        mError = true;
+
+        static const char zeros[8] = {};
+        return QByteArrayView(zeros, 0);
+    }
+
+    QByteArrayView bytes(reinterpret_cast<const char*>(mData), size);
+    mData += size;
+
+    return bytes;
+}
+
+
+
+BinaryConfigValue BinaryConfigReader::readValue()
+{
+    BinaryConfigValue value;
+
+    if (mData >= mEnd)
+    {
+        mError = true;
+        return value;
+    }
+
+    value.mType = static_cast<BinaryConfig::Value>(*mData++);
+
+    if (value.mType == BinaryConfig::String) {
+        value.mBytes = readBytes(readVarint());
+    }
+    else if (value.mType == BinaryConfig::Int)
+    {
+        quint64 zigzag = readVarint();
+        value.mInt = static_cast<qint64>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+    }
+    else if (value.mType == BinaryConfig::Float)
+    {
+        QByteArrayView bytes = readBytes(sizeof(float));
+        value.mFloat = mError ? 0.0 : qFromLittleEndian<float>(bytes.data());
+    }
+    else if (value.mType == BinaryConfig::Double)
+    {
+        QByteArrayView bytes = readBytes(sizeof(double));
+        value.mDouble = mError ? 0.0 : qFromLittleEndian<double>(bytes.data());
+    }
+    else if (value.mType == BinaryConfig::Uuid) {
+        value.mBytes = readBytes(16);
+    }
+    else if (value.mType == BinaryConfig::Shader)
+    {
+        quint64 index = readVarint();
+
+        if (index >= static_cast<quint64>(mTables->shaderSources.size())) {
+            mError = true;
+        }
+        else
+        {
+            value.mInt = static_cast<qint64>(index);
+            value.mBytes = mTables->shaderSources.at(index);
+        }
+    }
+    else if (value.mType != BinaryConfig::Empty) {
+        mError = true;
+    }
+
+    if (mError) {
+        value = BinaryConfigValue();
+    }
+
+    return value;
+}
@@ -0,0 +1,189 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#ifndef BINARYCONFIG_H
+#define BINARYCONFIG_H
+
+
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QLatin1StringView>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+
+
+// Compact binary form of configuration files, converted losslessly to and from their XML
+// Element and attribute names stored once in a table, shaders once per content,
+// numbers and ids packed when their text is reproduced exactly
+
+class BinaryConfig
+{
+public:
+    static bool isBinary(const uchar* data, qint64 size);
+
+    static QByteArray encode(const QByteArray& xml);
+    static QByteArray decode(const uchar* data, qint64 size);
+
+    static bool convert(QString inFilename, QString outFilename);
+
+    enum Token : quint8
+    {
+        End = 0x00,
+        StartElement = 0x01,
+        EndElement = 0x02,
+        Characters = 0x03
+    };
+
+    enum Value : quint8
+    {
+        String = 0x10,
+        Empty = 0x11,
+        Int = 0x12,
+        Float = 0x13,
+        Double = 0x14,
+        Uuid = 0x15,
+        Shader = 0x16
+    };
+
+    static const char mMagic[4];
+    static const quint16 mVersion = 1;
+
+private:
+    QByteArray mStream;
+    QList<QByteArray> mNames;
+    QHash<QByteArray, int> mNameIndices;
+    QList<QByteArray> mShaders;
+    QHash<QByteArray, int> mShaderIndices;
+
+    int nameIndex(QStringView name);
+    void writeValue(QStringView text, bool shader);
+
+    static void writeVarint(QByteArray& out, quint64 value);
+    static void writeBytes(QByteArray& out, QByteArrayView bytes);
+};
+
+
+
+// BinaryConfigValue: attribute value or element text pointing into binary data, converted on demand
+
+class BinaryConfigValue
+{
+public:
+    QString toString() const;
+    int toInt() const;
+    unsigned int toUInt() const;
+    float toFloat() const;
+
+    operator QString() const;
+    bool operator==(const char* text) const;
+
+private:
+    friend class BinaryConfigReader;
+
+    BinaryConfig::Value mType = BinaryConfig::Empty;
+    qint64 mInt = 0;
+    float mFloat = 0.0;
+    double mDouble = 0.0;
+    QByteArrayView mBytes;
+    QString mText;
+};
+
+
+
+class BinaryConfigAttributes
+{
+public:
+    BinaryConfigValue value(const char* name) const;
+    bool hasAttribute(const char* name) const;
+
+private:
+    friend class BinaryConfig;
+    friend class BinaryConfigReader;
+
+    const QList<QLatin1StringView>* mNames = nullptr;
+    QList<QPair<int, BinaryConfigValue>> mAttributes;
+};
+
+
+
+// BinaryConfigReader: pull reader over binary configuration data, possibly memory-mapped,
+// offering the part of QXmlStreamReader's interface used by the parsers
+// Names and shaders read from data in place, each shader converted to text only once
+
+class BinaryConfigReader
+{
+public:
+    BinaryConfigReader(const uchar* data, qint64 size);
+    BinaryConfigReader(const BinaryConfigReader& reader, qint64 offset);
+
+    BinaryConfigReader(const BinaryConfigReader&) = delete;
+    BinaryConfigReader& operator=(const BinaryConfigReader&) = delete;
+
+    bool readNextStartElement();
+    void skipCurrentElement();
+
+    QLatin1StringView name() const;
+    const BinaryConfigAttributes& attributes() const;
+    BinaryConfigValue readElementText();
+    QString readShader();
+
+    BinaryConfig::Token readNext();
+    const BinaryConfigValue& text() const;
+
+    qint64 offset() const;
+    bool hasError() const;
+
+private:
+    struct Tables
+    {
+        QList<QLatin1StringView> names;
+        QList<QByteArrayView> shaderSources;
+        QList<QString> shaders;
+    };
+
+    Tables mOwnTables;
+    const Tables* mTables;
+
+    const uchar* mBegin;
+    const uchar* mData;
+    const uchar* mEnd;
+    bool mError = false;
+
+    int mNameIndex = -1;
+    BinaryConfigAttributes mAttributes;
+    BinaryConfigValue mText;
+
+    quint64 readVarint();
+    QByteArrayView readBytes(qint64 size);
+    BinaryConfigValue readValue();
+};
+
+
+
+#endif // BINARYCONFIG_H
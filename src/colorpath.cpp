@@ -2,65 +2,43 @@
 
 
 
-ColorPath::ColorPath(QPoint source, int maxPoints) :
-    source_ { source }
+ColorPath::ColorPath(QPoint source, int region, int capacity) :
+    source_ { source },
+    region_ { region }
 {
-    numPoints = 0;
-
-    if (maxPoints < 2)
-        maxNumPoints = 2;
-    else
-        maxNumPoints = maxPoints;
+    setCapacity(capacity);
 }
 
 
 
-void ColorPath::addPoint(float red, float green, float blue)
+void ColorPath::setCapacity(int capacity)
 {
-    // Line segment
-
-    if (numPoints > 0)
-    {
-        lines_.append(redPoints_.last());
-        lines_.append(greenPoints_.last());
-        lines_.append(bluePoints_.last());
-
-        lines_.append(red);
-        lines_.append(green);
-        lines_.append(blue);
-    }
+    if (capacity < 2)
+        capacity_ = 2;
+    else
+        capacity_ = capacity;
 
-    // RGB Points
+    clear();
+}
 
-    redPoints_.append(red);
-    greenPoints_.append(green);
-    bluePoints_.append(blue);
 
-    numPoints++;
 
-    // Keep number of points within range
+int ColorPath::addPoint()
+{
+    // Advance head, oldest point overwritten once ring is full
 
-    if (numPoints > maxNumPoints)
-    {
-        redPoints_.remove(0, numPoints - maxNumPoints);
-        greenPoints_.remove(0, numPoints - maxNumPoints);
-        bluePoints_.remove(0, numPoints - maxNumPoints);
+    head = (head + 1) % capacity_;
 
-        lines_.remove(0, 6 * (numPoints - maxNumPoints));
+    if (numPoints < capacity_)
+        numPoints++;
 
-        numPoints = maxNumPoints;
-    }
+    return head;
 }
 
 
 
 void ColorPath::clear()
 {
-    redPoints_.clear();
-    greenPoints_.clear();
-    bluePoints_.clear();
-
-    lines_.clear();
-
+    head = -1;
     numPoints = 0;
 }
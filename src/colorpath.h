@@ -3,35 +3,39 @@
 
 
 
-#include <QList>
 #include <QPoint>
 
 
 
+// Bookkeeping of a path history stored as a ring in a region of a GPU buffer.
+// Each point is written twice, at head and head + capacity, so that the last
+// points are always contiguous and drawn with a single range.
+
 class ColorPath
 {
 public:
-    ColorPath(QPoint source, int maxPoints);
+    ColorPath(QPoint source, int region, int capacity);
 
     void setSource(QPoint source) { source_ = source; }
     QPoint source() { return source_; }
 
-    void setMaxNumPoints(int maxPoints) { maxNumPoints = maxPoints; }
+    int region() { return region_; }
+
+    void setCapacity(int capacity);
 
-    void addPoint(float red, float green, float blue);
+    int addPoint();
 
     void clear();
 
-    QList<float> lines() { return lines_; }
-    int linesSize() { return lines_.size(); }
-    bool linesEmpty() { return lines_.isEmpty(); }
+    int first() { return head + capacity_ - numPoints + 1; }
+    int size() { return numPoints; }
 
 private:
     QPoint source_;
-    QList<float> redPoints_, greenPoints_, bluePoints_;
-    QList<float> lines_;
+    int region_;
+    int capacity_;
+    int head = -1;
     int numPoints = 0;
-    int maxNumPoints;
 };
 
 #endif // COLORPATH_H
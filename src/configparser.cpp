@@ -24,8 +24,12 @@
 
 #include "configparser.h"
 #include "operationparser.h"
+#include "binaryconfig.h"
 
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QtConcurrent>
 
 
 
@@ -34,8 +38,11 @@ void ConfigurationParser::write(QString filename)
     QFile outFile(filename);
     if (outFile.open(QIODevice::WriteOnly))
     {
-        QXmlStreamWriter mStream;
-        mStream.setDevice(&outFile);
+        // Binary configurations encoded from XML
+
+        QByteArray xml;
+
+        QXmlStreamWriter mStream(&xml);
         mStream.setAutoFormatting(true);
 
         mStream.writeStartDocument();
@@ -72,6 +79,13 @@ void ConfigurationParser::write(QString filename)
 
         mStream.writeEndDocument();
 
+        if (filename.endsWith(".fosb")) {
+            outFile.write(BinaryConfig::encode(xml));
+        }
+        else {
+            outFile.write(xml);
+        }
+
         outFile.close();
     }
 }
@@ -164,6 +178,37 @@ void ConfigurationParser::writeOperationNode(ImageOperationNode* node, QXmlStrea
 
     opParser.writeOperation(node->operation(), stream, true);
 
+    if (!node->operation()->texFormatInherited())
+    {
+        stream.writeStartElement("texture_format");
+        stream.writeCharacters(QString::number(static_cast<int>(node->operation()->texFormat())));
+        stream.writeEndElement();
+    }
+
+    if (node->operation()->resolutionScale() != 1.0f)
+    {
+        stream.writeStartElement("resolution_scale");
+        stream.writeCharacters(QString::number(node->operation()->resolutionScale()));
+        stream.writeEndElement();
+    }
+
+    if (node->operation()->updateInterval() != 1)
+    {
+        stream.writeStartElement("update_interval");
+        if (node->operation()->updatePhase() >= 0) {
+            stream.writeAttribute("phase", QString::number(node->operation()->updatePhase()));
+        }
+        stream.writeCharacters(QString::number(node->operation()->updateInterval()));
+        stream.writeEndElement();
+    }
+
+    // Written even if 1: midi links refer to its id
+
+    stream.writeStartElement("substeps");
+    stream.writeAttribute("id", node->operation()->substepsNumber()->id().toString());
+    stream.writeCharacters(QString::number(node->operation()->substeps()));
+    stream.writeEndElement();
+
     stream.writeStartElement("inputs");
 
     for (auto [id, inData]: node->inputs().asKeyValueRange())
@@ -180,6 +225,13 @@ void ConfigurationParser::writeOperationNode(ImageOperationNode* node, QXmlStrea
         stream.writeCharacters(QString::number(inData->blendFactor()->value()));
         stream.writeEndElement();
 
+        if (inData->output() != 0)
+        {
+            stream.writeStartElement("output");
+            stream.writeCharacters(QString::number(inData->output()));
+            stream.writeEndElement();
+        }
+
         stream.writeEndElement();
     }
 
@@ -261,78 +313,205 @@ void ConfigurationParser::writeMidiData(QXmlStreamWriter& stream)
 
 
 void ConfigurationParser::read(QString filename)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Configuration configuration;
+
+    if (parse(filename, configuration, thread()))
+    {
+        qint64 parseTime = timer.restart();
+
+        instantiate(configuration);
+
+        qInfo().noquote() << QString("Read %1 nodes: parsed in %2 ms, instantiated in %3 ms").arg(configuration.nodes.size()).arg(parseTime).arg(timer.elapsed());
+    }
+}
+
+
+
+bool ConfigurationParser::parse(QString filename, Configuration& configuration, QThread* thread)
 {
     QFile inFile(filename);
-    if (inFile.open(QIODevice::ReadOnly))
+    if (!inFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray contents;
+
+    uchar* mapped = inFile.map(0, inFile.size());
+
+    if (!mapped) {
+        contents = inFile.readAll();
+    }
+
+    const uchar* data = mapped ? mapped : reinterpret_cast<const uchar*>(contents.constData());
+    qint64 size = mapped ? inFile.size() : contents.size();
+
+    bool success = false;
+
+    if (BinaryConfig::isBinary(data, size))
     {
-        QXmlStreamReader mStream;
-        mStream.setDevice(&inFile);
+        // Binary configurations parsed straight from mapped file, operation nodes later from their token offsets
 
-        OperationParser opParser;
+        BinaryConfigReader stream(data, size);
 
-        if (mStream.readNextStartElement() && mStream.name() == "fosforo")
+        success = readConfiguration(QString(), stream, configuration, thread);
+
+        if (stream.hasError())
         {
-            mFactory->clear();
+            discard(configuration);
+            success = false;
+        }
+    }
+    else
+    {
+        // Whole document as text, operation nodes being parsed later from their offsets
 
-            QUuid outputNodeId;
-            int width = mRenderManager->texWidth();
-            int height = mRenderManager->texHeight();
+        QString text = QString::fromUtf8(reinterpret_cast<const char*>(data), size);
 
-            while (mStream.readNextStartElement())
-            {
-                if (mStream.name() == "nodes")
-                {
-                    QMap<QUuid, QMap<QUuid, InputData*>> connections;
+        QXmlStreamReader stream(text);
 
-                    while (mStream.readNextStartElement())
-                    {
-                        if (mStream.name() == "seed_node") {
-                            readSeedNode(mStream);
-                        }
-                        else if (mStream.name() == "operation_node") {
-                            readOperationNode(connections, mStream);
-                        }
-                        else {
-                            mStream.skipCurrentElement();
-                        }
-                    }
+        success = readConfiguration(text, stream, configuration, thread);
 
-                    mNodeManager->connectOperations(connections);
-                    mNodeManager->sortOperations();
-                }
-                else if (mStream.name() == "display") {
-                    readDisplay(width, height, outputNodeId, mStream);
+        if (stream.tokenType() == QXmlStreamReader::Invalid) {
+            stream.readNext();
+        }
+
+        if (stream.hasError()) {
+            stream.raiseError();
+        }
+    }
+
+    if (mapped) {
+        inFile.unmap(mapped);
+    }
+
+    inFile.close();
+
+    return success;
+}
+
+
+
+template<typename Stream>
+bool ConfigurationParser::readConfiguration(const QString& text, Stream& stream, Configuration& configuration, QThread* thread)
+{
+    if (!stream.readNextStartElement() || stream.name() != "fosforo") {
+        return false;
+    }
+
+    while (stream.readNextStartElement())
+    {
+        if (stream.name() == "nodes") {
+            readNodes(text, stream, configuration, thread);
+        }
+        else if (stream.name() == "display") {
+            readDisplay(configuration, stream);
+        }
+        else if (stream.name() == "midi") {
+            readMidiData(configuration, stream);
+        }
+        else {
+            stream.skipCurrentElement();
+        }
+    }
+
+    return true;
+}
+
+
+
+void ConfigurationParser::instantiate(Configuration& configuration)
+{
+    mFactory->clear();
+
+    // Programs, textures and widgets, in document order; already set up for preloaded operations
+
+    QMap<QUuid, QMap<QUuid, InputData*>> connections;
+
+    foreach (NodeDescription description, configuration.nodes)
+    {
+        if (description.seed)
+        {
+            mFactory->addSeed(description.id, description.seed);
+            mGraphWidget->setNodePosition(description.id, description.position);
+        }
+        else
+        {
+            mFactory->addOperation(description.id, description.operation, description.position);
+            connections.insert(description.id, description.inputs);
+        }
+    }
+
+    mNodeManager->connectOperations(connections);
+    mNodeManager->sortOperations();
+
+    // Ownership passed on
+
+    configuration.nodes.clear();
+
+    if (!configuration.sceneRect.isNull()) {
+        mGraphWidget->fitInView(configuration.sceneRect, Qt::KeepAspectRatio);
+    }
+
+    if (configuration.midiRead)
+    {
+        mMidiLinkManager->clearLinks();
+        mMidiLinkManager->setMultiLink(configuration.multiLink);
+
+        foreach (MidiLinkDescription link, configuration.midiLinks)
+        {
+            if (link.type == "float") {
+                Number<float>* number = mFactory->number<float>(link.numberId);
+                if (number) {
+                    mMidiLinkManager->setupMidiLink(link.map, link.key, number);
                 }
-                else if (mStream.name() == "midi") {
-                    readMidiData(mStream);
+            }
+            else if (link.type == "int") {
+                Number<int>* number = mFactory->number<int>(link.numberId);
+                if (number) {
+                    mMidiLinkManager->setupMidiLink(link.map, link.key, number);
                 }
-                else {
-                    mStream.skipCurrentElement();
+            }
+            else if (link.type == "uint") {
+                Number<unsigned int>* number = mFactory->number<unsigned int>(link.numberId);
+                if (number) {
+                    mMidiLinkManager->setupMidiLink(link.map, link.key, number);
                 }
             }
+        }
+    }
 
-            if (!outputNodeId.isNull()) {
-                mNodeManager->setOutput(outputNodeId);
-            }
+    if (!configuration.outputNodeId.isNull()) {
+        mNodeManager->setOutput(configuration.outputNodeId);
+    }
 
-            emit newImageSizeRead(width, height);
-        }
+    int width = configuration.width > 0 ? configuration.width : mRenderManager->texWidth();
+    int height = configuration.height > 0 ? configuration.height : mRenderManager->texHeight();
 
-        if (mStream.tokenType() == QXmlStreamReader::Invalid) {
-            mStream.readNext();
-        }
+    emit newImageSizeRead(width, height);
+}
 
-        if (mStream.hasError()) {
-            mStream.raiseError();
-        }
 
-        inFile.close();
+
+void ConfigurationParser::discard(Configuration& configuration)
+{
+    foreach (NodeDescription description, configuration.nodes)
+    {
+        delete description.seed;
+        delete description.operation;
+        qDeleteAll(description.inputs);
     }
+
+    configuration.nodes.clear();
 }
 
 
 
-void ConfigurationParser::readDisplay(int &width, int &height, QUuid &outputNodeId, QXmlStreamReader& stream)
+template<typename Stream>
+void ConfigurationParser::readDisplay(Configuration& configuration, Stream& stream)
 {
     while (stream.readNextStartElement())
     {
@@ -341,10 +520,10 @@ void ConfigurationParser::readDisplay(int &width, int &height, QUuid &outputNode
             while (stream.readNextStartElement())
             {
                 if (stream.name() == "width") {
-                    width = stream.readElementText().toInt();
+                    configuration.width = stream.readElementText().toInt();
                 }
                 else if (stream.name() == "height") {
-                    height = stream.readElementText().toInt();
+                    configuration.height = stream.readElementText().toInt();
                 }
                 else {
                     stream.skipCurrentElement();
@@ -374,28 +553,116 @@ void ConfigurationParser::readDisplay(int &width, int &height, QUuid &outputNode
                 }
             }
 
-            mGraphWidget->fitInView(sceneRect, Qt::KeepAspectRatio);
+            configuration.sceneRect = sceneRect;
+        }
+        else if (stream.name() == "output_node")
+        {
+            QString outputNodeId = stream.readElementText();
+            configuration.outputNodeId = QUuid(outputNodeId);
+        }
+        else {
+            stream.skipCurrentElement();
+        }
+    }
+}
+
+
+
+void ConfigurationParser::readNodes(const QString& text, QXmlStreamReader& stream, Configuration& configuration, QThread* thread)
+{
+    // Seeds read in place, operation nodes only located
+
+    QList<NodeDescription>& descriptions = configuration.nodes;
+
+    while (stream.readNextStartElement())
+    {
+        if (stream.name() == "seed_node") {
+            descriptions.append(readSeedNode(stream));
+        }
+        else if (stream.name() == "operation_node")
+        {
+            NodeDescription description;
+            description.id = QUuid(stream.attributes().value("id").toString());
+            description.start = stream.characterOffset();
+
+            stream.skipCurrentElement();
+
+            description.end = qMax(description.start, text.lastIndexOf('<', stream.characterOffset() - 1));
+
+            descriptions.append(description);
+        }
+        else {
+            stream.skipCurrentElement();
+        }
+    }
+
+    // One task per operation node on the global thread pool, no GL or widgets involved
+
+    QtConcurrent::blockingMap(descriptions, [&text, thread](NodeDescription& description) {
+        if (!description.seed)
+        {
+            QXmlStreamReader nodeStream("<operation_node>" + QStringView(text).sliced(description.start, description.end - description.start).toString() + "</operation_node>");
+            nodeStream.readNextStartElement();
+
+            readOperationNode(description, nodeStream, thread);
         }
-        else if (stream.name() == "output_node") {
-            outputNodeId = QUuid(stream.readElementText());
+    });
+}
+
+
+
+void ConfigurationParser::readNodes(const QString& text, BinaryConfigReader& stream, Configuration& configuration, QThread* thread)
+{
+    Q_UNUSED(text)
+
+    // Seeds read in place, operation nodes only located by their offsets in token stream
+
+    QList<NodeDescription>& descriptions = configuration.nodes;
+
+    while (stream.readNextStartElement())
+    {
+        if (stream.name() == "seed_node") {
+            descriptions.append(readSeedNode(stream));
+        }
+        else if (stream.name() == "operation_node")
+        {
+            NodeDescription description;
+            description.id = QUuid(stream.attributes().value("id").toString());
+            description.start = stream.offset();
+
+            stream.skipCurrentElement();
+
+            description.end = stream.offset();
+
+            descriptions.append(description);
         }
         else {
             stream.skipCurrentElement();
         }
     }
+
+    // One task per operation node on the global thread pool, each reading from its offset with tables shared
+
+    QtConcurrent::blockingMap(descriptions, [&stream, thread](NodeDescription& description) {
+        if (!description.seed)
+        {
+            BinaryConfigReader nodeStream(stream, description.start);
+            readOperationNode(description, nodeStream, thread);
+        }
+    });
 }
 
 
 
-void ConfigurationParser::readSeedNode(QXmlStreamReader& stream)
+template<typename Stream>
+NodeDescription ConfigurationParser::readSeedNode(Stream& stream)
 {
-    QUuid id = QUuid(stream.attributes().value("id").toString());
+    NodeDescription description;
+    description.id = QUuid(stream.attributes().value("id").toString());
+
     int type = 0;
     bool fixed = false;
     QString imageFilename;
-    QPointF position(0.0, 0.0);
-
-    OperationParser opParser;
 
     while (stream.readNextStartElement())
     {
@@ -413,10 +680,10 @@ void ConfigurationParser::readSeedNode(QXmlStreamReader& stream)
             while (stream.readNextStartElement())
             {
                 if (stream.name() == "x") {
-                    position.setX(stream.readElementText().toFloat());
+                    description.position.setX(stream.readElementText().toFloat());
                 }
                 else if (stream.name() == "y") {
-                    position.setY(stream.readElementText().toFloat());
+                    description.position.setY(stream.readElementText().toFloat());
                 }
                 else {
                     stream.skipCurrentElement();
@@ -428,19 +695,17 @@ void ConfigurationParser::readSeedNode(QXmlStreamReader& stream)
         }
     }
 
-    Seed* seed = new Seed(type, fixed, imageFilename);
-    mFactory->addSeed(id, seed);
-    mGraphWidget->setNodePosition(id, position);
+    description.seed = new Seed(type, fixed, imageFilename);
+
+    return description;
 }
 
 
 
-void ConfigurationParser::readOperationNode(QMap<QUuid, QMap<QUuid, InputData*>> &connections, QXmlStreamReader& stream)
+template<typename Stream>
+void ConfigurationParser::readOperationNode(NodeDescription& description, Stream& stream, QThread* thread)
 {
-    QUuid id = QUuid(stream.attributes().value("id").toString());
     ImageOperation* operation = new ImageOperation();
-    QMap<QUuid, InputData*> inputs;
-    QPointF position(0.0, 0.0);
 
     OperationParser opParser;
 
@@ -449,6 +714,31 @@ void ConfigurationParser::readOperationNode(QMap<QUuid, QMap<QUuid, InputData*>>
         if (stream.name() == "operation") {
             opParser.readOperation(operation, stream, true);
         }
+        else if (stream.name() == "texture_format")
+        {
+            // Unknown formats ignored: global one inherited
+
+            int format = stream.readElementText().toInt();
+
+            if (isTextureFormat(format))
+            {
+                operation->setTexFormatInherited(false);
+                operation->setTexFormat(static_cast<TextureFormat>(format));
+            }
+        }
+        else if (stream.name() == "resolution_scale") {
+            operation->setResolutionScale(stream.readElementText().toFloat());
+        }
+        else if (stream.name() == "update_interval")
+        {
+            int phase = stream.attributes().hasAttribute("phase") ? stream.attributes().value("phase").toInt() : -1;
+            operation->setUpdateInterval(stream.readElementText().toInt(), phase);
+        }
+        else if (stream.name() == "substeps")
+        {
+            QUuid id = QUuid(stream.attributes().value("id").toString());
+            operation->setSubsteps(id, stream.readElementText().toInt());
+        }
         else if (stream.name() == "inputs")
         {
             while (stream.readNextStartElement())
@@ -458,6 +748,7 @@ void ConfigurationParser::readOperationNode(QMap<QUuid, QMap<QUuid, InputData*>>
                     QUuid srcId = QUuid(stream.attributes().value("id").toString());
                     InputType type = InputType::Normal;
                     float blendFactor = 1.0;
+                    int output = 0;
 
                     while (stream.readNextStartElement())
                     {
@@ -467,80 +758,72 @@ void ConfigurationParser::readOperationNode(QMap<QUuid, QMap<QUuid, InputData*>>
                         else if (stream.name() == "blendfactor") {
                             blendFactor = stream.readElementText().toFloat();
                         }
+                        else if (stream.name() == "output") {
+                            output = stream.readElementText().toInt();
+                        }
                         else {
                             stream.skipCurrentElement();
                         }
                     }
 
-                    inputs.insert(srcId, new InputData(type, nullptr, blendFactor));
+                    InputData* inData = new InputData(type, nullptr, blendFactor, output);
+                    inData->blendFactor()->moveToThread(thread);
+
+                    description.inputs.insert(srcId, inData);
                 }
             }
-
-            connections.insert(id, inputs);
         }
         else if (stream.name() == "position")
         {
             while (stream.readNextStartElement())
             {
                 if (stream.name() == "x") {
-                    position.setX(stream.readElementText().toFloat());
+                    description.position.setX(stream.readElementText().toFloat());
                 }
                 else if (stream.name() == "y") {
-                    position.setY(stream.readElementText().toFloat());
+                    description.position.setY(stream.readElementText().toFloat());
                 }
                 else {
                     stream.skipCurrentElement();
                 }
             }
         }
+        else {
+            stream.skipCurrentElement();
+        }
     }
 
-    mFactory->addOperation(id, operation, position);
+    operation->moveParametersToThread(thread);
+
+    description.operation = operation;
 }
 
 
 
-void ConfigurationParser::readMidiData(QXmlStreamReader& stream)
+template<typename Stream>
+void ConfigurationParser::readMidiData(Configuration& configuration, Stream& stream)
 {
-    mMidiLinkManager->clearLinks();
+    configuration.midiRead = true;
 
     while (stream.readNextStartElement())
     {
         if (stream.name() == "links")
         {
-            bool multiLink = false;
             if (stream.attributes().hasAttribute("multi_link")) {
-                multiLink = stream.attributes().value("multi_link").toInt();
+                configuration.multiLink = stream.attributes().value("multi_link").toInt();
             }
-            mMidiLinkManager->setMultiLink(multiLink);
 
             stream.readNextStartElement();
 
             while (stream.name() == "link")
             {
-                QString type = stream.attributes().value("type").toString();
-                int map = stream.attributes().value("map").toInt();
-                int key = stream.attributes().value("key").toInt();
-                QUuid number_id = QUuid(stream.attributes().value("number_id").toString());
-
-                if (type == "float") {
-                    Number<float>* number = mFactory->number<float>(number_id);
-                    if (number) {
-                        mMidiLinkManager->setupMidiLink(map, key, number);
-                    }
-                }
-                else if (type == "int") {
-                    Number<int>* number = mFactory->number<int>(number_id);
-                    if (number) {
-                        mMidiLinkManager->setupMidiLink(map, key, number);
-                    }
-                }
-                else if (type == "uint") {
-                    Number<unsigned int>* number = mFactory->number<unsigned int>(number_id);
-                    if (number) {
-                        mMidiLinkManager->setupMidiLink(map, key, number);
-                    }
-                }
+                MidiLinkDescription link;
+                link.type = stream.attributes().value("type").toString();
+                link.map = stream.attributes().value("map").toInt();
+                link.key = stream.attributes().value("key").toInt();
+                link.numberId = QUuid(stream.attributes().value("number_id").toString());
+
+                configuration.midiLinks.append(link);
 
                 stream.readNextStartElement();
             }
@@ -29,14 +29,64 @@
 #include "rendermanager.h"
 #include "graphwidget.h"
 #include "midilinkmanager.h"
+#include "binaryconfig.h"
 
 #include <QObject>
+#include <QPointF>
+#include <QRectF>
 #include <QString>
+#include <QThread>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 
 
 
+// Node as read from configuration, before its operation or seed is instantiated
+
+struct NodeDescription
+{
+    QUuid id;
+    Seed* seed = nullptr;
+    ImageOperation* operation = nullptr;
+    QMap<QUuid, InputData*> inputs;
+    QPointF position;
+
+    // Operation node contents, as offsets into document text or binary token stream
+
+    qsizetype start = 0;
+    qsizetype end = 0;
+};
+
+
+
+struct MidiLinkDescription
+{
+    QString type;
+    int map = 0;
+    int key = 0;
+    QUuid numberId;
+};
+
+
+
+// Configuration as read from file: instantiated at once, or kept preloaded until then
+
+struct Configuration
+{
+    int width = 0;
+    int height = 0;
+    QRectF sceneRect;
+    QUuid outputNodeId;
+
+    QList<NodeDescription> nodes;
+
+    bool midiRead = false;
+    bool multiLink = false;
+    QList<MidiLinkDescription> midiLinks;
+};
+
+
+
 class ConfigurationParser: public QObject
 {
     Q_OBJECT
@@ -50,6 +100,12 @@ public:
     mMidiLinkManager { midiLinkManager }
     {}
 
+    // Parse touches no GL nor widgets, and may run on any thread: parameters handed over to given one
+
+    static bool parse(QString filename, Configuration& configuration, QThread* thread);
+    void instantiate(Configuration& configuration);
+    static void discard(Configuration& configuration);
+
 signals:
     void newImageSizeRead(int width, int height);
 
@@ -69,8 +125,18 @@ private:
     void writeOperationNode(ImageOperationNode* node, QXmlStreamWriter& stream);
     void writeMidiData(QXmlStreamWriter& stream);
 
-    void readDisplay(int& width, int& height, QUuid &outputNodeId, QXmlStreamReader& stream);
-    void readSeedNode(QXmlStreamReader& stream);
-    void readOperationNode(QMap<QUuid, QMap<QUuid, InputData*>>& connections, QXmlStreamReader& stream);
-    void readMidiData(QXmlStreamReader& stream);
+    // Readers take either a QXmlStreamReader or a BinaryConfigReader
+
+    template<typename Stream>
+    static bool readConfiguration(const QString& text, Stream& stream, Configuration& configuration, QThread* thread);
+    template<typename Stream>
+    static void readDisplay(Configuration& configuration, Stream& stream);
+    static void readNodes(const QString& text, QXmlStreamReader& stream, Configuration& configuration, QThread* thread);
+    static void readNodes(const QString& text, BinaryConfigReader& stream, Configuration& configuration, QThread* thread);
+    template<typename Stream>
+    static NodeDescription readSeedNode(Stream& stream);
+    template<typename Stream>
+    static void readOperationNode(NodeDescription& description, Stream& stream, QThread* thread);
+    template<typename Stream>
+    static void readMidiData(Configuration& configuration, Stream& stream);
 };
@@ -109,10 +109,12 @@ ControlWidget::ControlWidget(QString version, GraphWidget* graphWidget, MidiList
     iterationNumberLabel = new QLabel("Frame: 0");
     iterationFPSLabel = new QLabel("FPS: 0");
     timePerIterationLabel = new QLabel("mSPF: 0");
+    convergenceLabel = new QLabel("");
 
     statusBar->insertWidget(0, iterationNumberLabel, 1);
     statusBar->insertWidget(1, iterationFPSLabel, 1);
     statusBar->insertWidget(2, timePerIterationLabel, 1);
+    statusBar->insertWidget(3, convergenceLabel, 1);
 
     // Main layout
 
@@ -212,6 +214,8 @@ void ControlWidget::constructSystemToolBar()
 
     QAction* plotsAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/development-gtk.png")), "RGB Plot");
 
+    QAction* histogramAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/office-chart-area-stacked.png")), "Histogram");
+
     // systemToolBar->addSeparator();
 
     QAction* overlayAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/align-horizontal-left.png")), "Overlay (CTRL+O)");
@@ -226,6 +230,45 @@ void ControlWidget::constructSystemToolBar()
     loadConfigAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/document-open.png")), "Load configuration");
     saveConfigAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/document-save.png")), "Save configuration");
 
+    // Preset bank: configurations preloaded to switch to instantly
+
+    presetBankMenu = new QMenu("Preset bank", this);
+
+    QAction* preloadAction = presetBankMenu->addAction("Preload configurations...");
+    QAction* carryOverAction = presetBankMenu->addAction("Carry over output");
+    carryOverAction->setCheckable(true);
+    QAction* clearBankAction = presetBankMenu->addAction("Clear bank");
+
+    // Bank size: one preset per Ctrl+number key at most
+
+    QMenu* capacityMenu = presetBankMenu->addMenu("Bank size");
+    QActionGroup* capacityGroup = new QActionGroup(capacityMenu);
+
+    for (int capacity = 1; capacity <= 9; capacity++)
+    {
+        QAction* capacityAction = capacityMenu->addAction(QString::number(capacity));
+        capacityAction->setCheckable(true);
+        capacityAction->setChecked(capacity == 8);
+        capacityGroup->addAction(capacityAction);
+
+        connect(capacityAction, &QAction::triggered, this, [=, this]() {
+            emit presetBankCapacityChanged(capacity);
+        });
+    }
+
+    presetBankMenu->addSeparator();
+
+    QAction* presetBankAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/bookmark.png")), "Preset bank");
+    presetBankAction->setMenu(presetBankMenu);
+
+    if (QToolButton* presetBankButton = qobject_cast<QToolButton*>(systemToolBar->widgetForAction(presetBankAction))) {
+        presetBankButton->setPopupMode(QToolButton::InstantPopup);
+    }
+
+    connect(preloadAction, &QAction::triggered, this, &ControlWidget::preloadPresets);
+    connect(carryOverAction, &QAction::toggled, this, &ControlWidget::presetCarryOverToggled);
+    connect(clearBankAction, &QAction::triggered, this, &ControlWidget::clearPresetBank);
+
     QAction* optionsAction = systemToolBar->addAction(QIcon(QPixmap(":/icons/applications-system.png")), "Options");
 
     // systemToolBar->addSeparator();
@@ -238,6 +281,7 @@ void ControlWidget::constructSystemToolBar()
     connect(recordAction, &QAction::triggered, this, &ControlWidget::record);
     connect(optionsAction, &QAction::triggered, optionsWidget, &QTabWidget::show);
     connect(plotsAction, &QAction::triggered, this, &ControlWidget::showPlotsWidget);
+    connect(histogramAction, &QAction::triggered, this, &ControlWidget::showHistogramWidget);
     connect(overlayAction, &QAction::triggered, this, &ControlWidget::toggleOverlay);
     connect(fullScreenAction, &QAction::triggered, this, &ControlWidget::fullScreenToggled);
     connect(loadConfigAction, &QAction::triggered, this, &ControlWidget::loadConfig);
@@ -301,6 +345,26 @@ void ControlWidget::toggleRecording()
 }
 
 
+
+void ControlWidget::still()
+{
+    QString filename = QDir::toNativeSeparators(outputDir + '/' + QDateTime::currentDateTime().toString("[yyyy-MM-dd][hh'h'mm'm'ss's'zzz'ms']") + ".ppm");
+    emit renderStill(filename, stillWidth, stillHeight, stillIterations, stillTileSize);
+}
+
+
+
+void ControlWidget::stillRendered(bool success, QString message)
+{
+    if (success) {
+        QMessageBox::information(this, "Render still", message);
+    }
+    else {
+        QMessageBox::warning(this, "Render still", message);
+    }
+}
+
+
 /*void ControlWidget::toggleSortedOperationWidget()
 {
     sortedOperationWidget->setVisible(!sortedOperationWidget->isVisible());
@@ -326,7 +390,7 @@ void ControlWidget::toggleFullScreenAction(bool checked)
 
 void ControlWidget::loadConfig()
 {
-    QString filename = QFileDialog::getOpenFileName(this, "Load configuration", QDir::currentPath() + "/configs", "Fosforo configurations (*.fos)");
+    QString filename = QFileDialog::getOpenFileName(this, "Load configuration", QDir::currentPath() + "/configs", "Fosforo configurations (*.fos *.fosb)");
 
     if (!filename.isEmpty())
     {
@@ -340,9 +404,41 @@ void ControlWidget::loadConfig()
 
 
 
+void ControlWidget::preloadPresets()
+{
+    QStringList filenames = QFileDialog::getOpenFileNames(this, "Preload configurations", QDir::currentPath() + "/configs", "Fosforo configurations (*.fos *.fosb)");
+
+    foreach (QString filename, filenames) {
+        emit preloadPreset(filename);
+    }
+}
+
+
+
+void ControlWidget::populatePresetBankMenu(QStringList names)
+{
+    qDeleteAll(presetActions);
+    presetActions.clear();
+
+    for (int index = 0; index < names.size(); index++)
+    {
+        // Presets numbered as their Ctrl+number keys in output window
+
+        QAction* action = presetBankMenu->addAction(QString("%1. %2").arg(index + 1).arg(names[index]));
+
+        connect(action, &QAction::triggered, this, [=, this]() {
+            emit activatePreset(index);
+        });
+
+        presetActions.append(action);
+    }
+}
+
+
+
 void ControlWidget::saveConfig()
 {
-    QString filename = QFileDialog::getSaveFileName(this, "Save configuration", QDir::currentPath() + "/configs", "Fosforo configurations (*.fos)");
+    QString filename = QFileDialog::getSaveFileName(this, "Save configuration", QDir::currentPath() + "/configs", "Fosforo configurations (*.fos);;Fosforo binary configurations (*.fosb)");
 
     if (!filename.isEmpty()) {
         emit writeConfig(filename);
@@ -404,6 +500,44 @@ void ControlWidget::updateIterationMetricsLabels(double mSpf, double fps)
 
 
 
+void ControlWidget::setConvergenceAction(ConvergenceAction action)
+{
+    convergenceActionComboBox->setCurrentIndex(convergenceActionComboBox->findData(QVariant(static_cast<int>(action))));
+
+    convergenceCheckBox->setChecked(true);
+    emit convergenceDetectionToggled(true);
+}
+
+
+
+void ControlWidget::updateConvergence(int period)
+{
+    if (period == 0) {
+        convergenceLabel->setText("");
+        return;
+    }
+    else if (period == 1) {
+        convergenceLabel->setText("Fixed point");
+    }
+    else {
+        convergenceLabel->setText(QString("Cycle: %1").arg(period));
+    }
+
+    ConvergenceAction action = static_cast<ConvergenceAction>(convergenceActionComboBox->currentData().toInt());
+
+    if (action == ConvergenceAction::Stop && iterateAction->isChecked()) {
+        iterateAction->setChecked(false);
+    }
+    else if (action == ConvergenceAction::Reseed) {
+        emit resetIterations();
+    }
+    else if (action == ConvergenceAction::NextPreset) {
+        emit activateNextPreset();
+    }
+}
+
+
+
 void ControlWidget::updateWindowSizeLineEdits(int width, int height)
 {
     windowWidthLineEdit->setText(QString::number(width));
@@ -634,16 +768,57 @@ void ControlWidget::constructDisplayOptionsWidget()
     autoResizeCheckBox->setCheckable(true);
     autoResizeCheckBox->setChecked(false);
 
+    QCheckBox* adaptiveResolutionCheckBox = new QCheckBox;
+    adaptiveResolutionCheckBox->setCheckable(true);
+    adaptiveResolutionCheckBox->setChecked(false);
+
     texFormatComboBox = new QComboBox;
     texFormatComboBox->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
 
+    QComboBox* iterationsPerFrameComboBox = new QComboBox;
+    iterationsPerFrameComboBox->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    foreach (int iterations, QList<int>({ 1, 2, 4, 8, 16, 32, 64, 128, 256 })) {
+        iterationsPerFrameComboBox->addItem(QString::number(iterations), QVariant(iterations));
+    }
+    iterationsPerFrameComboBox->addItem("Fit to frame budget", QVariant(0));
+
+    QCheckBox* incrementalRenderCheckBox = new QCheckBox;
+    incrementalRenderCheckBox->setCheckable(true);
+    incrementalRenderCheckBox->setChecked(true);
+
+    QCheckBox* lutBakingCheckBox = new QCheckBox;
+    lutBakingCheckBox->setCheckable(true);
+    lutBakingCheckBox->setChecked(false);
+
+    QCheckBox* regionRenderingCheckBox = new QCheckBox;
+    regionRenderingCheckBox->setCheckable(true);
+    regionRenderingCheckBox->setChecked(true);
+
+    convergenceCheckBox = new QCheckBox;
+    convergenceCheckBox->setCheckable(true);
+    convergenceCheckBox->setChecked(false);
+
+    convergenceActionComboBox = new QComboBox;
+    convergenceActionComboBox->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    convergenceActionComboBox->addItem("Report", QVariant(static_cast<int>(ConvergenceAction::None)));
+    convergenceActionComboBox->addItem("Stop", QVariant(static_cast<int>(ConvergenceAction::Stop)));
+    convergenceActionComboBox->addItem("Reseed", QVariant(static_cast<int>(ConvergenceAction::Reseed)));
+    convergenceActionComboBox->addItem("Next preset", QVariant(static_cast<int>(ConvergenceAction::NextPreset)));
+
     QFormLayout* formLayout = new QFormLayout;
     formLayout->setFormAlignment(Qt::AlignCenter);
     formLayout->addRow("FPS:", fpsLineEdit);
     formLayout->addRow("Image width (px):", windowWidthLineEdit);
     formLayout->addRow("Image height (px):", windowHeightLineEdit);
     formLayout->addRow("Auto-resize window:", autoResizeCheckBox);
+    formLayout->addRow("Adaptive resolution:", adaptiveResolutionCheckBox);
     formLayout->addRow("Format:", texFormatComboBox);
+    formLayout->addRow("Iterations per frame:", iterationsPerFrameComboBox);
+    formLayout->addRow("Skip unchanged operations:", incrementalRenderCheckBox);
+    formLayout->addRow("Bake colour chains:", lutBakingCheckBox);
+    formLayout->addRow("Skip pixels outside masks:", regionRenderingCheckBox);
+    formLayout->addRow("Detect convergence:", convergenceCheckBox);
+    formLayout->addRow("On convergence:", convergenceActionComboBox);
 
     displayOptionsWidget = new QWidget;
     displayOptionsWidget->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
@@ -665,6 +840,20 @@ void ControlWidget::constructDisplayOptionsWidget()
 
     connect(autoResizeCheckBox, &QCheckBox::clicked, this, &ControlWidget::autoResizeWindow);
 
+    connect(adaptiveResolutionCheckBox, &QCheckBox::clicked, this, &ControlWidget::adaptiveResolutionToggled);
+
+    connect(iterationsPerFrameComboBox, &QComboBox::activated, this, [=, this](int index) {
+        emit iterationsPerFrameChanged(iterationsPerFrameComboBox->itemData(index).toInt());
+    });
+
+    connect(incrementalRenderCheckBox, &QCheckBox::clicked, this, &ControlWidget::incrementalRenderToggled);
+
+    connect(lutBakingCheckBox, &QCheckBox::clicked, this, &ControlWidget::lutBakingToggled);
+
+    connect(regionRenderingCheckBox, &QCheckBox::clicked, this, &ControlWidget::regionRenderingToggled);
+
+    connect(convergenceCheckBox, &QCheckBox::clicked, this, &ControlWidget::convergenceDetectionToggled);
+
     connect(texFormatComboBox, &QComboBox::activated, this, [&](int index) {
         int selectedValue = texFormatComboBox->itemData(index).toInt();
         TextureFormat selectedFormat = static_cast<TextureFormat>(selectedValue);
@@ -674,32 +863,6 @@ void ControlWidget::constructDisplayOptionsWidget()
 
 
 
-QString ControlWidget::textureFormatToString(TextureFormat format) {
-    switch (format)
-    {
-        case TextureFormat::RGBA2: return "RGBA2";
-        case TextureFormat::RGBA4: return "RGBA4";
-        case TextureFormat::RGBA8: return "RGBA8";
-        //case TextureFormat::RGBA8_SNORM: return "RGBA8_SNORM";
-        //case TextureFormat::RGB10_A2: return "RGB10_A2";
-        //case TextureFormat::RGB10_A2UI: return "RGB10_A2";
-        case TextureFormat::RGBA12: return "RGBA12";
-        //case TextureFormat::SRGB8_ALPHA8: return "SRGB8_ALPHA8";
-        case TextureFormat::RGBA16: return "RGBA16";
-        case TextureFormat::RGBA16F: return "RGBA16F";
-        case TextureFormat::RGBA32F: return "RGBA32F";
-        //case TextureFormat::RGBA8I: return "RGBA8I";
-        //case TextureFormat::RGBA8UI: return "RGBA8UI";
-        //case TextureFormat::RGBA16I: return "RGBA16I";
-        //case TextureFormat::RGBA16UI: return "RGBA16UI";
-        //case TextureFormat::RGBA32I: return "RGBA32I";
-        //case TextureFormat::RGBA32UI: return "RGBA32UI";
-        default: return "Unknown";
-    }
-}
-
-
-
 void ControlWidget::populateTexFormatComboBox(QList<TextureFormat> formats)
 {
     int index = 0;
@@ -745,6 +908,39 @@ void ControlWidget::constructRecordingOptionsWidget()
     videoCaptureElapsedTimeLabel = new QLabel("00:00:00.000");
     videoCaptureElapsedTimeLabel->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
 
+    // Tiled still
+
+    FocusLineEdit* stillWidthLineEdit = new FocusLineEdit;
+    stillWidthLineEdit->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    QIntValidator* stillWidthValidator = new QIntValidator(1, 65536, stillWidthLineEdit);
+    stillWidthValidator->setLocale(QLocale::English);
+    stillWidthLineEdit->setValidator(stillWidthValidator);
+    stillWidthLineEdit->setText(QString::number(stillWidth));
+
+    FocusLineEdit* stillHeightLineEdit = new FocusLineEdit;
+    stillHeightLineEdit->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    QIntValidator* stillHeightValidator = new QIntValidator(1, 65536, stillHeightLineEdit);
+    stillHeightValidator->setLocale(QLocale::English);
+    stillHeightLineEdit->setValidator(stillHeightValidator);
+    stillHeightLineEdit->setText(QString::number(stillHeight));
+
+    FocusLineEdit* stillIterationsLineEdit = new FocusLineEdit;
+    stillIterationsLineEdit->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    QIntValidator* stillIterationsValidator = new QIntValidator(0, 1000, stillIterationsLineEdit);
+    stillIterationsValidator->setLocale(QLocale::English);
+    stillIterationsLineEdit->setValidator(stillIterationsValidator);
+    stillIterationsLineEdit->setText(QString::number(stillIterations));
+
+    FocusLineEdit* stillTileSizeLineEdit = new FocusLineEdit;
+    stillTileSizeLineEdit->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Preferred);
+    QIntValidator* stillTileSizeValidator = new QIntValidator(64, 32768, stillTileSizeLineEdit);
+    stillTileSizeValidator->setLocale(QLocale::English);
+    stillTileSizeLineEdit->setValidator(stillTileSizeValidator);
+    stillTileSizeLineEdit->setText(QString::number(stillTileSize));
+
+    QPushButton* stillButton = new QPushButton(QIcon(QPixmap(":/icons/digikam.png")), "");
+    stillButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+
     QFormLayout* formLayout = new QFormLayout;
     formLayout->setFormAlignment(Qt::AlignCenter);
     formLayout->addRow("Output dir:", outputDirButton);
@@ -754,6 +950,11 @@ void ControlWidget::constructRecordingOptionsWidget()
     formLayout->addRow("YUV420P:", yuv402pCheckBox);
     formLayout->addRow("FPS:", fpsVideoLineEdit);
     formLayout->addRow("Elapsed time:", videoCaptureElapsedTimeLabel);
+    formLayout->addRow("Still width (px):", stillWidthLineEdit);
+    formLayout->addRow("Still height (px):", stillHeightLineEdit);
+    formLayout->addRow("Still final iterations:", stillIterationsLineEdit);
+    formLayout->addRow("Still tile size (px):", stillTileSizeLineEdit);
+    formLayout->addRow("Render still:", stillButton);
 
     recordingOptionsWidget = new QWidget;
     recordingOptionsWidget->setLayout(formLayout);
@@ -789,6 +990,19 @@ void ControlWidget::constructRecordingOptionsWidget()
     connect(fpsVideoLineEdit, &FocusLineEdit::editingFinished, this, [=, this]() {
         framesPerSecond = fpsVideoLineEdit->text().toInt();
     });
+    connect(stillWidthLineEdit, &FocusLineEdit::editingFinished, this, [=, this]() {
+        stillWidth = stillWidthLineEdit->text().toInt();
+    });
+    connect(stillHeightLineEdit, &FocusLineEdit::editingFinished, this, [=, this]() {
+        stillHeight = stillHeightLineEdit->text().toInt();
+    });
+    connect(stillIterationsLineEdit, &FocusLineEdit::editingFinished, this, [=, this]() {
+        stillIterations = stillIterationsLineEdit->text().toInt();
+    });
+    connect(stillTileSizeLineEdit, &FocusLineEdit::editingFinished, this, [=, this]() {
+        stillTileSize = stillTileSizeLineEdit->text().toInt();
+    });
+    connect(stillButton, &QPushButton::clicked, this, &ControlWidget::still);
 }
 
 
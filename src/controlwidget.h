@@ -34,6 +34,9 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QToolBar>
+#include <QToolButton>
+#include <QMenu>
+#include <QActionGroup>
 #include <QAction>
 #include <QIcon>
 #include <QPixmap>
@@ -66,6 +69,18 @@
 
 
 
+// Action taken when output converges to a fixed point or cycle
+
+enum class ConvergenceAction
+{
+    None,
+    Stop,
+    Reseed,
+    NextPreset
+};
+
+
+
 // ControlWidget: contains Fosforo's controls
 
 class ControlWidget : public QWidget
@@ -84,6 +99,7 @@ signals:
     void seedDrawn();
 
     void showPlotsWidget();
+    void showHistogramWidget();
 
     void overlayToggled(bool show);
     void fullScreenToggled(bool checked);
@@ -91,12 +107,19 @@ signals:
     void imageSizeChanged(int width, int height);
 
     void autoResizeWindow(bool checked);
+    void adaptiveResolutionToggled(bool checked);
+    void iterationsPerFrameChanged(int iterations);
+    void incrementalRenderToggled(bool checked);
+    void lutBakingToggled(bool checked);
+    void regionRenderingToggled(bool checked);
+    void convergenceDetectionToggled(bool checked);
 
     void texFormatChanged(TextureFormat format);
 
     void startRecording(QString recordFilename, int framesPerSecond, QMediaRecorder::Quality quality, QMediaFormat format, bool yuv420p);
     void stopRecording();
     void takeScreenshot(QString filename);
+    void renderStill(QString filename, int width, int height, int iterations, int tileSize);
 
     void iterationFPSChanged(double newFPS);
 
@@ -104,6 +127,13 @@ signals:
     void readConfig(QString filename);
     void writeConfig(QString filename);
 
+    void preloadPreset(QString filename);
+    void activatePreset(int index);
+    void activateNextPreset();
+    void presetCarryOverToggled(bool checked);
+    void presetBankCapacityChanged(int capacity);
+    void clearPresetBank();
+
     void nodesSelected(QList<QUuid> nodeIds);
 
     void closing();
@@ -126,10 +156,17 @@ public slots:
     void screenshot();
     void toggleRecording();
 
+    void stillRendered(bool success, QString message);
+
     void toggleFullScreenAction(bool checked);
 
     void toggleIterationState();
 
+    void setConvergenceAction(ConvergenceAction action);
+    void updateConvergence(int period);
+
+    void populatePresetBankMenu(QStringList names);
+
 protected:
     //void resizeEvent(QResizeEvent* event) override;
     void closeEvent(QCloseEvent* event) override;
@@ -157,6 +194,8 @@ private:
     QAction* fullScreenAction;
     QAction* saveConfigAction;
     QAction* loadConfigAction;
+    QMenu* presetBankMenu;
+    QList<QAction*> presetActions;
 
     int framesPerSecond = 60;
     QString outputDir;
@@ -168,6 +207,11 @@ private:
     QComboBox* videoCodecsComboBox;
     bool yuv420p = false;
 
+    int stillWidth = 16384;
+    int stillHeight = 16384;
+    int stillIterations = 10;
+    int stillTileSize = 4096;
+
     QStatusBar* statusBar;
 
     QLabel* iterationNumberLabel;
@@ -179,6 +223,10 @@ private:
 
     QComboBox* texFormatComboBox;
 
+    QCheckBox* convergenceCheckBox;
+    QComboBox* convergenceActionComboBox;
+    QLabel* convergenceLabel;
+
     QLabel* videoCaptureElapsedTimeLabel;
 
     QMap<QUuid, OperationWidget*> operationsWidgets;
@@ -189,7 +237,6 @@ private:
     void constructOptionsWidget(MidiListWidget* midiOptionsWidget);
     void constructSystemToolBar();
 
-    QString textureFormatToString(TextureFormat format);
 
     void populateFileFormatsComboBox(QMediaFormat::FileFormat fileFormat);
     void populateVideoCodecsComboBox(QMediaFormat::VideoCodec videoCodec);
@@ -197,9 +244,11 @@ private:
 private slots:
     void iterate(bool checked);
     void setOutputDir();
+    void still();
     void record(bool checked);
     void loadConfig();
     void saveConfig();
+    void preloadPresets();
     void toggleOverlay(bool checked);
     void about();
 
@@ -20,296 +20,310 @@
 *  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+
 #include "cyclesearch.h"
 
-// Elementary cycles search
 
-ElementaryCyclesSearch::ElementaryCyclesSearch(QList<QList<bool>> matrix, QList<Node*> nodes)
+
+CycleSearch::CycleSearch(QObject* parent) :
+    QObject { parent }
 {
-    graphNodes = nodes;
-    adjacencyList = getAdjacencyList(matrix);
 }
 
-QList<QList<int>> ElementaryCyclesSearch::getAdjacencyList(QList<QList<bool>> matrix)
-{
-     QList<QList<int>> list;
 
-     for (int i = 0; i < matrix.size(); i++)
-     {
-         QList<int> v;
 
-         for (int j = 0; j < matrix[i].size(); j++)
-             if (matrix[i][j])
-                 v.push_back(j);
+void CycleSearch::setLatestSearch(quint64 searchId)
+{
+    mLatestSearchId.store(searchId);
+}
 
-         list.push_back(v);
-     }
 
-     return list;
-}
 
-QList<QList<Node*>> ElementaryCyclesSearch::getElementaryCycles()
+void CycleSearch::search(quint64 searchId, QList<int> offsets, QList<int> targets, int maxCycles)
 {
-    cycles.clear();
-    blocked.clear();
-    blocked.resize(adjacencyList.size());
-    B.clear();
-    B.resize(adjacencyList.size());
-    stack.clear();
+    mSearchId = searchId;
+    mMaxCycles = maxCycles;
+    mNumCycles = 0;
+    mStopped = false;
+    mBatch.clear();
 
-    StrongConnectedComponents sccs(adjacencyList);
+    mOffsets = offsets;
+    mTargets = targets;
 
-    int s = 0;
+    int numNodes = mOffsets.size() - 1;
+    int numEdges = mTargets.size();
 
-    while (true)
+    if (numNodes <= 0 || stopped())
     {
-        SCCResult* sccResult = sccs.getAdjacencyList(s);
-
-        if(sccResult && !sccResult->adjacencyList.empty())
-        {
-            QList<QList<int>> scc = sccResult->adjacencyList;
-            s = sccResult->lowestNodeId;
+        emit finished(searchId, 0, false);
+        return;
+    }
 
-            for (int i = 0; i < scc.size(); i++)
-            {
-                if (!scc[i].empty())
-                {
-                    blocked[i] = false;
-                }
-            }
+    mSources.resize(numEdges);
 
-            findCycles(s, s, scc);
-            s++;
-        }
-        else
-        {
-            break;
+    for (int node = 0; node < numNodes; node++) {
+        for (int edge = mOffsets[node]; edge < mOffsets[node + 1]; edge++) {
+            mSources[edge] = node;
         }
     }
 
-    return cycles;
-}
+    mComponent.fill(-1, numNodes);
+    mIndex.fill(-1, numNodes);
+    mLowLink.fill(0, numNodes);
+    mOnStack.fill(false, numNodes);
+    mBlocked.fill(false, numNodes);
+    mBlockedSets = QList<QList<int>>(numNodes);
+    mEdgeInBlockedSet.fill(false, numEdges);
+    mTarjanStack.clear();
+    mTarjanStack.reserve(numNodes);
+    mPath.clear();
+    mPath.reserve(numNodes);
 
-bool ElementaryCyclesSearch::findCycles(int v, int s, QList<QList<int>> adjList)
-{
-    bool f = false;
-    stack.push_back(v);
-    blocked[v] = true;
+    // Least node in a nontrivial component of subgraph from start on, cycles through it, then next start
+
+    int start = 0;
 
-    for (int i = 0; i < adjList[v].size(); i++)
+    while (start < numNodes && !stopped())
     {
-        int w = adjList[v][i];
+        findComponents(start);
 
-        if (w == s)
+        int least = -1;
+
+        for (int node = start; node < numNodes; node++)
         {
-            QList<Node*> cycle;
+            if (mComponentSizes[mComponent[node]] > 1)
+            {
+                least = node;
+                break;
+            }
+        }
 
-            for (int j = 0; j < stack.size(); j++)
-                cycle.push_back(graphNodes[stack[j]]);
+        if (least < 0) {
+            break;
+        }
 
-            cycles.push_back(cycle);
+        mStart = least;
+        mStartComponent = mComponent[least];
 
-            f = true;
-        }
-        else if (!blocked[w])
+        for (int node = least; node < numNodes; node++)
         {
-            if (findCycles(w, s, adjList))
-                f = true;
-        }
-    }
+            if (mComponent[node] == mStartComponent)
+            {
+                mBlocked[node] = false;
 
-    if (f)
-    {
-        unblock(v);
-    }
-    else
-    {
-        for (int i = 0; i < adjList[v].size(); i++)
-        {
-            int w = adjList[v][i];
+                foreach (int edge, mBlockedSets[node]) {
+                    mEdgeInBlockedSet[edge] = false;
+                }
 
-            if (!B[w].contains(v))
-                B[w].push_back(v);
+                mBlockedSets[node].clear();
+            }
         }
+
+        circuit(least);
+
+        start = least + 1;
     }
 
-    stack.remove(stack.indexOf(v));
-    return f;
+    flushBatch();
+
+    emit finished(searchId, mNumCycles, mStopped && mNumCycles >= mMaxCycles);
 }
 
-void ElementaryCyclesSearch::unblock(int node)
+
+
+void CycleSearch::findComponents(int start)
 {
-    blocked[node] = false;
+    // Tarjan's algorithm restricted to nodes from start on
 
-    QList<int> Bnode = B[node];
+    int numNodes = mOffsets.size() - 1;
 
-    while (Bnode.size() > 0)
+    for (int node = start; node < numNodes; node++)
     {
-        int w = Bnode[0];
-        Bnode.remove(0);
-        if (blocked[w])
-            unblock(w);
+        mComponent[node] = -1;
+        mIndex[node] = -1;
+        mOnStack[node] = false;
     }
-}
 
-// Strong connected components
+    mComponentSizes.clear();
+    mTarjanStack.clear();
+    mIndexCounter = 0;
 
-StrongConnectedComponents::StrongConnectedComponents(QList<QList<int>> adjList)
-{
-    adjacencyListOriginal = adjList;
+    for (int node = start; node < numNodes; node++)
+    {
+        if (mIndex[node] < 0) {
+            strongConnect(node, start);
+        }
+    }
 }
 
-SCCResult* StrongConnectedComponents::getAdjacencyList(int node)
+
+
+void CycleSearch::strongConnect(int node, int start)
 {
-    visited.clear();
-    visited.resize(adjacencyListOriginal.size());
-    lowlink.clear();
-    lowlink.resize(adjacencyListOriginal.size());
-    number.clear();
-    number.resize(adjacencyListOriginal.size());
-    visited.clear();
-    visited.resize(adjacencyListOriginal.size());
-    stack.clear();
-    currentSCCs.clear();
-
-    makeAdjListSubgraph(node);
-
-    for (int i = node; i < adjacencyListOriginal.size(); i++)
+    mIndex[node] = mIndexCounter;
+    mLowLink[node] = mIndexCounter;
+    mIndexCounter++;
+
+    mTarjanStack.append(node);
+    mOnStack[node] = true;
+
+    for (int edge = mOffsets[node]; edge < mOffsets[node + 1]; edge++)
     {
-        if(!visited[i])
-        {
-            getStrongConnectedComponents(i);
+        int target = mTargets[edge];
 
-            QList<int> nodes = getLowestIdComponent();
+        if (target < start) {
+            continue;
+        }
 
-            if(!nodes.contains(node) && !nodes.contains(node + 1))
-            {
-                return getAdjacencyList(node + 1);
-            }
-            else
-            {
-                QList<QList<int>> adjList = getAdjList(nodes);
-                if (!adjList.empty())
-                    for (int j = 0; j < adjacencyListOriginal.size(); j++)
-                        if (!adjList[j].empty())
-                            return new SCCResult(adjList, j);
-            }
+        if (mIndex[target] < 0)
+        {
+            strongConnect(target, start);
+            mLowLink[node] = qMin(mLowLink[node], mLowLink[target]);
+        }
+        else if (mOnStack[target])
+        {
+            mLowLink[node] = qMin(mLowLink[node], mIndex[target]);
         }
     }
 
-    return nullptr;
+    if (mLowLink[node] == mIndex[node])
+    {
+        int component = mComponentSizes.size();
+        int size = 0;
+        int member = -1;
+
+        do
+        {
+            member = mTarjanStack.takeLast();
+            mOnStack[member] = false;
+            mComponent[member] = component;
+            size++;
+        }
+        while (member != node);
+
+        mComponentSizes.append(size);
+    }
 }
 
-void StrongConnectedComponents::makeAdjListSubgraph(int node)
+
+
+bool CycleSearch::circuit(int node)
 {
-    adjacencyList.clear();
-    adjacencyList.resize(adjacencyListOriginal.size());
+    bool found = false;
+
+    mPath.append(node);
+    mBlocked[node] = true;
 
-    for (int i = node; i < adjacencyList.size(); i++)
+    for (int edge = mOffsets[node]; edge < mOffsets[node + 1] && !stopped(); edge++)
     {
-        QList<int> successors;
+        int target = mTargets[edge];
 
-        for (int j = 0; j < adjacencyListOriginal[i].size(); j++)
-            if (adjacencyListOriginal[i][j] >= node)
-                successors.push_back(adjacencyListOriginal[i][j]);
+        if (target < mStart || mComponent[target] != mStartComponent) {
+            continue;
+        }
 
-        if (!successors.empty())
+        if (target == mStart)
         {
-            adjacencyList[i].clear();
-            adjacencyList[i].resize(successors.size());
-
-            for (int j = 0; j < successors.size(); j++)
-                adjacencyList[i][j] = successors[j];
+            addCycle();
+            found = true;
+        }
+        else if (!mBlocked[target] && circuit(target))
+        {
+            found = true;
         }
     }
-}
-
-QList<int> StrongConnectedComponents::getLowestIdComponent()
-{
-    int min = adjacencyList.size();
 
-    QList<int> currScc;
-
-    for (int i = 0; i < currentSCCs.size(); i++)
+    if (found)
+    {
+        unblock(node);
+    }
+    else
     {
-        QList<int> scc = currentSCCs[i];
+        // Node stays blocked until one of its successors gets unblocked
 
-        for (int j = 0; j < scc.size(); j++)
+        for (int edge = mOffsets[node]; edge < mOffsets[node + 1]; edge++)
         {
-            int node = scc[j];
-            if (node < min)
+            int target = mTargets[edge];
+
+            if (target >= mStart && mComponent[target] == mStartComponent && !mEdgeInBlockedSet[edge])
             {
-                currScc = scc;
-                min = node;
+                mEdgeInBlockedSet[edge] = true;
+                mBlockedSets[target].append(edge);
             }
         }
     }
 
-    return currScc;
+    mPath.removeLast();
+
+    return found;
 }
 
-QList<QList<int>> StrongConnectedComponents::getAdjList(QList<int> nodes)
+
+
+void CycleSearch::unblock(int node)
 {
-    QList<QList<int>> lowestIdAdjacencyList;
+    // Iterative, nodes unblocked when pushed so that none is pushed twice
+
+    mBlocked[node] = false;
+
+    mUnblockStack.clear();
+    mUnblockStack.append(node);
 
-    if (!nodes.empty())
+    while (!mUnblockStack.isEmpty())
     {
-        lowestIdAdjacencyList.resize(adjacencyList.size());
+        int current = mUnblockStack.takeLast();
 
-        for (int i = 0; i < nodes.size(); i++)
+        foreach (int edge, mBlockedSets[current])
         {
-            int node = nodes[i];
+            mEdgeInBlockedSet[edge] = false;
 
-            for (int j = 0; j < adjacencyList[node].size(); j++)
+            int source = mSources[edge];
+
+            if (mBlocked[source])
             {
-                int succ = adjacencyList[node][j];
-                if (nodes.contains(succ))
-                    lowestIdAdjacencyList[node].push_back(succ);
+                mBlocked[source] = false;
+                mUnblockStack.append(source);
             }
         }
-    }
 
-    return lowestIdAdjacencyList;
+        mBlockedSets[current].clear();
+    }
 }
 
-void StrongConnectedComponents::getStrongConnectedComponents(int root)
+
+
+void CycleSearch::addCycle()
 {
-    sccCounter++;
-    lowlink[root] = sccCounter;
-    number[root] = sccCounter;
-    visited[root] = true;
-    stack.push_back(root);
+    mBatch.append(mPath);
+    mNumCycles++;
 
-    for (int i = 0; i < adjacencyList[root].size(); i++)
-    {
-        int w = adjacencyList[root][i];
+    if (mBatch.size() >= mBatchSize) {
+        flushBatch();
+    }
 
-        if (!visited[w])
-        {
-            getStrongConnectedComponents(w);
-            lowlink[root] = lowlink[root] < lowlink[w] ? lowlink[root] : lowlink[w];
-        }
-        else if (number[w] < number[root])
-        {
-            if (stack.contains(w))
-                lowlink[root] = lowlink[root] < number[w] ? lowlink[root] : number[w];
-        }
+    if (mNumCycles >= mMaxCycles) {
+        mStopped = true;
     }
+}
+
+
 
-    if (lowlink[root] == number[root] && !stack.empty())
+void CycleSearch::flushBatch()
+{
+    if (!mBatch.isEmpty())
     {
-        int next = -1;
-        QList<int> scc;
+        emit cyclesFound(mSearchId, mBatch);
+        mBatch.clear();
+    }
+}
 
-        do
-        {
-            next = stack.back();
-            stack.pop_back();
-            scc.push_back(next);
-        }
-        while (number[next] > number[root]);
 
-        if (scc.size() > 1)
-            currentSCCs.push_back(scc);
+
+bool CycleSearch::stopped()
+{
+    if (!mStopped && mLatestSearchId.load() != mSearchId) {
+        mStopped = true;
     }
+
+    return mStopped;
 }
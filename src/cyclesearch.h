@@ -21,71 +21,83 @@
 */
 
 
-
 #ifndef CYCLESEARCH_H
 #define CYCLESEARCH_H
 
 
 
-#include "node.h"
+#include <QObject>
 #include <QList>
 
+#include <atomic>
+
+
 
+// Johnson's search of elementary cycles, on a worker thread, over a graph in compressed sparse row form:
+// successors of node i are targets[offsets[i]] to targets[offsets[i + 1] - 1]
 
-struct SCCResult
+class CycleSearch : public QObject
 {
-    QList<QList<int>> adjacencyList;
-    int lowestNodeId;
+    Q_OBJECT
 
-    SCCResult(QList<QList<int>> adjList, int id) :
-        adjacencyList { adjList },
-        lowestNodeId { id }
-    {}
-};
+public:
+    explicit CycleSearch(QObject* parent = nullptr);
 
+    // Thread-safe: searches other than latest one stop as soon as possible
 
+    void setLatestSearch(quint64 searchId);
 
-class ElementaryCyclesSearch
-{
-public:
-    ElementaryCyclesSearch(QList<QList<bool>> matrix, QList<Node*> nodes);
-    QList<QList<Node*>> getElementaryCycles();
+public slots:
+    void search(quint64 searchId, QList<int> offsets, QList<int> targets, int maxCycles);
+
+signals:
+    void cyclesFound(quint64 searchId, QList<QList<int>> cycles);
+    void finished(quint64 searchId, int numCycles, bool truncated);
 
 private:
-    QList<QList<Node*>> cycles;
-    QList<QList<int>> adjacencyList;
-    QList<Node*> graphNodes;
-    QList<bool> blocked;
-    QList<QList<int>> B;
-    QList<int> stack;
-
-    QList<QList<int>> getAdjacencyList(QList<QList<bool>> matrix);
-    bool findCycles(int v, int s, QList<QList<int>> adjList);
-    void unblock(int node);
-};
+    std::atomic<quint64> mLatestSearchId { 0 };
 
+    quint64 mSearchId = 0;
+    int mMaxCycles = 0;
+    int mNumCycles = 0;
+    bool mStopped = false;
 
+    const int mBatchSize = 64;
+    QList<QList<int>> mBatch;
 
-class StrongConnectedComponents
-{
-public:
-    StrongConnectedComponents(QList<QList<int>> adjList);
-    SCCResult* getAdjacencyList(int node);
+    // Graph, and source of each edge
 
-private:
-    QList<QList<int>> adjacencyListOriginal;
-    QList<QList<int>> adjacencyList;
-    QList<bool> visited;
-    QList<int> stack;
-    QList<int> lowlink;
-    QList<int> number;
-    int sccCounter = 0;
-    QList<QList<int>> currentSCCs;
-
-    void makeAdjListSubgraph(int node);
-    QList<int> getLowestIdComponent();
-    QList<QList<int>> getAdjList(QList<int> nodes);
-    void getStrongConnectedComponents(int root);
+    QList<int> mOffsets;
+    QList<int> mTargets;
+    QList<int> mSources;
+
+    // Strongly connected components of subgraph of nodes from start on
+
+    QList<int> mComponent;
+    QList<int> mComponentSizes;
+    QList<int> mIndex;
+    QList<int> mLowLink;
+    QList<bool> mOnStack;
+    QList<int> mTarjanStack;
+    int mIndexCounter = 0;
+
+    // Circuit search from start node: blocked nodes and blocked sets as edge lists, allocated once per search
+
+    int mStart = 0;
+    int mStartComponent = 0;
+    QList<bool> mBlocked;
+    QList<QList<int>> mBlockedSets;
+    QList<bool> mEdgeInBlockedSet;
+    QList<int> mPath;
+    QList<int> mUnblockStack;
+
+    void findComponents(int start);
+    void strongConnect(int node, int start);
+    bool circuit(int node);
+    void unblock(int node);
+    void addCycle();
+    void flushBatch();
+    bool stopped();
 };
 
 
@@ -6,7 +6,7 @@
 
 
 
-EdgeWidget::EdgeWidget(Number<float>* blendFactor, bool srcIsOp, Factory *factory, QWidget *parent) :
+EdgeWidget::EdgeWidget(Number<float>* blendFactor, bool srcIsOp, QStringList outputNames, int output, Factory *factory, QWidget *parent) :
     QWidget { parent },
     mBlendFactor { blendFactor },
     mFactory { factory }
@@ -43,6 +43,36 @@ EdgeWidget::EdgeWidget(Number<float>* blendFactor, bool srcIsOp, Factory *factor
     mTypeAction->setCheckable(true);
     mTypeAction->setVisible(srcIsOp);
 
+    // Output of source operation read, if it has several
+
+    QStringList allOutputNames = QStringList { "Main" } + outputNames;
+
+    mOutputMenu = new QMenu("Output");
+
+    QActionGroup* outputGroup = new QActionGroup(mOutputMenu);
+
+    for (int i = 0; i < allOutputNames.size(); i++)
+    {
+        QAction* action = mOutputMenu->addAction(allOutputNames[i]);
+        action->setCheckable(true);
+        action->setChecked(i == output);
+        action->setData(QVariant(i));
+        outputGroup->addAction(action);
+    }
+
+    mOutputAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/format-list-ordered.png")), "Output: " + allOutputNames.value(output, "Main"));
+    mOutputAction->setMenu(mOutputMenu);
+    mOutputAction->setVisible(srcIsOp && !outputNames.isEmpty());
+
+    connect(mOutputAction, &QAction::triggered, this, [=, this]() {
+        mOutputMenu->exec(QCursor::pos());
+    });
+
+    connect(mOutputMenu, &QMenu::triggered, this, [=, this](QAction* action) {
+        mOutputAction->setText("Output: " + action->text());
+        emit outputChanged(action->data().toInt());
+    });
+
     // Insert operation
 
     mInsertOpAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/go-bottom.png")), "Insert", this, &EdgeWidget::populateAvailOpsMenu);
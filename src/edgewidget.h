@@ -15,6 +15,7 @@
 #include <QSlider>
 #include <QToolBar>
 #include <QAction>
+#include <QActionGroup>
 #include <QMenu>
 
 
@@ -24,7 +25,7 @@ class EdgeWidget : public QWidget
     Q_OBJECT
 
 public:
-    explicit EdgeWidget(Number<float>* blendFactor, bool srcIsOp, Factory* factory, QWidget *parent = nullptr);
+    explicit EdgeWidget(Number<float>* blendFactor, bool srcIsOp, QStringList outputNames, int output, Factory* factory, QWidget *parent = nullptr);
 
     QString const name();
     void setName(QString name);
@@ -40,6 +41,7 @@ public:
 signals:
     void edgeTypeChanged(bool predge);
     void typeActionToggled(bool checked);
+    void outputChanged(int output);
 
     void operationInsert(int index);
     void remove();
@@ -57,9 +59,11 @@ private:
     QToolBar* headerToolBar;
     QAction* midiLinkAction;
     QAction* mTypeAction;
+    QAction* mOutputAction;
     QAction* mInsertOpAction;
     QAction* mRemoveAction;
 
+    QMenu* mOutputMenu;
     QMenu* mAvailOpsMenu;
     QList<QAction*> mAvailOpsActions;
 
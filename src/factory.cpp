@@ -4,8 +4,11 @@
 #include "factory.h"
 #include "operationparser.h"
 
+#include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QStringList>
+#include <QtConcurrent>
 
 
 
@@ -255,24 +258,48 @@ void Factory::scan()
         allFileNames += fileNames;
     }
 
-    // Add found operations
+    QStringList filePaths;
+
+    foreach (QString fileName, allFileNames) {
+        filePaths.append(resFileNames.contains(fileName) ? opsResDir.absoluteFilePath(fileName) : opsDir.absoluteFilePath(fileName));
+    }
+
+    // Add found operations, parsed one file per task on the global thread pool
+    // Parsing touches no GL, and parameters are handed over to this thread once parsed
 
     qDeleteAll(mAvailOps);
     mAvailOps.clear();
 
-    OperationParser opParser;
+    QElapsedTimer timer;
+    timer.start();
 
-    foreach (QString fileName, allFileNames)
-    {
-        QString filePath = resFileNames.contains(fileName) ? opsResDir.absoluteFilePath(fileName) : opsDir.absoluteFilePath(fileName);
+    QThread* factoryThread = thread();
 
+    QList<ImageOperation*> operations = QtConcurrent::blockingMapped<QList<ImageOperation*>>(filePaths, [factoryThread](const QString& filePath) -> ImageOperation* {
         ImageOperation* operation = new ImageOperation();
 
-        if (opParser.read(operation, filePath, false)) {
+        OperationParser opParser;
+
+        if (!opParser.read(operation, filePath, false))
+        {
+            delete operation;
+            return nullptr;
+        }
+
+        operation->moveParametersToThread(factoryThread);
+
+        return operation;
+    });
+
+    foreach (ImageOperation* operation, operations)
+    {
+        if (operation) {
             mAvailOps.append(operation);
         }
     }
 
+    qInfo().noquote() << QString("Scanned %1 operations in %2 ms").arg(mAvailOps.size()).arg(timer.elapsed());
+
     // Sort operations alphabetically by name
 
     std::sort(mAvailOps.begin(), mAvailOps.end(), [] (const ImageOperation* op1, const ImageOperation* op2) {
@@ -299,3 +326,17 @@ void Factory::setMidiEnabled(bool enabled)
 {
     mMidiEnabled = enabled;
 }
+
+
+
+QList<TextureFormat> Factory::supportedTexFormats()
+{
+    return mSupportedTexFormats;
+}
+
+
+
+void Factory::setSupportedTexFormats(QList<TextureFormat> formats)
+{
+    mSupportedTexFormats = formats;
+}
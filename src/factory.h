@@ -47,6 +47,8 @@ public:
     QList<QString> availableOperationNames();
     ImageOperation* availableOperation(int index);
 
+    QList<TextureFormat> supportedTexFormats();
+
     template <class T>
     Number<T>* number(QUuid id);
 
@@ -68,6 +70,7 @@ signals:
 
 public slots:
     void setMidiEnabled(bool enabled);
+    void setSupportedTexFormats(QList<TextureFormat> formats);
 
 private:
     QList<ImageOperation*> mAvailOps;
@@ -76,6 +79,8 @@ private:
 
     bool mMidiEnabled = false;
 
+    QList<TextureFormat> mSupportedTexFormats;
+
     VideoInputControl* mVideoInputControl;
 };
 
@@ -27,9 +27,11 @@
 #include "edge.h"
 #include "edgewidget.h"
 #include "cycle.h"
-#include "cyclesearch.h"
 
+#include <QDebug>
+#include <QHash>
 #include <QKeyEvent>
+#include <QResizeEvent>
 #include <QRandomGenerator>
 #include <QMenu>
 #include <QAction>
@@ -45,7 +47,7 @@ GraphWidget::GraphWidget(Factory *factory, NodeManager* nodeManager, QWidget *pa
     // Graphics scene
 
     QGraphicsScene *scene = new QGraphicsScene(this);
-    scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
     scene->setFont(QFont("Arial", 8, QFont::Light));
     scene->setSceneRect(0.0, 0.0, 10'000.0, 10'000.0);
     setScene(scene);
@@ -105,6 +107,23 @@ GraphWidget::GraphWidget(Factory *factory, NodeManager* nodeManager, QWidget *pa
     connect(mNodeManager, &NodeManager::nodesCopied, this, &GraphWidget::setCopiedNodes);
 
     connect(mMainMenu, &QMenu::triggered, this, &GraphWidget::onActionTriggered);
+
+    // Cycle search thread
+
+    mCycleThread = new QThread(this);
+    mCycleSearch = new CycleSearch;
+    mCycleSearch->moveToThread(mCycleThread);
+
+    connect(mCycleThread, &QThread::finished, mCycleSearch, &QObject::deleteLater);
+    connect(this, &GraphWidget::cycleSearchRequested, mCycleSearch, &CycleSearch::search);
+    connect(mCycleSearch, &CycleSearch::cyclesFound, this, &GraphWidget::addCycles);
+    connect(mCycleSearch, &CycleSearch::finished, this, [=, this](quint64 searchId, int numCycles, bool truncated) {
+        if (searchId == mCycleSearchId && truncated) {
+            qInfo().noquote() << QString("Cycle search stopped after %1 cycles").arg(numCycles);
+        }
+    });
+
+    mCycleThread->start();
 }
 
 
@@ -113,6 +132,11 @@ GraphWidget::~GraphWidget()
 {
     //disconnect(scene(), &QGraphicsScene::selectionChanged, this, &GraphWidget::newSelectedNodes);
 
+    cancelCycleSearch();
+
+    mCycleThread->quit();
+    mCycleThread->wait();
+
     delete mAddSeedAction;
     delete mBuildNewOpAction;
     qDeleteAll(mAvailOpsActions);
@@ -281,6 +305,8 @@ void GraphWidget::newSelectedNodes()
     }
 
     emit selectedNodesChanged(selNodeIds);
+
+    updateNodesDetail();
 }
 
 
@@ -300,6 +326,8 @@ void GraphWidget::addNewNode(QUuid id, QWidget* widget)
     scene()->addItem(node);
     node->setPos(mClickPoint);
 
+    updateNodeDetail(node);
+
     //QGraphicsProxyWidget *proxyWidget = scene()->addWidget(mNodeManager->addNewOperation());
     //proxyWidget->setPos(mapToScene(mapFromGlobal(data.toPoint())));
 
@@ -316,6 +344,8 @@ void GraphWidget::addNewNodeOnPos(QUuid id, QWidget* widget, QPointF pos)
     scene()->addItem(node);
     node->setPos(pos);
 
+    updateNodeDetail(node);
+
     //QGraphicsProxyWidget *proxyWidget = scene()->addWidget(mNodeManager->addNewOperation());
     //proxyWidget->setPos(mapToScene(mapFromGlobal(data.toPoint())));
 
@@ -998,6 +1028,7 @@ void GraphWidget::pasteNodes()
 
 void GraphWidget::clearScene()
 {
+    cancelCycleSearch();
     scene()->clear();
 }
 
@@ -1230,6 +1261,50 @@ void GraphWidget::wheelEvent(QWheelEvent *event)
 
     center = mapToScene(rect().center());
     centerOn(center);
+
+    updateNodesDetail();
+}
+
+
+
+void GraphWidget::resizeEvent(QResizeEvent* event)
+{
+    QGraphicsView::resizeEvent(event);
+    updateNodesDetail();
+}
+
+
+
+void GraphWidget::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    updateNodesDetail();
+}
+
+
+
+void GraphWidget::updateNodesDetail()
+{
+    const QList<QGraphicsItem*> items = scene()->items(Qt::AscendingOrder);
+
+    for (QGraphicsItem* item : items) {
+        if (Node* node = qgraphicsitem_cast<Node*>(item)) {
+            updateNodeDetail(node);
+        }
+    }
+}
+
+
+
+void GraphWidget::updateNodeDetail(Node* node)
+{
+    // Full widget only for selected node, or on-screen node when zoomed in
+    // Proxies of the rest hidden, so their widgets are neither laid out nor painted
+
+    QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+    bool zoomedIn = scaleFactor >= mDetailScale;
+
+    node->setDetailed(node->isSelected() || (zoomedIn && node->sceneBoundingRect().intersects(visibleRect)));
 }
 
 
@@ -1362,21 +1437,64 @@ void GraphWidget::searchElementaryCycles()
         }
     }
 
-    QList<bool> row(nodes.size(), false);
-    QList<QList<bool>> adjacencyMatrix(nodes.size(), row);
+    // Compressed sparse rows: successors of each node stored contiguously
+
+    QHash<Node*, int> indices;
+
+    for (int i = 0; i < nodes.size(); i++) {
+        indices.insert(nodes[i], i);
+    }
+
+    QList<QList<int>> successors(nodes.size());
+
+    foreach (Edge* edge, edges) {
+        successors[indices.value(edge->sourceNode())].append(indices.value(edge->destNode()));
+    }
+
+    QList<int> offsets { 0 };
+    QList<int> targets;
+    targets.reserve(edges.size());
 
-    foreach (Edge* edge, edges)
+    foreach (const QList<int>& nodeSuccessors, successors)
     {
-        int i = nodes.indexOf(edge->sourceNode());
-        int j = nodes.indexOf(edge->destNode());
-        adjacencyMatrix[i][j] = true;
+        targets.append(nodeSuccessors);
+        offsets.append(targets.size());
     }
 
-    ElementaryCyclesSearch ecs(adjacencyMatrix, nodes);
-    QList<QList<Node*>> cycles = ecs.getElementaryCycles();
+    // Search for previous graph stops, cycles it still sends get discarded
+
+    cancelCycleSearch();
+
+    mCycleNodes = nodes;
 
-    foreach (QList<Node*> nodeCycle, cycles)
+    emit cycleSearchRequested(mCycleSearchId, offsets, targets, mMaxCycles);
+}
+
+
+
+void GraphWidget::cancelCycleSearch()
+{
+    mCycleSearchId++;
+    mCycleSearch->setLatestSearch(mCycleSearchId);
+    mCycleNodes.clear();
+}
+
+
+
+void GraphWidget::addCycles(quint64 searchId, QList<QList<int>> cycles)
+{
+    if (searchId != mCycleSearchId) {
+        return;
+    }
+
+    foreach (const QList<int>& cycleIndices, cycles)
     {
+        QList<Node*> nodeCycle;
+
+        foreach (int index, cycleIndices) {
+            nodeCycle.append(mCycleNodes[index]);
+        }
+
         Cycle* cycle = new Cycle(nodeCycle);
         scene()->addItem(cycle);
     }
@@ -28,8 +28,10 @@
 //#include "blendfactorwidget.h"
 #include "factory.h"
 #include "nodemanager.h"
+#include "cyclesearch.h"
 
 #include <QGraphicsView>
+#include <QThread>
 #include <QUuid>
 #include <QMap>
 #include <QPointF>
@@ -107,6 +109,7 @@ public slots:
 
 signals:
     void selectedNodesChanged(QList<QUuid> selNodeIds);
+    void cycleSearchRequested(quint64 searchId, QList<int> offsets, QList<int> targets, int maxCycles);
     /*void singleNodeSelected(Node*);
     void operationNodeSelected(QUuid id);
     void multipleNodesSelected();
@@ -122,6 +125,8 @@ signals:
 protected:
     void contextMenuEvent(QContextMenuEvent* event) override;
     void wheelEvent(QWheelEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void scrollContentsBy(int dx, int dy) override;
     void drawBackground(QPainter* painter, const QRectF& rect) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
@@ -142,6 +147,10 @@ private:
     QPointF center;
     qreal scaleFactor = 1.0;
 
+    // Below this scale nodes are drawn collapsed, unless selected
+
+    const qreal mDetailScale = 0.5;
+
     QPointF mClickPoint;
 
     QMenu* mMainMenu;
@@ -156,14 +165,25 @@ private:
     QMap<QUuid, Seed*> mCopiedSeeds;
     QMap<QUuid, QPointF> mCopiedNodePositions;
 
+    // Elementary cycles searched on worker thread, added as found while graph unchanged
+
+    QThread* mCycleThread;
+    CycleSearch* mCycleSearch;
+    quint64 mCycleSearchId = 0;
+    QList<Node*> mCycleNodes;
+    const int mMaxCycles = 10'000;
+
     void populateAvailOpsMenu();
     void enablePasteAction();
+    void updateNodesDetail();
+    void updateNodeDetail(Node* node);
 
     //void copyNodes(bool connectionA);
     bool pointIntersectsItem(QPointF point);
     void reconnectNodes(Node* node);
 
     void searchElementaryCycles();
+    void cancelCycleSearch();
 
     Node* getNode(QUuid id);
     Edge* getEdge(QUuid srcId, QUuid dstId);
@@ -185,6 +205,7 @@ private slots:
     void removeEdge(QUuid srcId, QUuid dstId);
     void centerNodeBetween(QUuid srcId, QUuid dstId, QUuid opId);
     void setCopiedNodes(QMap<QUuid, ImageOperation*> opsMap, QMap<QUuid, Seed*> seedsMap);
+    void addCycles(quint64 searchId, QList<QList<int>> cycles);
 };
 
 
@@ -1,5 +1,313 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
 #include "histogramwidget.h"
 
-HistogramWidget::HistogramWidget(QWidget *parent)
-    : QWidget{parent}
-{}
+#include <cmath>
+#include <algorithm>
+#include <QDebug>
+
+
+
+HistogramWidget::HistogramWidget(QWidget* parent) :
+    QOpenGLWidget(parent)
+{
+    setWindowTitle("Histogram");
+    resize(512, 256);
+}
+
+
+
+HistogramWidget::~HistogramWidget()
+{
+    // Never shown: no context, nor OpenGL functions resolved
+
+    if (!isValid()) {
+        return;
+    }
+
+    makeCurrent();
+
+    if (mFence) {
+        glDeleteSync(mFence);
+    }
+
+    if (mReadBuffer) {
+        glUnmapNamedBuffer(mReadBuffer);
+    }
+
+    glDeleteBuffers(1, &mBinsBuffer);
+    glDeleteBuffers(1, &mReadBuffer);
+    glDeleteBuffers(1, &mVbo);
+    glDeleteVertexArrays(1, &mVao);
+
+    delete mComputeProgram;
+    delete mDrawProgram;
+
+    doneCurrent();
+}
+
+
+
+void HistogramWidget::initializeGL()
+{
+    initializeOpenGLFunctions();
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    mComputeProgram = new QOpenGLShaderProgram();
+    if (!mComputeProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/histogram.comp"))
+        qDebug() << "Compute shader error:\n" << mComputeProgram->log();
+    if (!mComputeProgram->link())
+        qDebug() << "Shader link error:\n" << mComputeProgram->log();
+
+    mDrawProgram = new QOpenGLShaderProgram();
+    if (!mDrawProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/histogram.vert"))
+        qDebug() << "Vertex shader error:\n" << mDrawProgram->log();
+    if (!mDrawProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/histogram.frag"))
+        qDebug() << "Fragment shader error:\n" << mDrawProgram->log();
+    if (!mDrawProgram->link())
+        qDebug() << "Shader link error:\n" << mDrawProgram->log();
+
+    // Bin counters on GPU, and persistently mapped copy read once fence signals
+
+    GLsizeiptr binsSize = 4 * mMaxBins * sizeof(GLuint);
+
+    glCreateBuffers(1, &mBinsBuffer);
+    glNamedBufferStorage(mBinsBuffer, binsSize, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &mReadBuffer);
+    glNamedBufferStorage(mReadBuffer, binsSize, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+    mReadData = static_cast<GLuint*>(glMapNamedBufferRange(mReadBuffer, 0, binsSize, flags));
+
+    // Vertices: two per bin and channel, drawn as triangle strips
+
+    glCreateBuffers(1, &mVbo);
+    glNamedBufferStorage(mVbo, 4 * 2 * mMaxBins * 2 * sizeof(GLfloat), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateVertexArrays(1, &mVao);
+    glVertexArrayVertexBuffer(mVao, 0, mVbo, 0, 2 * sizeof(GLfloat));
+    glEnableVertexArrayAttrib(mVao, 0);
+    glVertexArrayAttribFormat(mVao, 0, 2, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(mVao, 0, 0);
+}
+
+
+
+void HistogramWidget::paintGL()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (mDrawnBins == 0) {
+        return;
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+    mDrawProgram->bind();
+    glBindVertexArray(mVao);
+
+    QList<QVector4D> colors = {
+        QVector4D(1.0f, 0.0f, 0.0f, 0.6f),
+        QVector4D(0.0f, 1.0f, 0.0f, 0.6f),
+        QVector4D(0.0f, 0.0f, 1.0f, 0.6f),
+        QVector4D(1.0f, 1.0f, 1.0f, 0.3f)
+    };
+
+    for (int channel = 0; channel < 4; channel++)
+    {
+        mDrawProgram->setUniformValue("color", colors[channel]);
+        glDrawArrays(GL_TRIANGLE_STRIP, channel * 2 * mDrawnBins, 2 * mDrawnBins);
+    }
+
+    glBindVertexArray(0);
+    mDrawProgram->release();
+
+    glDisable(GL_BLEND);
+}
+
+
+
+void HistogramWidget::resizeGL(int w, int h)
+{
+    glViewport(0, 0, w, h);
+}
+
+
+
+void HistogramWidget::setTextureID(GLuint* texId)
+{
+    mTextureId = texId;
+}
+
+
+
+void HistogramWidget::compute(quintptr pFence)
+{
+    if (!isVisible() || !isValid() || !mTextureId || !*mTextureId) {
+        return;
+    }
+
+    makeCurrent();
+
+    // Previous counts: read only once available, a frame or two late
+
+    if (mFence)
+    {
+        GLenum result = glClientWaitSync(mFence, 0, 0);
+
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            glDeleteSync(mFence);
+            mFence = 0;
+
+            setVertices();
+            update();
+        }
+    }
+
+    // New counts: GPU waits for render to finish, CPU does not
+
+    if (!mFence)
+    {
+        GLsync renderFence = reinterpret_cast<GLsync>(pFence);
+
+        if (renderFence) {
+            glWaitSync(renderFence, 0, GL_TIMEOUT_IGNORED);
+        }
+
+        dispatch();
+    }
+
+    doneCurrent();
+}
+
+
+
+void HistogramWidget::dispatch()
+{
+    GLint width = 0;
+    GLint height = 0;
+    glGetTextureLevelParameteriv(*mTextureId, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTextureLevelParameteriv(*mTextureId, 0, GL_TEXTURE_HEIGHT, &height);
+
+    int step = std::max(1, static_cast<int>(std::ceil(static_cast<float>(std::max(width, height)) / mMaxSamples)));
+
+    mDispatchedBins = mNumBins;
+
+    GLsizeiptr binsSize = 4 * mDispatchedBins * sizeof(GLuint);
+
+    glClearNamedBufferSubData(mBinsBuffer, GL_R32UI, 0, binsSize, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    mComputeProgram->bind();
+    mComputeProgram->setUniformValue("inTexture", 0);
+    mComputeProgram->setUniformValue("numBins", static_cast<GLuint>(mDispatchedBins));
+    mComputeProgram->setUniformValue("step", step);
+
+    glBindTextureUnit(0, *mTextureId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mBinsBuffer);
+
+    glDispatchCompute(mNumGroups, mNumGroups, 1);
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindTextureUnit(0, 0);
+
+    mComputeProgram->release();
+
+    // Copy to mapped buffer: only a few kilobytes, read once fence signals
+
+    glCopyNamedBufferSubData(mBinsBuffer, mReadBuffer, 0, 0, binsSize);
+
+    mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+}
+
+
+
+void HistogramWidget::setVertices()
+{
+    // Heights relative to highest bin of all channels, linear or logarithmic
+
+    GLuint maxCount = *std::max_element(mReadData, mReadData + 4 * mDispatchedBins);
+
+    float norm = mLogScale ? std::log1p(static_cast<float>(maxCount)) : static_cast<float>(maxCount);
+
+    if (norm <= 0.0f) {
+        norm = 1.0f;
+    }
+
+    QList<GLfloat> vertices;
+    vertices.reserve(4 * 2 * mDispatchedBins * 2);
+
+    for (int channel = 0; channel < 4; channel++)
+    {
+        for (int bin = 0; bin < mDispatchedBins; bin++)
+        {
+            float count = static_cast<float>(mReadData[channel * mDispatchedBins + bin]);
+            float height = (mLogScale ? std::log1p(count) : count) / norm;
+
+            float x = -1.0f + 2.0f * (bin + 0.5f) / mDispatchedBins;
+
+            vertices << x << -1.0f << x << -1.0f + 2.0f * height;
+        }
+    }
+
+    // Single buffer update per refresh
+
+    glNamedBufferSubData(mVbo, 0, vertices.size() * sizeof(GLfloat), vertices.constData());
+
+    mDrawnBins = mDispatchedBins;
+}
+
+
+
+void HistogramWidget::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu menu;
+
+    QMenu* binsMenu = menu.addMenu("Bins");
+
+    foreach (int numBins, QList<int>({ 64, 128, 256, 512, 1024 }))
+    {
+        QAction* action = binsMenu->addAction(QString::number(numBins), this, [=, this]() {
+            mNumBins = numBins;
+        });
+        action->setCheckable(true);
+        action->setChecked(numBins == mNumBins);
+    }
+
+    QAction* logAction = menu.addAction("Logarithmic scale", this, [=, this](bool checked) {
+        mLogScale = checked;
+    });
+    logAction->setCheckable(true);
+    logAction->setChecked(mLogScale);
+
+    menu.exec(event->globalPos());
+}
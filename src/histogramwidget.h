@@ -1,15 +1,96 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
 #ifndef HISTOGRAMWIDGET_H
 #define HISTOGRAMWIDGET_H
 
-#include <QWidget>
 
-class HistogramWidget : public QWidget
+
+#include <QOpenGLWidget>
+#include <QOpenGLFunctions_4_5_Core>
+#include <QOpenGLShaderProgram>
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <QList>
+#include <QVector4D>
+
+
+
+// Live RGB and luminance histogram of output texture, binned on GPU and read back without stalling
+
+class HistogramWidget : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Core
 {
     Q_OBJECT
+
 public:
-    explicit HistogramWidget(QWidget *parent = nullptr);
+    explicit HistogramWidget(QWidget* parent = nullptr);
+    ~HistogramWidget();
+
+public slots:
+    void setTextureID(GLuint* texId);
+    void compute(quintptr pFence);
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+    void resizeGL(int w, int h) override;
 
-signals:
+    void contextMenuEvent(QContextMenuEvent* event) override;
+
+private:
+    GLuint* mTextureId = nullptr;
+
+    static const int mMaxBins = 1024;
+    int mNumBins = 256;
+    bool mLogScale = false;
+
+    // Texels sampled: at most this many per row and column
+
+    const int mMaxSamples = 2048;
+    const GLuint mNumGroups = 32;
+
+    QOpenGLShaderProgram* mComputeProgram = nullptr;
+    QOpenGLShaderProgram* mDrawProgram = nullptr;
+
+    GLuint mBinsBuffer = 0;
+    GLuint mReadBuffer = 0;
+    GLuint* mReadData = nullptr;
+    GLsync mFence = 0;
+
+    GLuint mVao = 0;
+    GLuint mVbo = 0;
+
+    // Bin counts of last dispatch and of drawn vertices: may differ from current while in flight
+
+    int mDispatchedBins = 0;
+    int mDrawnBins = 0;
+
+    void dispatch();
+    void setVertices();
 };
 
+
+
 #endif // HISTOGRAMWIDGET_H
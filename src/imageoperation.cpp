@@ -24,6 +24,7 @@
 
 #include "imageoperation.h"
 
+#include <cmath>
 #include <QMessageBox>
 #include <QApplication>
 
@@ -34,6 +35,9 @@ ImageOperation::ImageOperation()
     pOutTexId = new GLuint(0);
     pBlitInTexId = new GLuint(0);
     setOutTextureId();
+
+    mSubsteps = new Number<int>(1, 1, 16, 1, 64);
+    connectSubsteps();
 }
 
 
@@ -42,18 +46,40 @@ ImageOperation::ImageOperation(const ImageOperation& operation) :
     mName { operation.mName },
     mVertexShader { operation.mVertexShader },
     mFragmentShader { operation.mFragmentShader },
+    mComputeShader { operation.mComputeShader },
+    mLocalSizeX { operation.mLocalSizeX },
+    mLocalSizeY { operation.mLocalSizeY },
+    mHalo { operation.mHalo },
+    mPasses { operation.mPasses },
     mMinMagFilter { operation.mMinMagFilter },
     mEnabled { operation.mEnabled },
     mInputData { operation.mInputData },
+    mTexFormatInherited { operation.mTexFormatInherited },
+    mTexFormat { operation.mTexFormat },
+    mResolutionScale { operation.mResolutionScale },
+    mUpdateInterval { operation.mUpdateInterval },
+    mUpdatePhase { operation.mUpdatePhase },
+    mFootprintDeclared { operation.mFootprintDeclared },
+    mFootprintRadius { operation.mFootprintRadius },
+    mFootprintUniforms { operation.mFootprintUniforms },
+    mPointwise { operation.mPointwise },
+    mRegionRadiusUniform { operation.mRegionRadiusUniform },
     mSampler2DName { operation.mSampler2DName },
     mSampler2DArrayName { operation.mSampler2DArrayName },
+    mSampler2DSourceName { operation.mSampler2DSourceName },
     mSampler2DAvailable { operation.mSampler2DAvailable },
-    mSampler2DArrayAvailable { operation.mSampler2DArrayAvailable }
+    mSampler2DArrayAvailable { operation.mSampler2DArrayAvailable },
+    mStatisticsBlockName { operation.mStatisticsBlockName },
+    mStatisticsEnabled { operation.mStatisticsEnabled }
 {
     pOutTexId = new GLuint(0);
     pBlitInTexId = new GLuint(0);
+    setOutputNames(operation.mOutputNames);
     setOutTextureId();
 
+    mSubsteps = new Number<int>(*operation.mSubsteps);
+    connectSubsteps();
+
     // Copy parameters
 
     for (auto parameter: operation.floatUniformParameters)
@@ -94,18 +120,40 @@ ImageOperation::ImageOperation(const ImageOperation& operation, const ImageOpera
     mName { operation.mName },
     mVertexShader { operation.mVertexShader },
     mFragmentShader { operation.mFragmentShader },
+    mComputeShader { operation.mComputeShader },
+    mLocalSizeX { operation.mLocalSizeX },
+    mLocalSizeY { operation.mLocalSizeY },
+    mHalo { operation.mHalo },
+    mPasses { operation.mPasses },
     mMinMagFilter { operation.mMinMagFilter },
     mEnabled { oldOperation.mEnabled },
     mInputData { oldOperation.mInputData },
+    mTexFormatInherited { oldOperation.mTexFormatInherited },
+    mTexFormat { oldOperation.mTexFormat },
+    mResolutionScale { oldOperation.mResolutionScale },
+    mUpdateInterval { oldOperation.mUpdateInterval },
+    mUpdatePhase { oldOperation.mUpdatePhase },
+    mFootprintDeclared { operation.mFootprintDeclared },
+    mFootprintRadius { operation.mFootprintRadius },
+    mFootprintUniforms { operation.mFootprintUniforms },
+    mPointwise { operation.mPointwise },
+    mRegionRadiusUniform { operation.mRegionRadiusUniform },
     mSampler2DName { operation.mSampler2DName },
     mSampler2DArrayName { operation.mSampler2DArrayName },
+    mSampler2DSourceName { operation.mSampler2DSourceName },
     mSampler2DAvailable { operation.mSampler2DAvailable },
-    mSampler2DArrayAvailable { operation.mSampler2DArrayAvailable }
+    mSampler2DArrayAvailable { operation.mSampler2DArrayAvailable },
+    mStatisticsBlockName { operation.mStatisticsBlockName },
+    mStatisticsEnabled { oldOperation.mStatisticsEnabled }
 {
     pOutTexId = new GLuint(0);
     pBlitInTexId = new GLuint(0);
+    setOutputNames(operation.mOutputNames);
     setOutTextureId();
 
+    mSubsteps = new Number<int>(*oldOperation.mSubsteps);
+    connectSubsteps();
+
     // Copy parameters
 
     for (auto parameter: operation.floatUniformParameters)
@@ -148,11 +196,17 @@ ImageOperation::~ImageOperation()
         mContext->makeCurrent(mSurface);
 
         delete mProgram;
+        qDeleteAll(mPassPrograms);
 
         GLuint texIds[] = { mOutTexId, mBlitOutTexId, mBlendOutTexId };
         glDeleteTextures(3, texIds);
 
+        foreach (GLuint* texId, mExtraOutTexIds) {
+            glDeleteTextures(1, texId);
+        }
+
         glDeleteSamplers(1, &mSamplerId);
+        glDeleteSamplers(1, &mResampleSamplerId);
 
         mContext->doneCurrent();
     }
@@ -160,11 +214,16 @@ ImageOperation::~ImageOperation()
     delete pOutTexId;
     delete pBlitInTexId;
 
+    qDeleteAll(mExtraOutTexIds);
+    qDeleteAll(pExtraOutTexIds);
+
     qDeleteAll(floatUniformParameters);
     qDeleteAll(intUniformParameters);
     qDeleteAll(uintUniformParameters);
     qDeleteAll(glenumOptionsParameters);
     qDeleteAll(mMat4UniformParameters);
+
+    delete mSubsteps;
 }
 
 
@@ -196,53 +255,166 @@ void ImageOperation::init(QOpenGLContext* context, QOffscreenSurface *surface)
         glSamplerParameteri(mSamplerId, GL_TEXTURE_MIN_FILTER, mMinMagFilter);
         glSamplerParameteri(mSamplerId, GL_TEXTURE_MAG_FILTER, mMinMagFilter);
 
+        // Sampler for input of different resolution: bilinear
+
+        glGenSamplers(1, &mResampleSamplerId);
+        glSamplerParameteri(mResampleSamplerId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameteri(mResampleSamplerId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
         mContext->doneCurrent();
     }
 }
 
 
 
+bool ImageOperation::initialized() const
+{
+    return mContext != nullptr;
+}
+
+
+
 void ImageOperation::render()
 {
-    if (mEnabled)
+    render(inTextureId());
+}
+
+
+
+void ImageOperation::render(GLuint inTexId)
+{
+    // Main pass, after preceding ones if any, renders to output texture
+
+    if (mEnabled) {
+        renderPass(mPassPrograms.size(), inTexId, mOutTexId);
+    }
+}
+
+
+
+void ImageOperation::renderPass(int pass, GLuint inTexId, GLuint outTexId, GLuint srcTexId)
+{
+    QOpenGLShaderProgram* program = pass < mPassPrograms.size() ? mPassPrograms.at(pass) : mProgram;
+
+    program->bind();
+
+    GLuint unit = 0;
+
+    // Bind input texture unit and set sampler2D to unit
+
+    if (mSampler2DAvailable)
+    {
+        glBindTextureUnit(unit, inTexId);
+        int location = program->uniformLocation(mSampler2DName);
+        glUniform1i(location, unit);
+        unit++;
+    }
+
+    // Bind input texture unit and set sampler2DArray to unit
+
+    if (mSampler2DArrayAvailable)
     {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mOutTexId, 0);
+        glBindTextureUnit(unit, mArrayTexId);
+        int location = program->uniformLocation(mSampler2DArrayName);
+        glUniform1i(location, unit);
+        unit++;
+    }
 
-        glClear(GL_COLOR_BUFFER_BIT);
+    // Operation's input, for passes reading another pass' output: given one when sub-stepping
 
-        mProgram->bind();
+    int sourceLocation = mSampler2DSourceName.isEmpty() ? -1 : program->uniformLocation(mSampler2DSourceName);
 
-        GLuint unit = 0;
+    if (sourceLocation >= 0)
+    {
+        glBindTextureUnit(unit, srcTexId ? srcTexId : inTextureId());
+        glUniform1i(sourceLocation, unit);
+        glBindSampler(unit, mSamplerId);
+    }
 
-        // Bind input texture unit and set sampler2D to unit
+    glBindSampler(0, mInputResampled ? mResampleSamplerId : mSamplerId);
 
-        if (mSampler2DAvailable)
-        {
-            glBindTextureUnit(unit, inTextureId());
-            int location = mProgram->uniformLocation(mSampler2DName);
-            glUniform1i(location, unit);
-            unit++;
+    // Statistics of input: uniform block at binding point 0, buffer bound by render manager
+
+    if (!mStatisticsBlockName.isEmpty())
+    {
+        GLuint blockIndex = glGetUniformBlockIndex(program->programId(), mStatisticsBlockName.toUtf8().constData());
+
+        if (blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program->programId(), blockIndex, 0);
+        }
+    }
+
+    if (isCompute())
+    {
+        // Output and sub-step textures all allocated with operation's format and size
+
+        GLuint width = mAllocatedTexWidth;
+        GLuint height = mAllocatedTexHeight;
+        GLenum format = static_cast<GLenum>(mAllocatedTexFormat);
+
+        // Output written through image unit 0: layout(binding = 0) writeonly uniform image2D, extra outputs through next units
+
+        glBindImageTexture(0, outTexId, 0, GL_FALSE, 0, GL_WRITE_ONLY, format);
+
+        for (int i = 0; i < mOutputNames.size(); i++) {
+            glBindImageTexture(i + 1, *mExtraOutTexIds[i], 0, GL_FALSE, 0, GL_WRITE_ONLY, format);
+        }
+
+        glDispatchCompute((width + mLocalSizeX - 1) / mLocalSizeX, (height + mLocalSizeY - 1) / mLocalSizeY, 1);
+
+        // Output next read by texture fetches, blits, copies or pixel transfers
+
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT);
+
+        for (int i = 0; i <= mOutputNames.size(); i++) {
+            glBindImageTexture(i, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
         }
+    }
+    else
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outTexId, 0);
+
+        // Main pass writes extra outputs to further attachments, all in one draw
 
-        // Bind input texture unit and set sampler2DArray to unit
+        int numBuffers = pass == mPassPrograms.size() ? mOutputNames.size() + 1 : 1;
 
-        if (mSampler2DArrayAvailable)
+        if (numBuffers > 1)
         {
-            glBindTextureUnit(unit, mArrayTexId);
-            int location = mProgram->uniformLocation(mSampler2DArrayName);
-            glUniform1i(location, unit);
+            QList<GLenum> buffers { GL_COLOR_ATTACHMENT0 };
+
+            for (int i = 1; i < numBuffers; i++)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, *mExtraOutTexIds[i - 1], 0);
+                buffers.append(GL_COLOR_ATTACHMENT0 + i);
+            }
+
+            glDrawBuffers(numBuffers, buffers.constData());
         }
 
-        glBindSampler(0, mSamplerId);
+        glClear(GL_COLOR_BUFFER_BIT);
 
         glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-        glBindSampler(0, 0);
+        if (numBuffers > 1)
+        {
+            for (int i = 1; i < numBuffers; i++) {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+            }
+
+            GLenum buffer = GL_COLOR_ATTACHMENT0;
+            glDrawBuffers(1, &buffer);
+        }
+    }
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+    glBindSampler(0, 0);
 
-        mProgram->release();
+    if (sourceLocation >= 0) {
+        glBindSampler(unit, 0);
     }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    program->release();
 }
 
 
@@ -281,11 +453,163 @@ void ImageOperation::setFragmentShader(QString shader)
 
 
 
+QString ImageOperation::computeShader() const
+{
+    return mComputeShader;
+}
+
+
+
+void ImageOperation::setComputeShader(QString shader)
+{
+    mComputeShader = shader;
+}
+
+
+
+bool ImageOperation::isCompute() const
+{
+    return !mComputeShader.isEmpty();
+}
+
+
+
+GLuint ImageOperation::localSizeX() const
+{
+    return mLocalSizeX;
+}
+
+
+
+GLuint ImageOperation::localSizeY() const
+{
+    return mLocalSizeY;
+}
+
+
+
+void ImageOperation::setLocalSize(GLuint sizeX, GLuint sizeY)
+{
+    mLocalSizeX = sizeX > 0 ? sizeX : 1;
+    mLocalSizeY = sizeY > 0 ? sizeY : 1;
+}
+
+
+
+int ImageOperation::halo() const
+{
+    return mHalo;
+}
+
+
+
+void ImageOperation::setHalo(int halo)
+{
+    mHalo = halo;
+}
+
+
+
+QList<RenderPass> ImageOperation::passes() const
+{
+    return mPasses;
+}
+
+
+
+void ImageOperation::addPass(RenderPass pass)
+{
+    mPasses.append(pass);
+}
+
+
+
+void ImageOperation::clearPasses()
+{
+    mPasses.clear();
+}
+
+
+
+int ImageOperation::numPasses() const
+{
+    return mPassPrograms.size();
+}
+
+
+
+float ImageOperation::passScale(int pass) const
+{
+    return mPasses.at(pass).scale;
+}
+
+
+
+QString ImageOperation::computeShaderSource()
+{
+    // Declared work group size and halo as macros, right after #version line
+
+    QString defines = QString("#define LOCAL_SIZE_X %1\n#define LOCAL_SIZE_Y %2\n#define HALO %3\n").arg(mLocalSizeX).arg(mLocalSizeY).arg(mHalo);
+
+    QString source = mComputeShader;
+
+    int versionIndex = source.indexOf("#version");
+
+    if (versionIndex >= 0)
+    {
+        int lineEnd = source.indexOf('\n', versionIndex);
+
+        if (lineEnd >= 0) {
+            source.insert(lineEnd + 1, defines);
+        }
+        else {
+            source.append("\n" + defines);
+        }
+    }
+    else
+    {
+        source.prepend(defines);
+    }
+
+    return source;
+}
+
+
+
+QList<QOpenGLShaderProgram*> ImageOperation::programs()
+{
+    return QList<QOpenGLShaderProgram*>(mPassPrograms) << mProgram;
+}
+
+
+
 bool ImageOperation::linkShaders()
 {
     bool ok = true;
 
-    if (!mVertexShader.isEmpty() && !mFragmentShader.isEmpty())
+    mVersion++;
+
+    if (isCompute())
+    {
+        mContext->makeCurrent(mSurface);
+
+        mProgram->removeAllShaders();
+
+        if (!mProgram->addShaderFromSourceCode(QOpenGLShader::Compute, computeShaderSource()))
+        {
+            QMessageBox::information(qApp->activeWindow(), "Compute shader error", mProgram->log());
+            ok = false;
+        }
+
+        if (!mProgram->link())
+        {
+            QMessageBox::information(qApp->activeWindow(), "Shader link error", mProgram->log());
+            ok = false;
+        }
+
+        mContext->doneCurrent();
+    }
+    else if (!mVertexShader.isEmpty() && !mFragmentShader.isEmpty())
     {
         mContext->makeCurrent(mSurface);
 
@@ -308,6 +632,35 @@ bool ImageOperation::linkShaders()
             ok = false;
         }
 
+        // Preceding passes' programs
+
+        qDeleteAll(mPassPrograms);
+        mPassPrograms.clear();
+
+        foreach (RenderPass pass, mPasses)
+        {
+            QOpenGLShaderProgram* program = new QOpenGLShaderProgram();
+
+            if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, mVertexShader))
+            {
+                QMessageBox::information(qApp->activeWindow(), "Vertex shader error", program->log());
+                ok = false;
+            }
+            if (!program->addShaderFromSourceCode(QOpenGLShader::Fragment, pass.fragmentShader))
+            {
+                QMessageBox::information(qApp->activeWindow(), "Pass fragment shader error", program->log());
+                ok = false;
+            }
+
+            if (!program->link())
+            {
+                QMessageBox::information(qApp->activeWindow(), "Pass shader link error", program->log());
+                ok = false;
+            }
+
+            mPassPrograms.append(program);
+        }
+
         mContext->doneCurrent();
     }
     else
@@ -337,34 +690,43 @@ void ImageOperation::setUniform<float>(QString name, int type, GLsizei count, co
 {
     if (mUpdate)
     {
+        mVersion++;
+
         mContext->makeCurrent(mSurface);
-        mProgram->bind();
 
-        int location = mProgram->uniformLocation(name);
+        // Same uniforms in all passes
 
-        if (type == GL_FLOAT) {
-            glUniform1fv(location, count, values);
-        }
-        else if (type == GL_FLOAT_VEC2) {
-            glUniform2fv(location, count, values);
-        }
-        else if (type == GL_FLOAT_VEC3) {
-            glUniform3fv(location, count, values);
-        }
-        else if (type == GL_FLOAT_VEC4) {
-            glUniform4fv(location, count, values);
-        }
-        else if (type == GL_FLOAT_MAT2) {
-            glUniformMatrix2fv(location, count, GL_FALSE, values);
-        }
-        else if (type == GL_FLOAT_MAT3) {
-            glUniformMatrix3fv(location, count, GL_FALSE, values);
-        }
-        else if (type == GL_FLOAT_MAT4) {
-            glUniformMatrix4fv(location, count, GL_FALSE, values);
+        foreach (QOpenGLShaderProgram* program, programs())
+        {
+            program->bind();
+
+            int location = program->uniformLocation(name);
+
+            if (type == GL_FLOAT) {
+                glUniform1fv(location, count, values);
+            }
+            else if (type == GL_FLOAT_VEC2) {
+                glUniform2fv(location, count, values);
+            }
+            else if (type == GL_FLOAT_VEC3) {
+                glUniform3fv(location, count, values);
+            }
+            else if (type == GL_FLOAT_VEC4) {
+                glUniform4fv(location, count, values);
+            }
+            else if (type == GL_FLOAT_MAT2) {
+                glUniformMatrix2fv(location, count, GL_FALSE, values);
+            }
+            else if (type == GL_FLOAT_MAT3) {
+                glUniformMatrix3fv(location, count, GL_FALSE, values);
+            }
+            else if (type == GL_FLOAT_MAT4) {
+                glUniformMatrix4fv(location, count, GL_FALSE, values);
+            }
+
+            program->release();
         }
 
-        mProgram->release();
         mContext->doneCurrent();
     }
 }
@@ -376,25 +738,32 @@ void ImageOperation::setUniform<int>(QString name, int type, GLsizei count, cons
 {
     if (mUpdate)
     {
+        mVersion++;
+
         mContext->makeCurrent(mSurface);
-        mProgram->bind();
 
-        int location = mProgram->uniformLocation(name);
+        foreach (QOpenGLShaderProgram* program, programs())
+        {
+            program->bind();
+
+            int location = program->uniformLocation(name);
 
-        if (type == GL_INT) {
-            glUniform1iv(location, count, values);
-        }
-        else if (type == GL_INT_VEC2) {
-            glUniform2iv(location, count, values);
-        }
-        else if (type == GL_INT_VEC3) {
-            glUniform3iv(location, count, values);
-        }
-        else if (type == GL_INT_VEC4) {
-            glUniform4iv(location, count, values);
+            if (type == GL_INT) {
+                glUniform1iv(location, count, values);
+            }
+            else if (type == GL_INT_VEC2) {
+                glUniform2iv(location, count, values);
+            }
+            else if (type == GL_INT_VEC3) {
+                glUniform3iv(location, count, values);
+            }
+            else if (type == GL_INT_VEC4) {
+                glUniform4iv(location, count, values);
+            }
+
+            program->release();
         }
 
-        mProgram->release();
         mContext->doneCurrent();
     }
 }
@@ -406,25 +775,32 @@ void ImageOperation::setUniform<unsigned int>(QString name, int type, GLsizei co
 {
     if (mUpdate)
     {
+        mVersion++;
+
         mContext->makeCurrent(mSurface);
-        mProgram->bind();
 
-        int location = mProgram->uniformLocation(name);
+        foreach (QOpenGLShaderProgram* program, programs())
+        {
+            program->bind();
 
-        if (type == GL_UNSIGNED_INT) {
-            glUniform1uiv(location, count, values);
-        }
-        else if (type == GL_UNSIGNED_INT_VEC2) {
-            glUniform2uiv(location, count, values);
-        }
-        else if (type == GL_UNSIGNED_INT_VEC3) {
-            glUniform3uiv(location, count, values);
-        }
-        else if (type == GL_UNSIGNED_INT_VEC4) {
-            glUniform4uiv(location, count, values);
+            int location = program->uniformLocation(name);
+
+            if (type == GL_UNSIGNED_INT) {
+                glUniform1uiv(location, count, values);
+            }
+            else if (type == GL_UNSIGNED_INT_VEC2) {
+                glUniform2uiv(location, count, values);
+            }
+            else if (type == GL_UNSIGNED_INT_VEC3) {
+                glUniform3uiv(location, count, values);
+            }
+            else if (type == GL_UNSIGNED_INT_VEC4) {
+                glUniform4uiv(location, count, values);
+            }
+
+            program->release();
         }
 
-        mProgram->release();
         mContext->doneCurrent();
     }
 }
@@ -435,6 +811,8 @@ void ImageOperation::setMat4Uniform(QString name, UniformMat4Type type, QList<fl
 {
     if (mUpdate)
     {
+        mVersion++;
+
         QMatrix4x4 matrix;
         matrix.setToIdentity();
 
@@ -452,12 +830,17 @@ void ImageOperation::setMat4Uniform(QString name, UniformMat4Type type, QList<fl
         }
 
         mContext->makeCurrent(mSurface);
-        mProgram->bind();
 
-        int location = mProgram->uniformLocation(name);
-        mProgram->setUniformValue(location, matrix);
+        foreach (QOpenGLShaderProgram* program, programs())
+        {
+            program->bind();
+
+            int location = program->uniformLocation(name);
+            program->setUniformValue(location, matrix);
+
+            program->release();
+        }
 
-        mProgram->release();
         mContext->doneCurrent();
     }
 }
@@ -478,6 +861,8 @@ void ImageOperation::setAllParameters()
 {
     mUpdate = true;
 
+    setSubstepsUniform();
+
     foreach (auto parameter, floatUniformParameters) {
         parameter->setUniform();
     }
@@ -514,6 +899,7 @@ bool ImageOperation::enabled() const
 void ImageOperation::enable(bool set)
 {
     mEnabled = set;
+    mVersion++;
     setOutTextureId();
     setBlitInTextureId();
 }
@@ -537,6 +923,12 @@ void ImageOperation::setOutTextureId()
     else {
         *pOutTexId = 0;
     }
+
+    // Extra outputs of disabled operation pass main one through
+
+    for (int i = 0; i < pExtraOutTexIds.size(); i++) {
+        *pExtraOutTexIds[i] = mEnabled && i < mOutputNames.size() ? *mExtraOutTexIds[i] : *pOutTexId;
+    }
 }
 
 
@@ -562,6 +954,7 @@ void ImageOperation::setBlitInTextureId()
 void ImageOperation::enableBlit(bool set)
 {
     mBlitEnabled = set;
+    mVersion++;
     setBlitInTextureId();
     setOutTextureId();
 }
@@ -625,6 +1018,7 @@ void ImageOperation::setInputData(QList<InputData*> data)
     setBlitInTextureId();
 
     mInputData = data;
+    mVersion++;
 
     mInputTextures.clear();
     foreach(InputData* iData, data) {
@@ -693,30 +1087,354 @@ GLuint* ImageOperation::pOutTextureId()
 
 
 
-GLuint ImageOperation::samplerId()
+GLuint* ImageOperation::pOutTextureId(int output)
 {
-    return mSamplerId;
-}
-
+    // Main output if index not declared
 
+    if (output > 0 && output <= mOutputNames.size()) {
+        return pExtraOutTexIds[output - 1];
+    }
 
-QList<GLuint*> ImageOperation::textureIds()
-{
-    return QList<GLuint*> { &mOutTexId, &mBlitOutTexId, &mBlendOutTexId };
+    return pOutTexId;
 }
 
 
 
-GLuint* ImageOperation::arrayTextureId()
+QList<GLuint*> ImageOperation::pOutTextureIds()
 {
-    return &mArrayTexId;
+    QList<GLuint*> texIds { pOutTexId };
+
+    for (int i = 0; i < mOutputNames.size(); i++) {
+        texIds.append(pExtraOutTexIds[i]);
+    }
+
+    return texIds;
 }
 
 
 
-GLsizei ImageOperation::arrayTextureDepth()
+QStringList ImageOperation::outputNames() const
 {
-    return mArrayTexDepth;
+    return mOutputNames;
+}
+
+
+
+void ImageOperation::setOutputNames(QStringList names)
+{
+    mOutputNames = names;
+
+    while (mExtraOutTexIds.size() < mOutputNames.size())
+    {
+        mExtraOutTexIds.append(new GLuint(0));
+        pExtraOutTexIds.append(new GLuint(0));
+    }
+
+    mVersion++;
+
+    setOutTextureId();
+}
+
+
+
+GLuint ImageOperation::samplerId()
+{
+    return mSamplerId;
+}
+
+
+
+QList<GLuint*> ImageOperation::textureIds()
+{
+    QList<GLuint*> texIds { &mOutTexId, &mBlitOutTexId, &mBlendOutTexId };
+
+    for (int i = 0; i < mOutputNames.size(); i++) {
+        texIds.append(mExtraOutTexIds[i]);
+    }
+
+    return texIds;
+}
+
+
+
+bool ImageOperation::texFormatInherited() const
+{
+    return mTexFormatInherited;
+}
+
+
+
+void ImageOperation::setTexFormatInherited(bool inherit)
+{
+    mTexFormatInherited = inherit;
+}
+
+
+
+TextureFormat ImageOperation::texFormat() const
+{
+    return mTexFormat;
+}
+
+
+
+void ImageOperation::setTexFormat(TextureFormat format)
+{
+    mTexFormat = format;
+    mVersion++;
+}
+
+
+
+float ImageOperation::resolutionScale() const
+{
+    return mResolutionScale;
+}
+
+
+
+void ImageOperation::setResolutionScale(float scale)
+{
+    mResolutionScale = scale;
+    mVersion++;
+}
+
+
+
+TextureFormat ImageOperation::allocatedTexFormat() const
+{
+    return mAllocatedTexFormat;
+}
+
+
+
+GLuint ImageOperation::allocatedTexWidth() const
+{
+    return mAllocatedTexWidth;
+}
+
+
+
+GLuint ImageOperation::allocatedTexHeight() const
+{
+    return mAllocatedTexHeight;
+}
+
+
+
+void ImageOperation::setAllocatedTextures(TextureFormat format, GLuint width, GLuint height)
+{
+    mAllocatedTexFormat = format;
+    mAllocatedTexWidth = width;
+    mAllocatedTexHeight = height;
+}
+
+
+
+void ImageOperation::setInputResampled(bool resampled)
+{
+    mInputResampled = resampled;
+}
+
+
+
+int ImageOperation::updateInterval() const
+{
+    return mUpdateInterval;
+}
+
+
+
+int ImageOperation::updatePhase() const
+{
+    return mUpdatePhase;
+}
+
+
+
+void ImageOperation::setUpdateInterval(int interval, int phase)
+{
+    mUpdateInterval = qMax(1, interval);
+    mUpdatePhase = phase < 0 ? -1 : phase % mUpdateInterval;
+}
+
+
+
+bool ImageOperation::footprintDeclared() const
+{
+    return mFootprintDeclared;
+}
+
+
+
+int ImageOperation::footprintRadius() const
+{
+    return mFootprintRadius;
+}
+
+
+
+QStringList ImageOperation::footprintUniforms() const
+{
+    return mFootprintUniforms;
+}
+
+
+
+void ImageOperation::setFootprint(int radius, QStringList uniforms)
+{
+    mFootprintDeclared = true;
+    mFootprintRadius = radius;
+    mFootprintUniforms = uniforms;
+}
+
+
+
+void ImageOperation::clearFootprint()
+{
+    mFootprintDeclared = false;
+    mFootprintRadius = 0;
+    mFootprintUniforms.clear();
+}
+
+
+
+int ImageOperation::footprint()
+{
+    // Undeclared footprint means unbounded neighbourhood
+
+    if (!mFootprintDeclared) {
+        return -1;
+    }
+
+    int radius = mFootprintRadius;
+
+    auto uniformsRadius = [&](auto parameters) {
+        foreach (auto parameter, parameters) {
+            if (mFootprintUniforms.contains(parameter->uniformName())) {
+                foreach (auto value, parameter->values()) {
+                    radius = qMax(radius, static_cast<int>(std::ceil(std::abs(static_cast<double>(value)))));
+                }
+            }
+        }
+    };
+
+    uniformsRadius(floatUniformParameters);
+    uniformsRadius(intUniformParameters);
+    uniformsRadius(uintUniformParameters);
+
+    return radius;
+}
+
+
+
+bool ImageOperation::pointwise() const
+{
+    return mPointwise;
+}
+
+
+
+void ImageOperation::setPointwise(bool set)
+{
+    mPointwise = set;
+}
+
+
+
+QString ImageOperation::regionRadiusUniform() const
+{
+    return mRegionRadiusUniform;
+}
+
+
+
+void ImageOperation::setRegionRadiusUniform(QString name)
+{
+    mRegionRadiusUniform = name;
+}
+
+
+
+float ImageOperation::regionRadius()
+{
+    // Negative if no region declared
+
+    if (mRegionRadiusUniform.isEmpty()) {
+        return -1.0f;
+    }
+
+    foreach (auto parameter, floatUniformParameters) {
+        if (parameter->uniformName() == mRegionRadiusUniform && parameter->size() > 0) {
+            return parameter->value(0);
+        }
+    }
+
+    return -1.0f;
+}
+
+
+
+int ImageOperation::substeps()
+{
+    return qMax(1, mSubsteps->value());
+}
+
+
+
+Number<int>* ImageOperation::substepsNumber()
+{
+    return mSubsteps;
+}
+
+
+
+void ImageOperation::setSubsteps(QUuid id, int substeps)
+{
+    // Number replaced to keep its saved id, to which midi links refer
+
+    delete mSubsteps;
+
+    mSubsteps = new Number<int>(id, qMax(1, substeps), 1, 16, 1, 64);
+    mSubsteps->setLimits();
+    connectSubsteps();
+
+    mVersion++;
+    setSubstepsUniform();
+}
+
+
+
+void ImageOperation::connectSubsteps()
+{
+    QObject::connect(mSubsteps, &NumberSignals::valueChanged, mSubsteps, [this](QVariant) {
+        mVersion++;
+        setSubstepsUniform();
+    });
+}
+
+
+
+void ImageOperation::setSubstepsUniform()
+{
+    // Programs not declaring it ignore location -1
+
+    int value = substeps();
+    setUniform<int>("substeps", GL_INT, 1, &value);
+}
+
+
+
+GLuint* ImageOperation::arrayTextureId()
+{
+    return &mArrayTexId;
+}
+
+
+
+GLsizei ImageOperation::arrayTextureDepth()
+{
+    return mArrayTexDepth;
 }
 
 
@@ -791,6 +1509,80 @@ void ImageOperation::setSampler2DArrayName(QString name)
 
 
 
+QString ImageOperation::sampler2DSourceName() const
+{
+    return mSampler2DSourceName;
+}
+
+
+
+void ImageOperation::setSampler2DSourceName(QString name)
+{
+    mSampler2DSourceName = name;
+}
+
+
+
+QString ImageOperation::statisticsBlockName() const
+{
+    return mStatisticsBlockName;
+}
+
+
+
+void ImageOperation::setStatisticsBlockName(QString name)
+{
+    mStatisticsBlockName = name;
+}
+
+
+
+bool ImageOperation::statisticsEnabled() const
+{
+    return mStatisticsEnabled;
+}
+
+
+
+void ImageOperation::setStatisticsEnabled(bool set)
+{
+    mStatisticsEnabled = set;
+
+    // Rendered at least once more, so that statistics are computed
+
+    mVersion++;
+}
+
+
+
+ImageStatistics ImageOperation::statistics() const
+{
+    return mStatistics;
+}
+
+
+
+void ImageOperation::setStatistics(ImageStatistics statistics)
+{
+    mStatistics = statistics;
+}
+
+
+
+quint64 ImageOperation::version() const
+{
+    return mVersion;
+}
+
+
+
+QList<InputData*> ImageOperation::inputData() const
+{
+    return mInputData;
+}
+
+
+
 template<>
 void ImageOperation::addUniformParameter<float>(UniformParameter<float>* parameter)
 {
@@ -923,6 +1715,49 @@ void ImageOperation::clearParameters()
 
 
 
+void ImageOperation::moveParametersToThread(QThread* thread)
+{
+    foreach (auto parameter, floatUniformParameters)
+    {
+        parameter->moveToThread(thread);
+        foreach (auto number, parameter->numbers()) {
+            number->moveToThread(thread);
+        }
+    }
+
+    foreach (auto parameter, intUniformParameters)
+    {
+        parameter->moveToThread(thread);
+        foreach (auto number, parameter->numbers()) {
+            number->moveToThread(thread);
+        }
+    }
+
+    foreach (auto parameter, uintUniformParameters)
+    {
+        parameter->moveToThread(thread);
+        foreach (auto number, parameter->numbers()) {
+            number->moveToThread(thread);
+        }
+    }
+
+    foreach (auto parameter, mMat4UniformParameters)
+    {
+        parameter->moveToThread(thread);
+        foreach (auto number, parameter->numbers()) {
+            number->moveToThread(thread);
+        }
+    }
+
+    foreach (auto parameter, glenumOptionsParameters) {
+        parameter->moveToThread(thread);
+    }
+
+    mSubsteps->moveToThread(thread);
+}
+
+
+
 template <>
 Number<float>* ImageOperation::number(QUuid id)
 {
@@ -962,6 +1797,10 @@ Number<int>* ImageOperation::number(QUuid id)
         }
     }
 
+    if (mSubsteps->id() == id) {
+        return mSubsteps;
+    }
+
     return nullptr;
 }
 
@@ -988,6 +1827,7 @@ Number<unsigned int>* ImageOperation::number(QUuid id)
 void ImageOperation::setMinMagFilter(GLenum filter)
 {
     mMinMagFilter = filter;
+    mVersion++;
 
     mContext->makeCurrent(mSurface);
 
@@ -28,6 +28,7 @@
 
 
 #include "inputdata.h"
+#include "texformat.h"
 #include "parameters/uniformparameter.h"
 #include "parameters/uniformmat4parameter.h"
 #include "parameters/optionsparameter.h"
@@ -41,11 +42,37 @@
 #include <QList>
 #include <QVector2D>
 #include <QVector3D>
+#include <QVector4D>
 #include <QMatrix4x4>
 #include <QString>
+#include <QStringList>
 #include <QMap>
 #include <QUuid>
 #include <QObject>
+#include <QThread>
+
+
+
+// Render pass preceding an operation's main one: own fragment shader and resolution scale
+
+struct RenderPass
+{
+    QString fragmentShader;
+    float scale = 1.0f;
+};
+
+
+
+// Image statistics: red, green, blue and luminance in x, y, z and w
+// Same layout as std140 uniform block with four vec4 members
+
+struct ImageStatistics
+{
+    QVector4D mean;
+    QVector4D minimum;
+    QVector4D maximum;
+    QVector4D variance;
+};
 
 
 
@@ -58,8 +85,11 @@ public:
     ~ImageOperation();
 
     void init(QOpenGLContext* context, QOffscreenSurface *surface);
+    bool initialized() const;
 
     void render();
+    void render(GLuint inTexId);
+    void renderPass(int pass, GLuint inTexId, GLuint outTexId, GLuint srcTexId = 0);
 
     QOpenGLShaderProgram* program();
 
@@ -69,6 +99,23 @@ public:
     void setVertexShader(QString shader);
     void setFragmentShader(QString shader);
 
+    QString computeShader() const;
+    void setComputeShader(QString shader);
+    bool isCompute() const;
+
+    GLuint localSizeX() const;
+    GLuint localSizeY() const;
+    void setLocalSize(GLuint sizeX, GLuint sizeY);
+
+    int halo() const;
+    void setHalo(int halo);
+
+    QList<RenderPass> passes() const;
+    void addPass(RenderPass pass);
+    void clearPasses();
+    int numPasses() const;
+    float passScale(int pass) const;
+
     bool linkShaders();
 
     void adjustOrtho(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top);
@@ -107,9 +154,54 @@ public:
     GLuint blendOutTextureId();
     GLuint inTextureId();
     GLuint* pOutTextureId();
+    GLuint* pOutTextureId(int output);
+    QList<GLuint*> pOutTextureIds();
+
+    QStringList outputNames() const;
+    void setOutputNames(QStringList names);
 
     QList<GLuint*> textureIds();
 
+    bool texFormatInherited() const;
+    void setTexFormatInherited(bool inherit);
+
+    TextureFormat texFormat() const;
+    void setTexFormat(TextureFormat format);
+
+    float resolutionScale() const;
+    void setResolutionScale(float scale);
+
+    // Format and size its textures were last allocated with, kept by render manager
+
+    TextureFormat allocatedTexFormat() const;
+    GLuint allocatedTexWidth() const;
+    GLuint allocatedTexHeight() const;
+    void setAllocatedTextures(TextureFormat format, GLuint width, GLuint height);
+
+    void setInputResampled(bool resampled);
+
+    int updateInterval() const;
+    int updatePhase() const;
+    void setUpdateInterval(int interval, int phase = -1);
+
+    bool footprintDeclared() const;
+    int footprintRadius() const;
+    QStringList footprintUniforms() const;
+    void setFootprint(int radius, QStringList uniforms);
+    void clearFootprint();
+    int footprint();
+
+    bool pointwise() const;
+    void setPointwise(bool set);
+
+    int substeps();
+    Number<int>* substepsNumber();
+    void setSubsteps(QUuid id, int substeps);
+
+    QString regionRadiusUniform() const;
+    void setRegionRadiusUniform(QString name);
+    float regionRadius();
+
     GLuint* arrayTextureId();
     GLsizei arrayTextureDepth();
 
@@ -133,6 +225,21 @@ public:
     QString sampler2DArrayName() const;
     void setSampler2DArrayName(QString name);
 
+    QString sampler2DSourceName() const;
+    void setSampler2DSourceName(QString name);
+
+    QString statisticsBlockName() const;
+    void setStatisticsBlockName(QString name);
+
+    bool statisticsEnabled() const;
+    void setStatisticsEnabled(bool set);
+
+    ImageStatistics statistics() const;
+    void setStatistics(ImageStatistics statistics);
+
+    quint64 version() const;
+    QList<InputData*> inputData() const;
+
     template <typename T>
     QList<UniformParameter<T>*> uniformParameters();
 
@@ -159,6 +266,10 @@ public:
 
     void clearParameters();
 
+    // Parameters and numbers parsed on a worker thread: their signals delivered on given thread instead
+
+    void moveParametersToThread(QThread* thread);
+
     template <class T>
     Number<T>* number(QUuid id);
 
@@ -173,8 +284,21 @@ private:
     QString mVertexShader;
     QString mFragmentShader;
 
+    // Compute operation: dispatched over output image, with declared work group size and halo
+
+    QString mComputeShader;
+    GLuint mLocalSizeX = 16;
+    GLuint mLocalSizeY = 16;
+    int mHalo = 0;
+
+    // Multi-pass operation: passes before main one, sharing vertex shader and parameters
+
+    QList<RenderPass> mPasses;
+    QList<QOpenGLShaderProgram*> mPassPrograms;
+
     GLenum mMinMagFilter = GL_NEAREST;
     GLuint mSamplerId = 0;
+    GLuint mResampleSamplerId = 0;
 
     bool mEnabled = false;
     bool mBlendEnabled = false;
@@ -193,15 +317,68 @@ private:
     GLuint* pBlitInTexId = nullptr;
     GLuint* pOutTexId = nullptr;
 
+    // Extra outputs, written at fragment locations or image units 1, 2...: kept until destruction as inputs point to them
+
+    QStringList mOutputNames;
+    QList<GLuint*> mExtraOutTexIds;
+    QList<GLuint*> pExtraOutTexIds;
+
     GLuint mArrayTexId = 0;
     GLsizei mArrayTexDepth = 10;
 
+    bool mTexFormatInherited = true;
+    TextureFormat mTexFormat = TextureFormat::RGBA8;
+
+    float mResolutionScale = 1.0f;
+
+    TextureFormat mAllocatedTexFormat = TextureFormat::RGBA8;
+    GLuint mAllocatedTexWidth = 0;
+    GLuint mAllocatedTexHeight = 0;
+
+    // Temporal decimation: rendered every mUpdateInterval iterations, at given phase or staggered by renderer if negative
+
+    int mUpdateInterval = 1;
+    int mUpdatePhase = -1;
+    bool mInputResampled = false;
+
+    // Iterations per frame, each reading previous one's output; mirrored to int uniform "substeps", for shaders declaring it
+
+    Number<int>* mSubsteps = nullptr;
+
+    void connectSubsteps();
+    void setSubstepsUniform();
+
+    // Neighbourhood radius in texels: constant plus values of listed uniforms
+
+    bool mFootprintDeclared = false;
+    int mFootprintRadius = 0;
+    QStringList mFootprintUniforms;
+
+    // Output pixel depends only on input pixel at same position: chains can be baked into a LUT
+
+    bool mPointwise = false;
+
+    // Output black outside centred circle whose radius, relative to shorter side, is value of uniform
+
+    QString mRegionRadiusUniform;
+
     QString mSampler2DName;
     QString mSampler2DArrayName;
+    QString mSampler2DSourceName;
 
     bool mSampler2DAvailable = false;
     bool mSampler2DArrayAvailable = false;
 
+    // Statistics of input, as uniform block; statistics of output, read back for display
+
+    QString mStatisticsBlockName;
+    bool mStatisticsEnabled = false;
+    ImageStatistics mStatistics;
+
+    // Incremented whenever output could change for the same input: parameters, program, inputs, format
+
+    quint64 mVersion = 0;
+
     QList<UniformParameter<float>*> floatUniformParameters;
     QList<UniformParameter<int>*> intUniformParameters;
     QList<UniformParameter<unsigned int>*> uintUniformParameters;
@@ -211,6 +388,9 @@ private:
     QList<OptionsParameter<GLenum>*> glenumOptionsParameters;
 
     void setMinMagFilter(GLenum filter);
+
+    QList<QOpenGLShaderProgram*> programs();
+    QString computeShaderSource();
 };
 
 
@@ -126,19 +126,32 @@ void ImageOperationNode::setInputType(QUuid id, InputType type)
         {
             // inputs[id]->setpTextureId(inputNodes.value(id)->operation->pOutTextureId());
             mInputNodes.value(id)->enableBlit(false);
-            mInputs[id]->setpTextureId(mInputNodes.value(id)->pOutTextureId());
+            mInputs[id]->setpTextureId(mInputNodes.value(id)->pOutTextureId(mInputs[id]->output()));
         }
         else if (type == InputType::Blit)
         {
             // inputs[id]->setpTextureId(inputNodes.value(id)->operation->blitTextureId());
             mInputNodes.value(id)->enableBlit(true);
-            mInputs[id]->setpTextureId(mInputNodes.value(id)->pOutTextureId());
+            mInputs[id]->setpTextureId(mInputNodes.value(id)->pOutTextureId(mInputs[id]->output()));
         }
     }
 }
 
 
 
+void ImageOperationNode::setInputOutput(QUuid id, int output)
+{
+    if (mInputs.contains(id) && mInputNodes.contains(id))
+    {
+        mInputs[id]->setOutput(output);
+        mInputs[id]->setpTextureId(mInputNodes.value(id)->pOutTextureId(output));
+
+        mOperation->setInputData(inputsList());
+    }
+}
+
+
+
 bool ImageOperationNode::isInput(QUuid id)
 {
     return mInputNodes.contains(id);
@@ -197,6 +210,13 @@ void ImageOperationNode::enableBlit(bool set)
 
 
 
+QMap<QUuid, ImageOperationNode*> ImageOperationNode::outputNodes() const
+{
+    return mOutputNodes;
+}
+
+
+
 void ImageOperationNode::addOutput(ImageOperationNode *node)
 {
     mOutputNodes.insert(node->id(), node);
@@ -301,14 +321,14 @@ void ImageOperationNode::setOperation(ImageOperation *newOperation)
         if (node->mInputs.value(mId)->type() == InputType::Normal)
         {
             mOperation->enableBlit(false);
-            node->mInputs[mId]->setpTextureId(mOperation->pOutTextureId());
+            node->mInputs[mId]->setpTextureId(mOperation->pOutTextureId(node->mInputs[mId]->output()));
             node->mOperation->setInputData(node->inputsList());
 
         }
         else if (node->mInputs.value(mId)->type() == InputType::Blit)
         {
             mOperation->enableBlit(true);
-            node->mInputs[mId]->setpTextureId(mOperation->pOutTextureId());
+            node->mInputs[mId]->setpTextureId(mOperation->pOutTextureId(node->mInputs[mId]->output()));
             node->mOperation->setInputData(node->inputsList());
         }
     }
@@ -316,7 +336,7 @@ void ImageOperationNode::setOperation(ImageOperation *newOperation)
 
 
 
-GLuint* ImageOperationNode::pOutTextureId() const
+GLuint* ImageOperationNode::pOutTextureId(int output) const
 {
-    return mOperation->pOutTextureId();
+    return mOperation->pOutTextureId(output);
 }
@@ -33,6 +33,7 @@ public:
     void addInput(ImageOperationNode* node, InputData* data);
     void removeInput(ImageOperationNode* node);
     void setInputType(QUuid id, InputType type);
+    void setInputOutput(QUuid id, int output);
     bool isInput(QUuid id);
 
     void setInputSeedTexId(QUuid id, GLuint *texId);
@@ -46,6 +47,7 @@ public:
     bool isBlitConnected();
     void enableBlit(bool set);
 
+    QMap<QUuid, ImageOperationNode*> outputNodes() const;
     void addOutput(ImageOperationNode* node);
     void removeOutput(ImageOperationNode* node);
 
@@ -59,7 +61,7 @@ public:
 
     void setOperation(ImageOperation* newOperation);
 
-    GLuint* pOutTextureId() const;
+    GLuint* pOutTextureId(int output = 0) const;
 
 private:
     QUuid mId;
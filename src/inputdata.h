@@ -18,9 +18,10 @@ enum class InputType { Normal, Blit, Seed };
 class InputData
 {
 public:
-    InputData(InputType inputType, GLuint* pTexId, float blendFactor) :
+    InputData(InputType inputType, GLuint* pTexId, float blendFactor, int output = 0) :
         mType { inputType },
-        mpTextureId { pTexId }
+        mpTextureId { pTexId },
+        mOutput { output }
     {
         mBlendFactor = new Number<float>(blendFactor, 0.0, 1.0, 0.0, 1.0);
     }
@@ -38,9 +39,15 @@ public:
     Number<float>* blendFactor() const { return mBlendFactor; }
     void setBlendFactor(float value) { mBlendFactor->setValue(value); }
 
+    // Which of source operation's outputs is read: 0 is main one
+
+    int output() const { return mOutput; }
+    void setOutput(int output) { mOutput = output; }
+
 private:
     InputType mType;
     GLuint* mpTextureId;
+    int mOutput;
     Number<float>* mBlendFactor;
 };
 
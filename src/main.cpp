@@ -23,8 +23,13 @@
 
 
 #include "applicationcontroller.h"
+#include "binaryconfig.h"
+#include "operationbenchmark.h"
+#include "sortbenchmark.h"
 
 #include <QApplication>
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QSurfaceFormat>
 
 
@@ -41,7 +46,47 @@ int main(int argc, char* argv[])
 
     QApplication app(argc, argv);
 
+    // GPU timings of fragment versus compute operations, without user interface
+
+    if (app.arguments().contains("--benchmark-ops"))
+    {
+        OperationBenchmark benchmark;
+        benchmark.run();
+        return 0;
+    }
+
+    // Sorting times of synthetic graphs with up to 2000 operations
+
+    if (app.arguments().contains("--benchmark-sort"))
+    {
+        SortBenchmark benchmark;
+        benchmark.run();
+        return 0;
+    }
+
+    // Conversion between XML and binary configurations, by output suffix: --convert-config in.fos out.fosb
+
+    int convertIndex = app.arguments().indexOf("--convert-config");
+
+    if (convertIndex >= 0 && convertIndex + 2 < app.arguments().size()) {
+        return BinaryConfig::convert(app.arguments().at(convertIndex + 1), app.arguments().at(convertIndex + 2)) ? 0 : 1;
+    }
+
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     ApplicationController appController;
 
+    qInfo().noquote() << QString("Started up in %1 ms").arg(startupTimer.elapsed());
+
+    // Convergence detection from command line: --on-convergence=report|stop|reseed|next
+
+    foreach (QString argument, app.arguments())
+    {
+        if (argument.startsWith("--on-convergence=")) {
+            appController.setConvergenceAction(argument.section('=', 1));
+        }
+    }
+
     return app.exec();
 }
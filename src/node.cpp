@@ -53,11 +53,15 @@ Node::Node(QUuid id, QWidget *widget, QGraphicsItem* parent) :
 
     mWidget->installEventFilter(this);
 
-    mProxyWidget = new QGraphicsProxyWidget(this);
-    mProxyWidget->setWidget(mWidget);
-    mProxyWidget->setPos(QPointF(0, 0));
+    // Proxy created on demand: until then widget is laid out but never shown on screen
 
-    resize(mProxyWidget->size());
+    mWidget->setAttribute(Qt::WA_DontShowOnScreen);
+
+    if (!mWidget->testAttribute(Qt::WA_Resized)) {
+        mWidget->adjustSize();
+    }
+
+    resize(mWidget->size());
 }
 
 
@@ -79,7 +83,9 @@ Node::~Node()
 
 void Node::resizeEvent(QGraphicsSceneResizeEvent* event)
 {
-    mProxyWidget->resize(event->newSize());
+    if (mProxyWidget) {
+        mProxyWidget->resize(event->newSize());
+    }
 
     foreach (Edge *edge, edgeList) {
         edge->adjust();
@@ -111,6 +117,23 @@ bool Node::eventFilter(QObject* obj, QEvent* event)
 
         return false;
     }
+    else if (obj == mWidget && event->type() == QEvent::Show && mProxyWidget && !mDetailed)
+    {
+        // Widget shown itself while collapsed (e.g. on recreation): hide proxy once done
+
+        QMetaObject::invokeMethod(this, [=, this](){
+            if (!mDetailed) {
+                mProxyWidget->setVisible(false);
+            }
+        }, Qt::QueuedConnection);
+
+        return false;
+    }
+    else if (obj == mWidget && event->type() == QEvent::WindowTitleChange)
+    {
+        update();
+        return false;
+    }
     return QGraphicsWidget::eventFilter(obj, event);
 }
 
@@ -155,6 +178,7 @@ void Node::selectToConnect()
 void Node::addEdge(Edge *edge)
 {
     edgeList.append(edge);
+    update();
 }
 
 
@@ -162,6 +186,7 @@ void Node::addEdge(Edge *edge)
 void Node::removeEdge(Edge *edge)
 {
     edgeList.removeOne(edge);
+    update();
 }
 
 
@@ -192,6 +217,33 @@ void Node::centerBetween(QPointF src, QPointF dst)
 }
 
 
+
+void Node::setDetailed(bool detailed)
+{
+    if (detailed == mDetailed) {
+        return;
+    }
+
+    mDetailed = detailed;
+
+    if (mDetailed && !mProxyWidget)
+    {
+        mProxyWidget = new QGraphicsProxyWidget(this);
+        mProxyWidget->setWidget(mWidget);
+        mProxyWidget->setPos(QPointF(0, 0));
+        mProxyWidget->resize(size());
+    }
+
+    // Hidden proxy: embedded widget is neither laid out nor painted
+
+    if (mProxyWidget) {
+        mProxyWidget->setVisible(mDetailed);
+    }
+
+    update();
+}
+
+
 /*void Node::setAsOutput()
 {
     graph->generator->setOutput(id);
@@ -215,7 +267,7 @@ QRectF Node::textBoundingRect() const
 
 QRectF Node::boundingRect() const
 {
-    return mProxyWidget->boundingRect();
+    return rect();
 }
 
 
@@ -271,6 +323,10 @@ void Node::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWid
 {
     Q_UNUSED(widget)
 
+    if (!mDetailed) {
+        paintCollapsed(painter);
+    }
+
     if (option->state & QStyle::State_Sunken || option->state & QStyle::State_Selected)
     {
         painter->setPen(QPen(QColor(128, 128, 164), 2));
@@ -757,3 +813,51 @@ void SeedNode::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
     menu.exec(event->screenPos());
 }
 */
+
+
+
+void Node::paintCollapsed(QPainter* painter)
+{
+    QRectF rect = mWidget->rect().toRectF();
+
+    painter->setPen(QPen(QColor(96, 96, 128), 2));
+    painter->setBrush(QColor(40, 40, 48));
+    painter->drawRoundedRect(rect, 20.0, 20.0);
+
+    // Title, large enough to be legible when zoomed out
+
+    QFont font = scene() ? scene()->font() : painter->font();
+    font.setPixelSize(qBound(12, static_cast<int>(rect.height() / 6.0), 48));
+    painter->setFont(font);
+    painter->setPen(Qt::white);
+    painter->drawText(rect.adjusted(24.0, 12.0, -24.0, -12.0), Qt::AlignCenter | Qt::TextWordWrap, mWidget->windowTitle());
+
+    // Input port dots on left side, output port dots on right side
+
+    QList<Edge*> inEdges;
+    QList<Edge*> outEdges;
+
+    foreach (Edge* edge, edgeList)
+    {
+        if (edge->destNode() == this) {
+            inEdges.append(edge);
+        }
+        if (edge->sourceNode() == this) {
+            outEdges.append(edge);
+        }
+    }
+
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(128, 128, 164));
+
+    qreal radius = 6.0;
+
+    for (int i = 0; i < inEdges.size(); i++) {
+        painter->drawEllipse(QPointF(rect.left(), rect.top() + rect.height() * (i + 1) / (inEdges.size() + 1)), radius, radius);
+    }
+    for (int i = 0; i < outEdges.size(); i++) {
+        painter->drawEllipse(QPointF(rect.right(), rect.top() + rect.height() * (i + 1) / (outEdges.size() + 1)), radius, radius);
+    }
+
+    painter->setBrush(Qt::NoBrush);
+}
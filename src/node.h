@@ -71,6 +71,9 @@ public:
 
     void centerBetween(QPointF src, QPointF dst);
 
+    bool detailed() const { return mDetailed; }
+    void setDetailed(bool detailed);
+
     //QRectF textBoundingRect() const;
 
     QRectF boundingRect() const override;
@@ -104,7 +107,10 @@ private:
     //qreal penSize = 2.0;
     QUuid mId;
     QWidget* mWidget;
-    QGraphicsProxyWidget* mProxyWidget;
+    QGraphicsProxyWidget* mProxyWidget = nullptr;
+    bool mDetailed = false;
+
+    void paintCollapsed(QPainter* painter);
 };
 
 
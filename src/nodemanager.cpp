@@ -79,71 +79,26 @@ NodeManager::~NodeManager()
 
 void NodeManager::sortOperations()
 {
-    //QList<ImageOperation*> tmpSortedOperations = sortedOperations;
+    mSorter.sort(mOperationNodesMap);
 
     QList<ImageOperation*> sortedOperations;
-
     QList<QPair<QUuid, QString>> sortedOperationsData;
-    //QList<QUuid> unsortedOperationsIds;
-
-    QMap<QUuid, ImageOperationNode*> pendingNodes = mOperationNodesMap;
-
-    // Set operations as non-computed (pending)
-
-    foreach (ImageOperationNode* node, mOperationNodesMap) {
-        node->setComputed(false);
-    }
-
-    // First operations are those whose inputs are all blit or seed, they do not depend on pending operations
-    // Also operations with no inputs but with some outputs, sorting algorithm depends on operations having inputs
-    // Discard isolated nodes, with no inputs nor outputs
 
-    foreach (ImageOperationNode* node, mOperationNodesMap)
+    foreach (ImageOperationNode* node, mSorter.sortedNodes())
     {
-        if (node->numInputs() == 0 && node->numOutputs() == 0)
-        {
-            pendingNodes.remove(node->id());
-            //unsortedOperationsIds.append(node->id);
-        }
-        else if ((node->numInputs() == 0 && node->numOutputs() > 0) || (node->numInputs() > 0 && node->numNonNormalInputs() == node->numInputs()))
-        {
-            sortedOperations.append(node->operation());
-            sortedOperationsData.append(QPair<QUuid, QString>(node->id(), node->operation()->name()));
-            pendingNodes.remove(node->id());
-            node->setComputed(true);
-        }
+        sortedOperations.append(node->operation());
+        sortedOperationsData.append(QPair<QUuid, QString>(node->id(), node->operation()->name()));
     }
 
-    // Sorting algorithm
-
-    while (!pendingNodes.empty())
-    {
-        QList<ImageOperationNode*> computedNodes;
-
-        foreach (ImageOperationNode* node, pendingNodes)
-        {
-            if (node->allInputsComputed())
-            {
-                sortedOperations.append(node->operation());
-                sortedOperationsData.push_back(QPair<QUuid, QString>(node->id(), node->operation()->name()));
-                computedNodes.append(node);
-                node->setComputed(true);
-            }
-        }
+    // Unchanged order needs no rebuild downstream
 
-        foreach (ImageOperationNode* node, computedNodes)
-        {
-            pendingNodes.remove(node->id());
-        }
-
-        if (computedNodes.empty())
-            break;
+    if (sortedOperations == mSortedOperations && sortedOperationsData == mSortedOperationsData) {
+        return;
     }
 
-    //if (tmpSortedOperations != sortedOperations)
-        //emit sortedOperationsChanged(sortedOperationsData, unsortedOperationsIds);
+    mSortedOperations = sortedOperations;
+    mSortedOperationsData = sortedOperationsData;
 
-    // mRenderManager->setSortedOperations(sortedOperations);
     emit sortedOperationsChanged(sortedOperations);
     emit sortedOpsDataChanged(sortedOperationsData);
 }
@@ -236,12 +191,12 @@ void NodeManager::connectOperations(QMap<QUuid, QMap<QUuid, InputData*>> connect
                 if (inData->type() == InputType::Normal)
                 {
                     mOperationNodesMap.value(srcId)->enableBlit(false);
-                    inData->setpTextureId(mOperationNodesMap.value(srcId)->pOutTextureId());
+                    inData->setpTextureId(mOperationNodesMap.value(srcId)->pOutTextureId(inData->output()));
                 }
                 else if (inData->type() == InputType::Blit)
                 {
                     mOperationNodesMap.value(srcId)->enableBlit(true);
-                    inData->setpTextureId(mOperationNodesMap.value(srcId)->pOutTextureId());
+                    inData->setpTextureId(mOperationNodesMap.value(srcId)->pOutTextureId(inData->output()));
                 }
 
                 mOperationNodesMap.value(dstId)->addInput(mOperationNodesMap.value(srcId), inData);
@@ -323,7 +278,7 @@ void NodeManager::connectPastedNodes(QMap<QUuid, QUuid> isomorphism)
             {
                 QUuid srcId1 = isomorphism.value(srcId0);
                 auto srcNode1 = mOperationNodesMap.value(srcId1);
-                InputData* newInputData = new InputData(inputData->type(), srcNode1->pOutTextureId(), inputData->blendFactor()->value());
+                InputData* newInputData = new InputData(inputData->type(), srcNode1->pOutTextureId(inputData->output()), inputData->blendFactor()->value(), inputData->output());
 
                 dstNode1->addInput(srcNode1, newInputData);
                 srcNode1->addOutput(dstNode1);
@@ -359,6 +314,17 @@ void NodeManager::setOperationInputType(QUuid srcId, QUuid dstId, InputType type
 
 
 
+void NodeManager::setOperationInputOutput(QUuid srcId, QUuid dstId, int output)
+{
+    if (mOperationNodesMap.contains(srcId) && mOperationNodesMap.contains(dstId))
+    {
+        mOperationNodesMap.value(dstId)->setInputOutput(srcId, output);
+        sortOperations();
+    }
+}
+
+
+
 /*void NodeManager::pasteOperations()
 {
     foreach (auto copiedNode, mCopiedOperationNodes) {
@@ -453,7 +419,7 @@ void NodeManager::copyOperation(QUuid srcId)
 
     QMap<QUuid, InputData*> inputData;
     for (auto [id, inData] : mOperationNodesMap.value(srcId)->inputs().asKeyValueRange()) {
-        inputData.insert(id, new InputData(inData->type(), inData->pTextureId(), inData->blendFactor()->value()));
+        inputData.insert(id, new InputData(inData->type(), inData->pTextureId(), inData->blendFactor()->value(), inData->output()));
     }
     mCopiedInputData.insert(srcId, inputData);
 }
@@ -516,7 +482,21 @@ bool NodeManager::isOperationEnabled(QUuid id)
 
 EdgeWidget* NodeManager::addEdgeWidget(QUuid srcId, QUuid dstId, Number<float>* blendFactor)
 {
-    EdgeWidget* edgeWidget = new EdgeWidget(blendFactor, mOperationNodesMap.contains(srcId), mFactory);
+    // Outputs of source operation to choose from, if it has several
+
+    QStringList outputNames;
+    int output = 0;
+
+    if (mOperationNodesMap.contains(srcId) && mOperationNodesMap.contains(dstId))
+    {
+        outputNames = mOperationNodesMap.value(srcId)->operation()->outputNames();
+
+        if (mOperationNodesMap.value(dstId)->inputs().contains(srcId)) {
+            output = mOperationNodesMap.value(dstId)->inputs().value(srcId)->output();
+        }
+    }
+
+    EdgeWidget* edgeWidget = new EdgeWidget(blendFactor, mOperationNodesMap.contains(srcId), outputNames, output, mFactory);
 
     QUuid id = QUuid::createUuid();
 
@@ -533,6 +513,10 @@ EdgeWidget* NodeManager::addEdgeWidget(QUuid srcId, QUuid dstId, Number<float>*
         }
     });
 
+    connect(edgeWidget, &EdgeWidget::outputChanged, this, [=, this](int output) {
+        setOperationInputOutput(srcId, dstId, output);
+    });
+
     connect(edgeWidget, &EdgeWidget::operationInsert, this, [=, this](int index) {
         QUuid opId;
         mFactory->addAvailableOperation(index, opId);
@@ -671,6 +655,10 @@ void NodeManager::connectOperationWidget(OperationWidget* widget)
     connect(this, &NodeManager::midiEnabled, widget, &OperationWidget::toggleMidiButton);
 
     connect(widget, &OperationWidget::operationEdited, this, &NodeManager::operationEdited);
+    connect(widget, &OperationWidget::texFormatChanged, this, &NodeManager::operationTexturesChanged);
+    connect(widget, &OperationWidget::resolutionScaleChanged, this, &NodeManager::operationTexturesChanged);
+
+    connect(this, &NodeManager::statisticsReady, widget, &OperationWidget::updateStatistics);
 }
 
 
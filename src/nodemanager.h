@@ -36,6 +36,7 @@
 #include "seedwidget.h"
 #include "edgewidget.h"
 #include "midisignals.h"
+#include "operationsorter.h"
 
 #include <QObject>
 #include <QList>
@@ -63,6 +64,7 @@ public:
     void connectPastedNodes(QMap<QUuid, QUuid> isomorphism);
 
     void setOperationInputType(QUuid srcId, QUuid dstId, InputType type);
+    void setOperationInputOutput(QUuid srcId, QUuid dstId, int output);
 
     EdgeWidget* addEdgeWidget(QUuid srcId, QUuid dstId, Number<float>* blendFactor);
 
@@ -128,6 +130,8 @@ signals:
     void midiEnabled(bool enabled);
 
     void operationEdited(ImageOperation* operation);
+    void operationTexturesChanged(ImageOperation* operation);
+    void statisticsReady(ImageOperation* operation);
 
     void parameterValueChanged(QUuid id, QString operationName, QString parameterName, QString value);
 
@@ -141,6 +145,11 @@ private:
     Factory* mFactory;
 
     QMap<QUuid, ImageOperationNode*> mOperationNodesMap;
+
+    OperationSorter mSorter;
+    QList<ImageOperation*> mSortedOperations;
+    QList<QPair<QUuid, QString>> mSortedOperationsData;
+
     QMap<QUuid, Seed*> mSeedsMap;
 
     QMap<QUuid, ImageOperation*> mCopiedOperations;
@@ -0,0 +1,223 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include "operationbenchmark.h"
+#include "operationparser.h"
+
+#include <QDebug>
+#include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+
+
+
+OperationBenchmark::OperationBenchmark()
+{
+    mContext = new QOpenGLContext();
+    mContext->create();
+
+    mSurface = new QOffscreenSurface();
+    mSurface->setFormat(mContext->format());
+    mSurface->create();
+
+    mContext->makeCurrent(mSurface);
+
+    initializeOpenGLFunctions();
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    glGenFramebuffers(1, &mFbo);
+
+    // Full quad, as default orthographic projection expects
+
+    GLfloat vertCoords[] = {
+        -1.0f, -1.0f,
+        1.0f, -1.0f,
+        -1.0f, 1.0f,
+        1.0f, 1.0f
+    };
+
+    GLfloat texCoords[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f
+    };
+
+    glGenVertexArrays(1, &mVao);
+    glBindVertexArray(mVao);
+
+    glGenBuffers(1, &mVboPos);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboPos);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertCoords), vertCoords, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    glGenBuffers(1, &mVboTex);
+    glBindBuffer(GL_ARRAY_BUFFER, mVboTex);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(texCoords), texCoords, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    glGenQueries(1, &mTimeQuery);
+
+    mContext->doneCurrent();
+}
+
+
+
+OperationBenchmark::~OperationBenchmark()
+{
+    mContext->makeCurrent(mSurface);
+
+    glDeleteQueries(1, &mTimeQuery);
+    glDeleteBuffers(1, &mVboPos);
+    glDeleteBuffers(1, &mVboTex);
+    glDeleteVertexArrays(1, &mVao);
+    glDeleteFramebuffers(1, &mFbo);
+
+    mContext->doneCurrent();
+
+    delete mContext;
+    delete mSurface;
+}
+
+
+
+ImageOperation* OperationBenchmark::readOperation(QString filename)
+{
+    ImageOperation* operation = new ImageOperation();
+
+    OperationParser opParser;
+
+    if (!opParser.read(operation, filename, false))
+    {
+        delete operation;
+        return nullptr;
+    }
+
+    operation->init(mContext, mSurface);
+    operation->linkShaders();
+    operation->setAllParameters();
+
+    return operation;
+}
+
+
+
+double OperationBenchmark::time(ImageOperation* operation, int size)
+{
+    // Average GPU time per render, in milliseconds
+
+    mContext->makeCurrent(mSurface);
+
+    // Noise input: data-dependent shaders (sorting) get a representative load
+
+    QList<GLubyte> data(4 * size * size);
+
+    for (GLubyte& value : data) {
+        value = static_cast<GLubyte>(QRandomGenerator::global()->bounded(256));
+    }
+
+    GLuint inTexId = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &inTexId);
+    glTextureStorage2D(inTexId, 1, GL_RGBA8, size, size);
+    glTextureSubImage2D(inTexId, 0, 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, data.constData());
+
+    GLuint outTexId = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &outTexId);
+    glTextureStorage2D(outTexId, 1, GL_RGBA8, size, size);
+
+    operation->setAllocatedTextures(TextureFormat::RGBA8, size, size);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mFbo);
+    glBindVertexArray(mVao);
+    glViewport(0, 0, size, size);
+
+    operation->setInputResampled(false);
+
+    // Warm up: shader compilation and first use costs excluded
+
+    operation->renderPass(operation->numPasses(), inTexId, outTexId);
+
+    glBeginQuery(GL_TIME_ELAPSED, mTimeQuery);
+
+    for (int i = 0; i < mIterations; i++) {
+        operation->renderPass(operation->numPasses(), inTexId, outTexId);
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(mTimeQuery, GL_QUERY_RESULT, &elapsed);
+
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glDeleteTextures(1, &inTexId);
+    glDeleteTextures(1, &outTexId);
+
+    mContext->doneCurrent();
+
+    return elapsed * 1.0e-6 / mIterations;
+}
+
+
+
+void OperationBenchmark::run()
+{
+    // Fragment and compute variants of the same operation
+
+    QList<QPair<QString, QString>> pairs = {
+        { ":/operations/median.op", ":/operations/median_compute.op" },
+        { ":/operations/convolution.op", ":/operations/convolution_compute.op" }
+    };
+
+    QList<int> sizes = { 1024, 2048, 4096 };
+
+    foreach (auto pair, pairs)
+    {
+        ImageOperation* fragmentOp = readOperation(pair.first);
+        ImageOperation* computeOp = readOperation(pair.second);
+
+        if (fragmentOp && computeOp)
+        {
+            foreach (int size, sizes)
+            {
+                double fragmentTime = time(fragmentOp, size);
+                double computeTime = time(computeOp, size);
+
+                qInfo().noquote() << QString("%1 %2x%2: fragment %3 ms, compute %4 ms")
+                    .arg(fragmentOp->name()).arg(size).arg(fragmentTime, 0, 'f', 3).arg(computeTime, 0, 'f', 3);
+            }
+        }
+
+        delete fragmentOp;
+        delete computeOp;
+    }
+}
@@ -0,0 +1,68 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#ifndef OPERATIONBENCHMARK_H
+#define OPERATIONBENCHMARK_H
+
+
+
+#include "imageoperation.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+#include <QString>
+
+
+
+// Times fragment and compute variants of the same operation on GPU, at several texture sizes
+
+class OperationBenchmark : protected QOpenGLFunctions_4_5_Core
+{
+public:
+    OperationBenchmark();
+    ~OperationBenchmark();
+
+    void run();
+
+private:
+    QOpenGLContext* mContext = nullptr;
+    QOffscreenSurface* mSurface = nullptr;
+
+    GLuint mFbo = 0;
+    GLuint mVao = 0;
+    GLuint mVboPos = 0;
+    GLuint mVboTex = 0;
+    GLuint mTimeQuery = 0;
+
+    int mIterations = 50;
+
+    ImageOperation* readOperation(QString filename);
+    double time(ImageOperation* operation, int size);
+};
+
+
+
+#endif // OPERATIONBENCHMARK_H
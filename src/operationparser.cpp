@@ -78,13 +78,39 @@ void OperationParser::writeOperation(ImageOperation *operation, QXmlStreamWriter
 
     // Shaders: encoded in base64
 
-    stream.writeStartElement("vertex_shader");
-    stream.writeCharacters(QString::fromUtf8(operation->vertexShader().toUtf8().toBase64()));
-    stream.writeEndElement();
+    if (operation->isCompute())
+    {
+        stream.writeStartElement("compute_shader");
+        stream.writeAttribute("local_size_x", QString::number(operation->localSizeX()));
+        stream.writeAttribute("local_size_y", QString::number(operation->localSizeY()));
+        stream.writeAttribute("halo", QString::number(operation->halo()));
+        stream.writeCharacters(QString::fromUtf8(operation->computeShader().toUtf8().toBase64()));
+        stream.writeEndElement();
+    }
+    else
+    {
+        stream.writeStartElement("vertex_shader");
+        stream.writeCharacters(QString::fromUtf8(operation->vertexShader().toUtf8().toBase64()));
+        stream.writeEndElement();
 
-    stream.writeStartElement("fragment_shader");
-    stream.writeCharacters(QString::fromUtf8(operation->fragmentShader().toUtf8().toBase64()));
-    stream.writeEndElement();
+        stream.writeStartElement("fragment_shader");
+        stream.writeCharacters(QString::fromUtf8(operation->fragmentShader().toUtf8().toBase64()));
+        stream.writeEndElement();
+
+        // Passes preceding main one
+
+        foreach (RenderPass pass, operation->passes())
+        {
+            stream.writeStartElement("pass");
+            stream.writeAttribute("scale", QString::number(pass.scale));
+
+            stream.writeStartElement("fragment_shader");
+            stream.writeCharacters(QString::fromUtf8(pass.fragmentShader.toUtf8().toBase64()));
+            stream.writeEndElement();
+
+            stream.writeEndElement();
+        }
+    }
 
     // Sampler2D and Sampler2DArray
 
@@ -102,6 +128,57 @@ void OperationParser::writeOperation(ImageOperation *operation, QXmlStreamWriter
         stream.writeEndElement();
     }
 
+    if (!operation->sampler2DSourceName().isEmpty())
+    {
+        stream.writeStartElement("sampler2dsource");
+        stream.writeCharacters(operation->sampler2DSourceName());
+        stream.writeEndElement();
+    }
+
+    // Uniform block receiving input's statistics
+
+    if (!operation->statisticsBlockName().isEmpty())
+    {
+        stream.writeStartElement("statistics_block");
+        stream.writeCharacters(operation->statisticsBlockName());
+        stream.writeEndElement();
+    }
+
+    // Footprint: neighbourhood radius, if bounded
+
+    if (operation->footprintDeclared())
+    {
+        stream.writeStartElement("footprint");
+        stream.writeAttribute("radius", QString::number(operation->footprintRadius()));
+
+        foreach (QString uniformName, operation->footprintUniforms()) {
+            stream.writeTextElement("uniform", uniformName);
+        }
+
+        stream.writeEndElement();
+    }
+
+    // Pointwise: pure function of input colour
+
+    if (operation->pointwise()) {
+        stream.writeEmptyElement("pointwise");
+    }
+
+    // Extra outputs, main one not named
+
+    foreach (QString outputName, operation->outputNames()) {
+        stream.writeTextElement("output", outputName);
+    }
+
+    // Region: output black outside centred circle
+
+    if (!operation->regionRadiusUniform().isEmpty())
+    {
+        stream.writeEmptyElement("region");
+        stream.writeAttribute("shape", "circle");
+        stream.writeAttribute("radius", operation->regionRadiusUniform());
+    }
+
     // Parameters
 
     writeParameters<float>(operation, stream, writeIds);
@@ -117,7 +194,8 @@ void OperationParser::writeOperation(ImageOperation *operation, QXmlStreamWriter
 
 
 
-bool OperationParser::readOperation(ImageOperation* operation, QXmlStreamReader& stream, bool readIds)
+template<typename Stream>
+bool OperationParser::readOperation(ImageOperation* operation, Stream& stream, bool readIds)
 {
     // Operation
 
@@ -134,18 +212,60 @@ bool OperationParser::readOperation(ImageOperation* operation, QXmlStreamReader&
         operation->setSampler2DAvail(false);
         operation->setSampler2DArrayAvail(false);
 
+        operation->clearFootprint();
+        operation->setPointwise(false);
+        operation->setRegionRadiusUniform("");
+        operation->setOutputNames(QStringList());
+
+        operation->setComputeShader("");
+        operation->clearPasses();
+        operation->setSampler2DSourceName("");
+        operation->setStatisticsBlockName("");
+
         while (stream.readNextStartElement())
         {
             if (stream.name() == "vertex_shader")
             {
-                QString vertexShader = QString::fromUtf8(QByteArray::fromBase64(stream.readElementText().toUtf8()));
+                QString vertexShader = readShader(stream);
                 operation->setVertexShader(vertexShader);
             }
             else if (stream.name() == "fragment_shader")
             {
-                QString fragmentShader = QString::fromUtf8(QByteArray::fromBase64(stream.readElementText().toUtf8()));
+                QString fragmentShader = readShader(stream);
                 operation->setFragmentShader(fragmentShader);
             }
+            else if (stream.name() == "compute_shader")
+            {
+                GLuint localSizeX = stream.attributes().value("local_size_x").toUInt();
+                GLuint localSizeY = stream.attributes().value("local_size_y").toUInt();
+                int halo = stream.attributes().value("halo").toInt();
+
+                QString computeShader = readShader(stream);
+
+                operation->setComputeShader(computeShader);
+                operation->setLocalSize(localSizeX, localSizeY);
+                operation->setHalo(halo);
+            }
+            else if (stream.name() == "pass")
+            {
+                RenderPass pass;
+
+                if (stream.attributes().hasAttribute("scale")) {
+                    pass.scale = stream.attributes().value("scale").toFloat();
+                }
+
+                while (stream.readNextStartElement())
+                {
+                    if (stream.name() == "fragment_shader") {
+                        pass.fragmentShader = readShader(stream);
+                    }
+                    else {
+                        stream.skipCurrentElement();
+                    }
+                }
+
+                operation->addPass(pass);
+            }
             else if (stream.name() == "sampler2d")
             {
                 QString sampler2DName = stream.readElementText();
@@ -158,6 +278,50 @@ bool OperationParser::readOperation(ImageOperation* operation, QXmlStreamReader&
                 operation->setSampler2DArrayName(sampler2DArrayName);
                 operation->setSampler2DArrayAvail(true);
             }
+            else if (stream.name() == "sampler2dsource")
+            {
+                QString sampler2DSourceName = stream.readElementText();
+                operation->setSampler2DSourceName(sampler2DSourceName);
+            }
+            else if (stream.name() == "statistics_block")
+            {
+                QString statisticsBlockName = stream.readElementText();
+                operation->setStatisticsBlockName(statisticsBlockName);
+            }
+            else if (stream.name() == "footprint")
+            {
+                int radius = stream.attributes().value("radius").toInt();
+                QStringList uniforms;
+
+                while (stream.readNextStartElement())
+                {
+                    if (stream.name() == "uniform") {
+                        uniforms.append(stream.readElementText());
+                    }
+                    else {
+                        stream.skipCurrentElement();
+                    }
+                }
+
+                operation->setFootprint(radius, uniforms);
+            }
+            else if (stream.name() == "pointwise")
+            {
+                operation->setPointwise(true);
+                stream.skipCurrentElement();
+            }
+            else if (stream.name() == "output")
+            {
+                operation->setOutputNames(operation->outputNames() << stream.readElementText());
+            }
+            else if (stream.name() == "region")
+            {
+                if (stream.attributes().value("shape") == "circle") {
+                    operation->setRegionRadiusUniform(stream.attributes().value("radius").toString());
+                }
+
+                stream.skipCurrentElement();
+            }
             else if (stream.name() == "parameter")
             {
                 QString paramType = stream.attributes().value("type").toString();
@@ -265,8 +429,8 @@ void OperationParser::writeParameters(ImageOperation* operation, QXmlStreamWrite
 
 
 
-template<typename T>
-void OperationParser::readParameters(ImageOperation* operation, QXmlStreamReader& stream, bool readIds)
+template<typename T, typename Stream>
+void OperationParser::readParameters(ImageOperation* operation, Stream& stream, bool readIds)
 {
     QString paramName = stream.attributes().value("name").toString();
     bool editable = stream.attributes().value("editable").toInt();
@@ -457,7 +621,8 @@ void OperationParser::writeMat4Parameters(ImageOperation* operation, QXmlStreamW
 
 
 
-void OperationParser::readMat4Parameters(ImageOperation* operation, QXmlStreamReader& stream, bool readIds)
+template<typename Stream>
+void OperationParser::readMat4Parameters(ImageOperation* operation, Stream& stream, bool readIds)
 {
     QString paramName = stream.attributes().value("name").toString();
     bool editable = stream.attributes().value("editable").toInt();
@@ -579,7 +744,8 @@ void OperationParser::writeOptionsParameters(ImageOperation* operation, QXmlStre
 
 
 
-void OperationParser::readOptionsParameters(ImageOperation* operation, QXmlStreamReader& stream)
+template<typename Stream>
+void OperationParser::readOptionsParameters(ImageOperation* operation, Stream& stream)
 {
     QString paramName = stream.attributes().value("name").toString();
     bool editable = stream.attributes().value("editable").toInt();
@@ -606,3 +772,22 @@ void OperationParser::readOptionsParameters(ImageOperation* operation, QXmlStrea
 
     operation->addOptionsParameter<GLenum>(parameter);
 }
+
+
+
+QString OperationParser::readShader(QXmlStreamReader& stream)
+{
+    return QString::fromUtf8(QByteArray::fromBase64(stream.readElementText().toUtf8()));
+}
+
+
+
+QString OperationParser::readShader(BinaryConfigReader& stream)
+{
+    return stream.readShader();
+}
+
+
+
+template bool OperationParser::readOperation<QXmlStreamReader>(ImageOperation* operation, QXmlStreamReader& stream, bool readIds);
+template bool OperationParser::readOperation<BinaryConfigReader>(ImageOperation* operation, BinaryConfigReader& stream, bool readIds);
@@ -4,6 +4,7 @@
 
 
 #include "imageoperation.h"
+#include "binaryconfig.h"
 
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
@@ -19,19 +20,28 @@ public:
     bool read(ImageOperation* operation, QString filename, bool readIds);
 
     void writeOperation(ImageOperation* operation, QXmlStreamWriter& stream, bool writeIds);
-    bool readOperation(ImageOperation* operation, QXmlStreamReader& stream, bool readIds);
+    // Readers take either a QXmlStreamReader or a BinaryConfigReader
+
+    template<typename Stream>
+    bool readOperation(ImageOperation* operation, Stream& stream, bool readIds);
 
     void writeMat4Parameters(ImageOperation* operation, QXmlStreamWriter& stream, bool writeIds);
-    void readMat4Parameters(ImageOperation* operation, QXmlStreamReader& stream, bool readIds);
+    template<typename Stream>
+    void readMat4Parameters(ImageOperation* operation, Stream& stream, bool readIds);
 
     void writeOptionsParameters(ImageOperation* operation, QXmlStreamWriter& stream);
-    void readOptionsParameters(ImageOperation* operation, QXmlStreamReader& stream);
+    template<typename Stream>
+    void readOptionsParameters(ImageOperation* operation, Stream& stream);
 
     template<typename T>
     void writeParameters(ImageOperation* operation, QXmlStreamWriter& stream, bool writeIds);
 
-    template<typename T>
-    void readParameters(ImageOperation* operation, QXmlStreamReader& stream, bool readIds);
+    template<typename T, typename Stream>
+    void readParameters(ImageOperation* operation, Stream& stream, bool readIds);
+
+private:
+    static QString readShader(QXmlStreamReader& stream);
+    static QString readShader(BinaryConfigReader& stream);
 };
 
 
@@ -0,0 +1,121 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "operationsorter.h"
+
+#include <algorithm>
+#include <climits>
+
+
+
+void OperationSorter::sort(const QMap<QUuid, ImageOperationNode*>& nodes)
+{
+    // Normal inputs pending per node, isolated nodes discarded
+    // First level: nodes whose inputs are all blit or seed, or with no inputs but some outputs
+
+    QHash<QUuid, int> pending;
+    QList<ImageOperationNode*> wavefront;
+
+    foreach (ImageOperationNode* node, nodes)
+    {
+        if (node->numInputs() == 0 && node->numOutputs() == 0) {
+            continue;
+        }
+
+        int numNormalInputs = node->numInputs() - node->numNonNormalInputs();
+
+        pending.insert(node->id(), numNormalInputs);
+
+        if (numNormalInputs == 0) {
+            wavefront.append(node);
+        }
+    }
+
+    // Kahn's algorithm one level at a time, visiting each node and edge once
+    // Nodes in cycles of normal edges, and those after them, never get all inputs done and are left out
+
+    auto previousPosition = [this](ImageOperationNode* node1, ImageOperationNode* node2) {
+        return mPositions.value(node1->id(), INT_MAX) < mPositions.value(node2->id(), INT_MAX);
+    };
+
+    QList<ImageOperationNode*> sortedNodes;
+    QList<int> levels;
+
+    int level = 0;
+
+    while (!wavefront.isEmpty())
+    {
+        std::stable_sort(wavefront.begin(), wavefront.end(), previousPosition);
+
+        QList<ImageOperationNode*> nextWavefront;
+
+        foreach (ImageOperationNode* node, wavefront)
+        {
+            sortedNodes.append(node);
+            levels.append(level);
+
+            foreach (ImageOperationNode* outputNode, node->outputNodes())
+            {
+                InputData* input = outputNode->inputs().value(node->id(), nullptr);
+
+                if (input && input->type() == InputType::Normal && --pending[outputNode->id()] == 0) {
+                    nextWavefront.append(outputNode);
+                }
+            }
+        }
+
+        wavefront = nextWavefront;
+        level++;
+    }
+
+    mSortedNodes = sortedNodes;
+    mLevels = levels;
+
+    mPositions.clear();
+
+    for (int i = 0; i < mSortedNodes.size(); i++) {
+        mPositions.insert(mSortedNodes[i]->id(), i);
+    }
+}
+
+
+
+QList<ImageOperationNode*> OperationSorter::sortedNodes() const
+{
+    return mSortedNodes;
+}
+
+
+
+QList<int> OperationSorter::levels() const
+{
+    return mLevels;
+}
+
+
+
+int OperationSorter::numLevels() const
+{
+    return mLevels.isEmpty() ? 0 : mLevels.last() + 1;
+}
@@ -0,0 +1,61 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef OPERATIONSORTER_H
+#define OPERATIONSORTER_H
+
+
+
+#include "imageoperationnode.h"
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QUuid>
+
+
+
+// Topological order of operation nodes by levels: operations of a level depend only on those of previous ones
+
+class OperationSorter
+{
+public:
+    void sort(const QMap<QUuid, ImageOperationNode*>& nodes);
+
+    QList<ImageOperationNode*> sortedNodes() const;
+    QList<int> levels() const;
+    int numLevels() const;
+
+private:
+    QList<ImageOperationNode*> mSortedNodes;
+    QList<int> mLevels;
+
+    // Positions in last order, kept within levels so that edits move as few operations as possible
+
+    QHash<QUuid, int> mPositions;
+};
+
+
+
+#endif // OPERATIONSORTER_H
@@ -65,6 +65,36 @@ OperationWidget::OperationWidget(QUuid id, ImageOperation* operation, bool midiE
 
     connect(mAvailOpsMenu, &QMenu::triggered, this, &OperationWidget::replaceOperation);
 
+    // Texture format action and menu
+
+    texFormatAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/color-chooser.png")), "Texture format", this, &OperationWidget::populateTexFormatMenu);
+    mTexFormatMenu = new QMenu("Texture format");
+    texFormatAction->setMenu(mTexFormatMenu);
+
+    connect(mTexFormatMenu, &QMenu::triggered, this, &OperationWidget::setTexFormat);
+
+    // Resolution scale action and menu
+
+    resolutionAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/zoom-in.png")), "Resolution", this, &OperationWidget::populateResolutionMenu);
+    mResolutionMenu = new QMenu("Resolution");
+    resolutionAction->setMenu(mResolutionMenu);
+
+    connect(mResolutionMenu, &QMenu::triggered, this, &OperationWidget::setResolutionScale);
+
+    // Update interval action and menu: render every few iterations
+
+    updateAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/emblem-synchronized.png")), "Update interval", this, &OperationWidget::populateUpdateMenu);
+    mUpdateMenu = new QMenu("Update interval");
+    updateAction->setMenu(mUpdateMenu);
+
+    connect(mUpdateMenu, &QMenu::triggered, this, &OperationWidget::setUpdateInterval);
+
+    // Statistics action: output statistics computed on GPU, shown below header
+
+    statisticsAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/office-chart-area-stacked.png")), "Statistics", this, &OperationWidget::toggleStatistics);
+    statisticsAction->setCheckable(true);
+    statisticsAction->setChecked(mOperation->statisticsEnabled());
+
     // Edit action
 
     editAction = headerToolBar->addAction(QIcon(QPixmap(":/icons/applications-development.png")), "Edit", this, &OperationWidget::toggleEditMode);
@@ -117,6 +147,7 @@ OperationWidget::OperationWidget(QUuid id, ImageOperation* operation, bool midiE
     connect(opNameLineEdit, &QLineEdit::textEdited, this, [=, this](QString name){
         operation->setName(name);
         opNameLabel->setText(name);
+        setWindowTitle(name);
 
         opNameLineEdit->setFixedWidth(20 + opNameLineEdit->fontMetrics().horizontalAdvance(name));
 
@@ -132,6 +163,43 @@ OperationWidget::OperationWidget(QUuid id, ImageOperation* operation, bool midiE
     headerLayout->addWidget(opNameLineEdit, 0, Qt::AlignLeft | Qt::AlignVCenter);
     headerLayout->addWidget(headerToolBar, 0, Qt::AlignLeft | Qt::AlignVCenter);
 
+    // Statistics label
+
+    statisticsLabel = new QLabel;
+    statisticsLabel->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+    statisticsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    statisticsLabel->setVisible(mOperation->statisticsEnabled());
+
+    headerLayout->addWidget(statisticsLabel, 0, Qt::AlignLeft | Qt::AlignVCenter);
+
+    // Substeps: iterations per frame of this operation, each reading previous one's output
+
+    QLabel* substepsLabel = new QLabel("Substeps");
+    substepsLabel->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+
+    substepsLineEdit = new FocusLineEdit;
+    substepsLineEdit->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+    substepsLineEdit->setMaximumWidth(50);
+
+    substepsLineEdit->setValidator(new QIntValidator(1, 64, substepsLineEdit));
+
+    substepsSlider = new QSlider(Qt::Horizontal);
+    substepsSlider->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Maximum);
+
+    substepsMidiButton = new QPushButton;
+    substepsMidiButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+    substepsMidiButton->setCheckable(true);
+    substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-grey.png); background-color: transparent; border: 0; }");
+
+    QHBoxLayout* substepsLayout = new QHBoxLayout;
+    substepsLayout->setContentsMargins(5, 0, 5, 0);
+    substepsLayout->addWidget(substepsLabel);
+    substepsLayout->addWidget(substepsLineEdit);
+    substepsLayout->addWidget(substepsSlider, 1);
+    substepsLayout->addWidget(substepsMidiButton);
+
+    headerLayout->addLayout(substepsLayout);
+
     headerWidget->setLayout(headerLayout);
 
     mainLayout->addWidget(headerWidget);
@@ -274,6 +342,9 @@ OperationWidget::~OperationWidget()
 {
     delete mOpBuilder;
     qDeleteAll(mAvailOpsActions);
+    delete mTexFormatMenu;
+    delete mResolutionMenu;
+    delete mUpdateMenu;
 }
 
 
@@ -400,6 +471,7 @@ void OperationWidget::setup()
     // Operation name controls
 
     opNameLabel->setText(mOperation->name());
+    setWindowTitle(mOperation->name());
 
     opNameLineEdit->setText(mOperation->name());
     opNameLineEdit->setFixedWidth(20 + opNameLineEdit->fontMetrics().horizontalAdvance(mOperation->name()));
@@ -408,6 +480,10 @@ void OperationWidget::setup()
 
     midiLinkButton->setVisible(mMidiEnabled);
 
+    // Substeps widgets, bound to current operation
+
+    connectSubstepsWidgets();
+
     // Once widgets set on grid, optimize its layout to set it with proper row and column spans and sizes
     // Operation widget must be visible: show it
 
@@ -720,11 +796,79 @@ void OperationWidget::toggleOutputAction(QUuid id)
 void OperationWidget::toggleMidiButton(bool show)
 {
     midiLinkButton->setVisible(show);
+    substepsMidiButton->setVisible(show);
     mMidiEnabled = show;
 }
 
 
 
+void OperationWidget::connectSubstepsWidgets()
+{
+    Number<int>* number = mOperation->substepsNumber();
+
+    foreach (auto conn, substepsConns) {
+        disconnect(conn);
+    }
+
+    substepsConns.clear();
+
+    substepsLineEdit->setText(QString::number(number->value()));
+
+    substepsSlider->setRange(0, number->indexMax());
+    substepsSlider->setValue(number->index());
+
+    substepsMidiButton->setVisible(mMidiEnabled);
+    substepsMidiButton->setChecked(number->midiLinked());
+
+    if (number->midiLinked()) {
+        substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-green.png); background-color: transparent; border: 0; }");
+    } else {
+        substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-grey.png); background-color: transparent; border: 0; }");
+    }
+
+    substepsConns.append(connect(substepsSlider, &QAbstractSlider::sliderMoved, number, &Number<int>::setValueFromIndex));
+
+    substepsConns.append(connect(number, &Number<int>::indexChanged, substepsSlider, &QAbstractSlider::setValue));
+
+    substepsConns.append(connect(number, &Number<int>::valueChanged, this, [=, this](QVariant value){
+        substepsLineEdit->setText(QString::number(value.toInt()));
+        number->setIndex();
+    }));
+
+    substepsConns.append(connect(substepsLineEdit, &QLineEdit::returnPressed, this, [=, this](){
+        number->setValue(substepsLineEdit->text().toInt());
+    }));
+
+    substepsConns.append(connect(substepsLineEdit, &FocusLineEdit::focusOut, this, [=, this](){
+        substepsLineEdit->setText(QString::number(number->value()));
+    }));
+
+    substepsConns.append(connect(substepsMidiButton, &QPushButton::clicked, this, [=, this](bool checked){
+        if (checked)
+        {
+            substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-orange.png); background-color: transparent; border: 0; }");
+            emit mMidiSignals->linkWait(number);
+        }
+        else
+        {
+            substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-grey.png); background-color: transparent; border: 0; }");
+            emit mMidiSignals->linkBreak(number);
+        }
+    }));
+
+    substepsConns.append(connect(number, &Number<int>::linked, this, [=, this](bool set){
+        if (set) {
+            substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-green.png); background-color: transparent; border: 0; }");
+        } else {
+            substepsMidiButton->setStyleSheet("QPushButton { image: url(:/icons/circle-grey.png); background-color: transparent; border: 0; }");
+        }
+
+        substepsSlider->setRange(0, number->indexMax());
+    }));
+}
+
+
+
 QUuid OperationWidget::id()
 {
     return mId;
@@ -1362,3 +1506,166 @@ void OperationWidget::replaceOperation(QAction* action)
         recreate();
     }
 }
+
+
+
+void OperationWidget::populateTexFormatMenu()
+{
+    mTexFormatMenu->clear();
+
+    // Inherit action carries no format data
+
+    QAction* inheritAction = mTexFormatMenu->addAction("Inherit");
+    inheritAction->setCheckable(true);
+    inheritAction->setChecked(mOperation->texFormatInherited());
+
+    mTexFormatMenu->addSeparator();
+
+    foreach (TextureFormat format, mFactory->supportedTexFormats())
+    {
+        QAction* action = mTexFormatMenu->addAction(textureFormatToString(format));
+        action->setData(static_cast<int>(format));
+        action->setCheckable(true);
+        action->setChecked(!mOperation->texFormatInherited() && mOperation->texFormat() == format);
+    }
+
+    mTexFormatMenu->exec(QCursor::pos());
+}
+
+
+
+void OperationWidget::setTexFormat(QAction* action)
+{
+    if (action->data().isValid())
+    {
+        mOperation->setTexFormatInherited(false);
+        mOperation->setTexFormat(static_cast<TextureFormat>(action->data().toInt()));
+    }
+    else
+    {
+        mOperation->setTexFormatInherited(true);
+    }
+
+    emit texFormatChanged(mOperation);
+}
+
+
+
+void OperationWidget::populateResolutionMenu()
+{
+    mResolutionMenu->clear();
+
+    QList<QPair<QString, float>> scales = {
+        { "2x (supersample)", 2.0f },
+        { "1", 1.0f },
+        { "1/2", 0.5f },
+        { "1/4", 0.25f }
+    };
+
+    for (auto [name, scale] : scales)
+    {
+        QAction* action = mResolutionMenu->addAction(name);
+        action->setData(scale);
+        action->setCheckable(true);
+        action->setChecked(qFuzzyCompare(mOperation->resolutionScale(), scale));
+    }
+
+    mResolutionMenu->exec(QCursor::pos());
+}
+
+
+
+void OperationWidget::setResolutionScale(QAction* action)
+{
+    mOperation->setResolutionScale(action->data().toFloat());
+
+    emit resolutionScaleChanged(mOperation);
+}
+
+
+
+void OperationWidget::populateUpdateMenu()
+{
+    mUpdateMenu->clear();
+
+    // Action data: interval and phase, negative phase meaning automatic
+
+    int interval = mOperation->updateInterval();
+    int phase = mOperation->updatePhase();
+
+    foreach (int value, QList<int>({ 1, 2, 3, 4, 6, 8, 12, 16 }))
+    {
+        QAction* action = mUpdateMenu->addAction(value == 1 ? QString("Every iteration") : QString("Every %1 iterations").arg(value));
+        action->setData(QPoint(value, -1));
+        action->setCheckable(true);
+        action->setChecked(interval == value);
+    }
+
+    if (interval > 1)
+    {
+        mUpdateMenu->addSeparator();
+
+        QAction* autoAction = mUpdateMenu->addAction("Automatic phase");
+        autoAction->setData(QPoint(interval, -1));
+        autoAction->setCheckable(true);
+        autoAction->setChecked(phase < 0);
+
+        for (int value = 0; value < interval; value++)
+        {
+            QAction* action = mUpdateMenu->addAction(QString("Phase %1").arg(value));
+            action->setData(QPoint(interval, value));
+            action->setCheckable(true);
+            action->setChecked(phase == value);
+        }
+    }
+
+    mUpdateMenu->exec(QCursor::pos());
+}
+
+
+
+void OperationWidget::setUpdateInterval(QAction* action)
+{
+    QPoint data = action->data().toPoint();
+
+    mOperation->setUpdateInterval(data.x(), data.y());
+}
+
+
+
+void OperationWidget::toggleStatistics(bool checked)
+{
+    mOperation->setStatisticsEnabled(checked);
+
+    statisticsLabel->clear();
+    statisticsLabel->setVisible(checked);
+
+    headerWidget->adjustSize();
+    adjustSize();
+}
+
+
+
+void OperationWidget::updateStatistics(ImageOperation* operation)
+{
+    if (operation != mOperation || !statisticsLabel->isVisible()) {
+        return;
+    }
+
+    ImageStatistics statistics = mOperation->statistics();
+
+    auto row = [](QString name, QVector4D values) {
+        return QString("%1 %2 %3 %4 %5").arg(name, -8)
+            .arg(values.x(), 6, 'f', 3).arg(values.y(), 6, 'f', 3).arg(values.z(), 6, 'f', 3).arg(values.w(), 6, 'f', 3);
+    };
+
+    QStringList lines = {
+        QString("%1 %2 %3 %4 %5").arg("", -8).arg("R", 6).arg("G", 6).arg("B", 6).arg("L", 6),
+        row("Mean", statistics.mean),
+        row("Min", statistics.minimum),
+        row("Max", statistics.maximum),
+        row("Variance", statistics.variance)
+    };
+
+    statisticsLabel->setText(lines.join("\n"));
+}
@@ -51,6 +51,7 @@
 #include <QAction>
 #include <QUuid>
 #include <QMenu>
+#include <QFontDatabase>
 
 
 
@@ -79,12 +80,15 @@ signals:
     void equalizeBlendFactors(QUuid id);
     void copy(QUuid id);
     void operationEdited(ImageOperation* operation);
+    void texFormatChanged(ImageOperation* operation);
+    void resolutionScaleChanged(ImageOperation* operation);
 
 public slots:
     void recreate();
     void toggleOutputAction(QUuid id);
     void toggleMidiButton(bool show);
     void toggleEditMode(bool mode);
+    void updateStatistics(ImageOperation* operation);
 
 protected:
     void closeEvent(QCloseEvent* event) override;
@@ -109,15 +113,30 @@ private:
     QAction* enableAction;
     QAction* outputAction;
     QAction* replaceOpAction;
+    QAction* texFormatAction;
+    QAction* resolutionAction;
+    QAction* updateAction;
+    QAction* statisticsAction;
     QAction* editAction;
     QAction* toggleBodyAction;
 
     QMenu* mAvailOpsMenu;
     QList<QAction*> mAvailOpsActions;
 
+    QMenu* mTexFormatMenu;
+    QMenu* mResolutionMenu;
+    QMenu* mUpdateMenu;
+
     QLabel* opNameLabel;
     QLineEdit* opNameLineEdit;
 
+    QLabel* statisticsLabel;
+
+    FocusLineEdit* substepsLineEdit;
+    QSlider* substepsSlider;
+    QPushButton* substepsMidiButton;
+    QList<QMetaObject::Connection> substepsConns;
+
     GridWidget* gridWidget;
 
     QWidget* selParamWidget;
@@ -208,6 +227,8 @@ private:
 
     void toggleSelParamWidgets(bool visible);
 
+    void connectSubstepsWidgets();
+
     void addInterpolation();
     void removeInterpolation();
 
@@ -217,6 +238,13 @@ private slots:
     void enableOperation(bool checked);
     void populateAvailOpsMenu();
     void replaceOperation(QAction* action);
+    void populateTexFormatMenu();
+    void setTexFormat(QAction* action);
+    void populateResolutionMenu();
+    void setResolutionScale(QAction* action);
+    void populateUpdateMenu();
+    void setUpdateInterval(QAction* action);
+    void toggleStatistics(bool checked);
 };
 
 
@@ -150,6 +150,12 @@ void OutputWindow::keyPressEvent(QKeyEvent* event)
         else if (event->key() == Qt::Key_Space) {
             emit resetIterations();
         }
+        else if (event->key() >= Qt::Key_1 && event->key() <= Qt::Key_9) {
+            emit presetSelected(event->key() - Qt::Key_1);
+        }
+        else if (event->key() == Qt::Key_0) {
+            emit nextPresetSelected();
+        }
     }
     else if (event->modifiers() == (Qt::ControlModifier | Qt::ShiftModifier) && event->key() == Qt::Key_Space) {
         emit startPauseIts();
@@ -440,13 +446,14 @@ void OutputWindow::getSupportedTexFormats()
         TextureFormat::RGBA4,
         TextureFormat::RGBA8,
         //TextureFormat::RGBA8_SNORM,
-        //TextureFormat::RGB10_A2,
+        TextureFormat::RGB10_A2,
         //TextureFormat::RGB10_A2UI,
         TextureFormat::RGBA12,
         //TextureFormat::SRGB8_ALPHA8,
         TextureFormat::RGBA16,
         TextureFormat::RGBA16F,
-        TextureFormat::RGBA32F
+        TextureFormat::RGBA32F,
+        TextureFormat::R11F_G11F_B10F
         //TextureFormat::RGBA8I,
         //TextureFormat::RGBA8UI,
         //TextureFormat::RGBA16I,
@@ -73,6 +73,8 @@ signals:
     void record();
     void resetIterations();
     void startPauseIts();
+    void presetSelected(int index);
+    void nextPresetSelected();
 
     void closing();
 
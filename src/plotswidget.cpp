@@ -26,7 +26,10 @@
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QPushButton>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDir>
+#include <algorithm>
 
 
 
@@ -37,7 +40,7 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
     mTexWidth = mRenderManager->texWidth();
     mTexHeight = mRenderManager->texHeight();
 
-    rgbWidget = new RGBWidget(mTexWidth, mTexHeight);
+    rgbWidget = new RGBWidget();
 
     selectPathComboBox = new QComboBox;
     selectPathComboBox->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
@@ -57,6 +60,32 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
     QPushButton* removePathButton = new QPushButton(QIcon(QPixmap(":/icons/list-remove.png")), "");
     removePathButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
 
+    // Probe patterns: many paths at once, all sampled in a single GPU pass
+
+    QPushButton* patternButton = new QPushButton(QIcon(QPixmap(":/icons/format-list-ordered.png")), "");
+    patternButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+
+    QMenu* patternMenu = new QMenu(patternButton);
+    patternMenu->addAction("Grid 8x8")->setData(0);
+    patternMenu->addAction("Grid 32x32")->setData(1);
+    patternMenu->addAction("Line 256")->setData(2);
+    patternMenu->addAction("Random 1024")->setData(3);
+    patternButton->setMenu(patternMenu);
+
+    connect(patternMenu, &QMenu::triggered, this, &PlotsWidget::addProbePattern);
+
+    recordButton = new QPushButton(QIcon(QPixmap(":/icons/media-record.png")), "");
+    recordButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+    recordButton->setCheckable(true);
+    recordButton->setToolTip("Record probe values");
+
+    QPushButton* exportButton = new QPushButton(QIcon(QPixmap(":/icons/document-save.png")), "");
+    exportButton->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
+    exportButton->setToolTip("Export probe record as CSV");
+
+    connect(recordButton, &QPushButton::toggled, this, &PlotsWidget::toggleProbeRecording);
+    connect(exportButton, &QPushButton::clicked, this, &PlotsWidget::exportProbeRecording);
+
     xCoordLineEdit = new QLineEdit;
     xCoordValidator = new QIntValidator(0, mTexWidth - 1, xCoordLineEdit);
     xCoordLineEdit->setValidator(xCoordValidator);
@@ -78,6 +107,9 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
     controlsLayout->addWidget(numItsLineEdit);
     controlsLayout->addWidget(addPathButton);
     controlsLayout->addWidget(removePathButton);
+    controlsLayout->addWidget(patternButton);
+    controlsLayout->addWidget(recordButton);
+    controlsLayout->addWidget(exportButton);
     controlsLayout->addWidget(selectPathComboBox);
     controlsLayout->addWidget(xCoordLineEdit);
     controlsLayout->addWidget(yCoordLineEdit);
@@ -90,6 +122,7 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
     connect(enableButton, &QPushButton::toggled, this, [&](bool checked) {
         rgbWidget->setUpdatesEnabled(checked);
         enabled = checked;
+        setProbes();
     });
     connect(addPathButton, &QPushButton::clicked, this, &PlotsWidget::addColorPath);
     connect(removePathButton, &QPushButton::clicked, this, &PlotsWidget::removeColorPath);
@@ -98,6 +131,28 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
 
     connect(numItsLineEdit, &QLineEdit::editingFinished, this, &PlotsWidget::setNumIts);
 
+    connect(mRenderManager, &RenderManager::probesRead, this, &PlotsWidget::addProbeValues);
+
+    // Recorder thread
+
+    recorderThread = new QThread(this);
+    probeRecorder = new ProbeRecorder;
+    probeRecorder->moveToThread(recorderThread);
+
+    connect(recorderThread, &QThread::finished, probeRecorder, &QObject::deleteLater);
+    connect(this, &PlotsWidget::startProbeRecording, probeRecorder, &ProbeRecorder::start);
+    connect(this, &PlotsWidget::stopProbeRecording, probeRecorder, &ProbeRecorder::stop);
+    connect(this, &PlotsWidget::exportProbeRecord, probeRecorder, &ProbeRecorder::exportCsv);
+    connect(mRenderManager, &RenderManager::probesRead, probeRecorder, &ProbeRecorder::append);
+    connect(probeRecorder, &ProbeRecorder::error, this, [=, this](QString message) {
+        QMessageBox::warning(this, "Probe recorder", message);
+    });
+    connect(probeRecorder, &ProbeRecorder::exported, this, [=, this](QString csvFilename) {
+        QMessageBox::information(this, "Probe recorder", "Exported " + csvFilename);
+    });
+
+    recorderThread->start();
+
     setSize(mRenderManager->texWidth(), mRenderManager->texHeight());
 
     cursor.setX(mTexWidth / 2);
@@ -117,6 +172,11 @@ PlotsWidget::PlotsWidget(RenderManager*renderManager, QWidget* parent) :
 
 PlotsWidget::~PlotsWidget()
 {
+    // Recorder flushes and closes its file on deletion
+
+    recorderThread->quit();
+    recorderThread->wait();
+
     delete rgbWidget;
 
     // delete context;
@@ -150,6 +210,9 @@ void PlotsWidget::setCoords()
     int index = selectPathComboBox->currentIndex();
 
     colorPaths[index].setSource(source);
+    sources[index] = source;
+
+    setProbes();
 
     cursor = colorPaths[index].source();
 
@@ -161,17 +224,6 @@ void PlotsWidget::updatePlots()
 {
     if (enabled)
     {
-        setPixelRGB();
-
-        foreach (ColorPath path, colorPaths)
-        {
-            if (!path.linesEmpty())
-            {
-                rgbWidget->setNumVertices(numVertices);
-                rgbWidget->setLines(allVertices);
-            }
-        }
-
         rgbWidget->update();
     }
 }
@@ -196,13 +248,6 @@ void PlotsWidget::setSize(int width, int height)
 
     xCoordValidator->setTop(width - 1);
     yCoordValidator->setTop(height - 1);
-
-    if (rgbWidget->isValid())
-    {
-        rgbWidget->makeCurrent();
-        rgbWidget->setupBuffer(width, height);
-        rgbWidget->doneCurrent();
-    }
 }
 
 
@@ -219,6 +264,8 @@ void PlotsWidget::setSelectedPoint(QPoint point)
         sources[index] = point;
         xCoordLineEdit->setText(QString::number(point.x()));
         yCoordLineEdit->setText(QString::number(point.y()));
+
+        setProbes();
     }
 }
 
@@ -239,6 +286,8 @@ void PlotsWidget::transformSources(QTransform transform)
         checkPoint(source);
     }
 
+    setProbes();
+
     setControls(selectPathComboBox->currentIndex());
 }
 
@@ -264,19 +313,80 @@ void PlotsWidget::checkPoint(QPoint &point)
 
 void PlotsWidget::addColorPath()
 {
-    colorPaths.append(ColorPath(cursor, numIts));
+    colorPaths.append(ColorPath(cursor, takeRegion(), pathCapacity));
 
     sources.append(cursor);
 
+    reservePaths();
+
     selectPathComboBox->addItem(QString::number(colorPaths.size()));
     int index = selectPathComboBox->count() - 1;
     selectPathComboBox->setCurrentIndex(index);
 
+    setProbes();
+
     setControls(index);
 }
 
 
 
+void PlotsWidget::addColorPaths(QList<QPoint> points)
+{
+    for (QPoint point : points)
+    {
+        checkPoint(point);
+
+        colorPaths.append(ColorPath(point, takeRegion(), pathCapacity));
+        sources.append(point);
+
+        selectPathComboBox->addItem(QString::number(colorPaths.size()));
+    }
+
+    reservePaths();
+
+    setProbes();
+}
+
+
+
+void PlotsWidget::addProbePattern(QAction* action)
+{
+    QList<QPoint> points;
+
+    int pattern = action->data().toInt();
+
+    if (pattern == 0 || pattern == 1)
+    {
+        // Regular grid over whole image
+
+        int n = pattern == 0 ? 8 : 32;
+
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i < n; i++) {
+                points.append(QPoint((2 * i + 1) * mTexWidth / (2 * n), (2 * j + 1) * mTexHeight / (2 * n)));
+            }
+        }
+    }
+    else if (pattern == 2)
+    {
+        // Horizontal line through cursor
+
+        for (int i = 0; i < 256; i++) {
+            points.append(QPoint((2 * i + 1) * mTexWidth / 512, cursor.y()));
+        }
+    }
+    else if (pattern == 3)
+    {
+        for (int i = 0; i < 1024; i++) {
+            points.append(QPoint(QRandomGenerator::global()->bounded(static_cast<int>(mTexWidth)), QRandomGenerator::global()->bounded(static_cast<int>(mTexHeight))));
+        }
+    }
+
+    addColorPaths(points);
+}
+
+
+
 void PlotsWidget::removeColorPath()
 {
     int index = selectPathComboBox->currentIndex();
@@ -285,14 +395,20 @@ void PlotsWidget::removeColorPath()
     {
         selectPathComboBox->removeItem(index);
 
+        freeRegions.append(colorPaths[index].region());
+
         colorPaths.removeAt(index);
 
         sources.removeAt(index);
 
+        rgbWidget->setPaths(colorPaths);
+
         for (int i = 0; i < colorPaths.size(); i++) {
             selectPathComboBox->setItemText(i, QString::number(i + 1));
         }
 
+        setProbes();
+
         setControls(selectPathComboBox->currentIndex());
     }
 }
@@ -315,9 +431,39 @@ void PlotsWidget::setNumIts()
 {
     numIts = numItsLineEdit->text().toInt();
 
-    for (ColorPath &path : colorPaths) {
-        path.setMaxNumPoints(numIts);
+    reservePaths();
+}
+
+
+
+int PlotsWidget::takeRegion()
+{
+    if (!freeRegions.isEmpty()) {
+        return freeRegions.takeLast();
+    }
+
+    return numRegions++;
+}
+
+
+
+void PlotsWidget::reservePaths()
+{
+    int capacity = std::min(numIts, maxPathVertices / (2 * std::max(numRegions, 1)));
+
+    // Histories cleared when ring capacity changes
+
+    if (capacity != pathCapacity)
+    {
+        pathCapacity = capacity;
+
+        for (ColorPath &path : colorPaths) {
+            path.setCapacity(pathCapacity);
+        }
     }
+
+    rgbWidget->reservePathRegions(numRegions, pathCapacity);
+    rgbWidget->setPaths(colorPaths);
 }
 
 
@@ -348,26 +494,85 @@ void PlotsWidget::setNumIts()
 
 
 
-void PlotsWidget::setPixelRGB()
+void PlotsWidget::setProbes()
 {
-    for (ColorPath &path : colorPaths)
+    // Probes sampled by render manager only while plots are enabled or recorded
+
+    mRenderManager->setProbes(enabled || recording ? sources : QList<QPoint>());
+}
+
+
+
+void PlotsWidget::addProbeValues(QList<QPoint> probes, QList<QVector3D> values)
+{
+    // Values of a probe set no longer current are dropped
+
+    if (!enabled || probes != sources) {
+        return;
+    }
+
+    // Only newest point of each path written to its ring
+
+    for (int i = 0; i < colorPaths.size(); i++) {
+        int slot = colorPaths[i].addPoint();
+        rgbWidget->writePathPoint(colorPaths[i].region(), slot, values[i]);
+    }
+
+    rgbWidget->setPaths(colorPaths);
+}
+
+
+
+void PlotsWidget::toggleProbeRecording(bool checked)
+{
+    if (checked)
     {
-        QList<float> rgb = mRenderManager->rgbPixel(path.source());
-        path.addPoint(rgb[0], rgb[1], rgb[2]);
+        QString filename = QFileDialog::getSaveFileName(this, "Record probes", QDir::currentPath(), "Fosforo probe records (*.fpr)");
+
+        if (filename.isEmpty())
+        {
+            recordButton->blockSignals(true);
+            recordButton->setChecked(false);
+            recordButton->blockSignals(false);
+            return;
+        }
+
+        if (!filename.endsWith(".fpr")) {
+            filename += ".fpr";
+        }
+
+        emit startProbeRecording(filename);
+    }
+    else {
+        emit stopProbeRecording();
     }
 
-    setVertices();
+    recording = checked;
+
+    setProbes();
 }
 
 
-void PlotsWidget::setVertices()
+
+void PlotsWidget::exportProbeRecording()
 {
-    allVertices.clear();
-    numVertices.clear();
+    QString recordFilename = QFileDialog::getOpenFileName(this, "Export probe record", QDir::currentPath(), "Fosforo probe records (*.fpr)");
 
-    foreach (ColorPath path, colorPaths)
-    {
-        allVertices += path.lines();
-        numVertices.append(path.linesSize());
+    if (recordFilename.isEmpty()) {
+        return;
     }
+
+    QString csvFilename = QFileDialog::getSaveFileName(this, "Export probe record", recordFilename.chopped(4) + ".csv", "CSV files (*.csv)");
+
+    if (csvFilename.isEmpty()) {
+        return;
+    }
+
+    // Stop first so that record is complete on disk
+
+    if (recording) {
+        recordButton->setChecked(false);
+    }
+
+    emit exportProbeRecord(recordFilename, csvFilename);
 }
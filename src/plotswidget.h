@@ -27,12 +27,18 @@
 #include "rendermanager.h"
 #include "rgbwidget.h"
 #include "colorpath.h"
+#include "proberecorder.h"
 
 #include <QWidget>
 #include <QComboBox>
 #include <QLineEdit>
 #include <QIntValidator>
 #include <QTransform>
+#include <QVector3D>
+#include <QMenu>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QPushButton>
 
 
 
@@ -50,6 +56,9 @@ public:
 signals:
     void selectedPointChanged(QPoint point);
     void drawCursor(bool on);
+    void startProbeRecording(QString filename);
+    void stopProbeRecording();
+    void exportProbeRecord(QString recordFilename, QString csvFilename);
 
 public slots:
     // void setFBO(GLuint theFBO) { fbo = theFBO; };
@@ -58,6 +67,7 @@ public slots:
     void setSelectedPoint(QPoint point);
     void transformSources(QTransform transform);
     void updatePlots();
+    void addProbeValues(QList<QPoint> probes, QList<QVector3D> values);
 
 private:
     RenderManager* mRenderManager;
@@ -76,12 +86,27 @@ private:
 
     bool enabled = false;
 
+    // Probe values written to disk from recorder thread
+
+    QThread* recorderThread;
+    ProbeRecorder* probeRecorder;
+    QPushButton* recordButton;
+    bool recording = false;
+
     QList<ColorPath> colorPaths;
     QList<QPoint> sources;
-    QList<GLfloat> allVertices;
-    QList<GLuint> numVertices;
+
+    // Ring regions of removed paths reused by new ones
+
+    QList<int> freeRegions;
+    int numRegions = 0;
 
     int numIts = 100;
+    int pathCapacity = 100;
+
+    // Ring capacity lowered if all regions would exceed this number of vertices
+
+    const int maxPathVertices = 1 << 25;
 
     QComboBox* selectPathComboBox;
     QLineEdit* xCoordLineEdit;
@@ -91,13 +116,18 @@ private:
     QLineEdit* numItsLineEdit;
 
     void checkPoint(QPoint &point);
-    void setVertices();
-    void setPixelRGB();
+    int takeRegion();
+    void reservePaths();
+    void setProbes();
+    void addColorPaths(QList<QPoint> points);
 
 private slots:
     void setCoords();
     void addColorPath();
+    void addProbePattern(QAction* action);
     void removeColorPath();
     void setControls(int index);
     void setNumIts();
+    void toggleProbeRecording(bool checked);
+    void exportProbeRecording();
 };
@@ -0,0 +1,335 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#include "presetbank.h"
+
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+
+
+PresetBank::PresetBank(ConfigurationParser* configParser, RenderManager* renderManager, QObject* parent) :
+    QObject(parent),
+    mConfigParser { configParser },
+    mRenderManager { renderManager }
+{
+    // One operation initialized per tick, interleaved with iterations
+
+    mInitTimer.setInterval(0);
+
+    connect(&mInitTimer, &QTimer::timeout, this, &PresetBank::initStep);
+}
+
+
+
+PresetBank::~PresetBank()
+{
+    mInitTimer.stop();
+
+    foreach (Preset* preset, mPresets) {
+        deletePreset(preset);
+    }
+}
+
+
+
+int PresetBank::capacity() const
+{
+    return mCapacity;
+}
+
+
+
+void PresetBank::setCapacity(int capacity)
+{
+    mCapacity = qMax(1, capacity);
+
+    while (mPresets.size() > mCapacity) {
+        removePreset(0);
+    }
+
+    emitPresetsChanged();
+}
+
+
+
+void PresetBank::preload(QString filename)
+{
+    // Oldest preset dropped if bank full
+
+    if (mPresets.size() >= mCapacity) {
+        removePreset(0);
+    }
+
+    mPresets.append(newPreset(filename));
+
+    emitPresetsChanged();
+}
+
+
+
+void PresetBank::activate(int index)
+{
+    if (index < 0 || index >= mPresets.size()) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Preset* preset = mPresets[index];
+
+    // Preloading finished now if not yet done
+
+    if (!waitParsed(preset))
+    {
+        qWarning().noquote() << QString("Preset %1 could not be read").arg(preset->filename);
+
+        removePreset(index);
+
+        emitPresetsChanged();
+        return;
+    }
+
+    while (!ready(preset)) {
+        initNextOperation(preset);
+    }
+
+    // Current output held while graph is replaced, and copied to the new output operation once
+    // the preset's image size has been applied, so that feedback continues from it
+
+    ImageOperation* outputOperation = nullptr;
+
+    foreach (NodeDescription description, preset->configuration.nodes)
+    {
+        if (description.id == preset->configuration.outputNodeId) {
+            outputOperation = description.operation;
+        }
+    }
+
+    if (mCarryOver && outputOperation) {
+        mRenderManager->holdOutput();
+    }
+
+    QString filename = preset->filename;
+
+    mConfigParser->instantiate(preset->configuration);
+
+    if (mCarryOver && outputOperation) {
+        mRenderManager->carryOverOutput(outputOperation);
+    }
+    else {
+        mRenderManager->resetIterationNumer();
+    }
+
+    qInfo().noquote() << QString("Switched to preset %1 in %2 ms").arg(QFileInfo(filename).completeBaseName()).arg(timer.elapsed());
+
+    // Slot refilled in background, its operations now owned by the factory
+
+    deletePreset(preset);
+    mPresets[index] = newPreset(filename);
+
+    mLastIndex = index;
+
+    emitPresetsChanged();
+    emit presetActivated(filename);
+}
+
+
+
+void PresetBank::activateNext()
+{
+    if (!mPresets.isEmpty()) {
+        activate((mLastIndex + 1) % mPresets.size());
+    }
+}
+
+
+
+void PresetBank::setCarryOver(bool set)
+{
+    mCarryOver = set;
+}
+
+
+
+void PresetBank::clear()
+{
+    mInitTimer.stop();
+
+    foreach (Preset* preset, mPresets) {
+        deletePreset(preset);
+    }
+
+    mPresets.clear();
+    mLastIndex = -1;
+
+    emitPresetsChanged();
+}
+
+
+
+PresetBank::Preset* PresetBank::newPreset(QString filename)
+{
+    // Parsed on the thread pool, parameters moved to this thread
+
+    Preset* preset = new Preset;
+    preset->filename = filename;
+    preset->watcher = new QFutureWatcher<bool>(this);
+
+    connect(preset->watcher, &QFutureWatcher<bool>::finished, this, [this, preset]() {
+        onParsed(preset);
+    });
+
+    QThread* parserThread = thread();
+
+    preset->watcher->setFuture(QtConcurrent::run([preset, parserThread]() {
+        return ConfigurationParser::parse(preset->filename, preset->configuration, parserThread);
+    }));
+
+    return preset;
+}
+
+
+
+void PresetBank::removePreset(int index)
+{
+    // Last activated index kept on the same preset, or on the one before a removed last activated one
+
+    deletePreset(mPresets.takeAt(index));
+
+    if (index <= mLastIndex) {
+        mLastIndex--;
+    }
+}
+
+
+
+void PresetBank::deletePreset(Preset* preset)
+{
+    // Watcher deleted before it reports, parse waited for so that nothing writes to the configuration
+
+    preset->watcher->waitForFinished();
+    delete preset->watcher;
+
+    ConfigurationParser::discard(preset->configuration);
+
+    delete preset;
+}
+
+
+
+bool PresetBank::waitParsed(Preset* preset)
+{
+    preset->watcher->waitForFinished();
+    preset->parsed = preset->watcher->result();
+
+    return preset->parsed;
+}
+
+
+
+bool PresetBank::ready(Preset* preset) const
+{
+    return preset->parsed && preset->numInitialized == preset->configuration.nodes.size();
+}
+
+
+
+void PresetBank::initNextOperation(Preset* preset)
+{
+    // Seeds initialized on switching, their init not being repeatable
+
+    NodeDescription description = preset->configuration.nodes.at(preset->numInitialized++);
+
+    if (description.operation)
+    {
+        mRenderManager->initOperation(description.id, description.operation);
+        preset->textureBytes += mRenderManager->operationTextureBytes(description.operation);
+    }
+
+    if (ready(preset))
+    {
+        qInfo().noquote() << QString("Preloaded preset %1: %2 nodes, %3 MB of textures").arg(QFileInfo(preset->filename).completeBaseName()).arg(preset->configuration.nodes.size()).arg(preset->textureBytes / 1048576.0, 0, 'f', 1);
+
+        emitPresetsChanged();
+    }
+}
+
+
+
+void PresetBank::onParsed(Preset* preset)
+{
+    if (!waitParsed(preset))
+    {
+        qWarning().noquote() << QString("Preset %1 could not be read").arg(preset->filename);
+
+        removePreset(mPresets.indexOf(preset));
+
+        emitPresetsChanged();
+        return;
+    }
+
+    mInitTimer.start();
+}
+
+
+
+void PresetBank::initStep()
+{
+    foreach (Preset* preset, mPresets)
+    {
+        if (preset->parsed && !ready(preset))
+        {
+            initNextOperation(preset);
+            return;
+        }
+    }
+
+    mInitTimer.stop();
+}
+
+
+
+void PresetBank::emitPresetsChanged()
+{
+    QStringList names;
+
+    foreach (Preset* preset, mPresets)
+    {
+        QString name = QFileInfo(preset->filename).completeBaseName();
+
+        if (ready(preset)) {
+            names.append(QString("%1 (%2 MB)").arg(name).arg(preset->textureBytes / 1048576.0, 0, 'f', 1));
+        }
+        else {
+            names.append(QString("%1 (loading)").arg(name));
+        }
+    }
+
+    emit presetsChanged(names);
+}
@@ -0,0 +1,107 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+
+#ifndef PRESETBANK_H
+#define PRESETBANK_H
+
+
+
+#include "configparser.h"
+#include "rendermanager.h"
+
+#include <QFutureWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+
+
+// PresetBank: configurations held parsed and with their operations set up in the render context,
+// parsing done on the thread pool and programs and textures initialized one operation per tick,
+// so that switching to one of them only builds its widgets and connects its nodes
+
+class PresetBank : public QObject
+{
+    Q_OBJECT
+
+public:
+    PresetBank(ConfigurationParser* configParser, RenderManager* renderManager, QObject* parent = nullptr);
+    ~PresetBank();
+
+    int capacity() const;
+
+signals:
+    void presetsChanged(QStringList names);
+    void presetActivated(QString filename);
+
+public slots:
+    void preload(QString filename);
+    void activate(int index);
+    void activateNext();
+    void setCarryOver(bool set);
+    void setCapacity(int capacity);
+    void clear();
+
+private:
+    struct Preset
+    {
+        QString filename;
+        Configuration configuration;
+        QFutureWatcher<bool>* watcher = nullptr;
+        bool parsed = false;
+        int numInitialized = 0;
+        qint64 textureBytes = 0;
+    };
+
+    ConfigurationParser* mConfigParser;
+    RenderManager* mRenderManager;
+
+    QList<Preset*> mPresets;
+    int mCapacity = 8;
+    int mLastIndex = -1;
+    bool mCarryOver = false;
+
+    QTimer mInitTimer;
+
+    Preset* newPreset(QString filename);
+    void removePreset(int index);
+    void deletePreset(Preset* preset);
+
+    bool waitParsed(Preset* preset);
+    bool ready(Preset* preset) const;
+    void initNextOperation(Preset* preset);
+
+    void onParsed(Preset* preset);
+    void initStep();
+
+    void emitPresetsChanged();
+};
+
+
+
+#endif // PRESETBANK_H
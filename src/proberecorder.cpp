@@ -0,0 +1,262 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#include "proberecorder.h"
+
+#include <QTextStream>
+#include <cstring>
+
+
+
+static const char recordMagic[4] = { 'F', 'P', 'R', 'B' };
+static const quint32 recordVersion = 1;
+
+
+
+ProbeRecorder::ProbeRecorder(QObject* parent) :
+    QObject(parent)
+{
+}
+
+
+
+ProbeRecorder::~ProbeRecorder()
+{
+    stop();
+}
+
+
+
+template <typename T>
+void ProbeRecorder::write(const T& value)
+{
+    mBuffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+
+
+void ProbeRecorder::start(QString filename)
+{
+    stop();
+
+    mFile.setFileName(filename);
+
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        emit error("Could not open " + filename + " for writing");
+        return;
+    }
+
+    mIds.clear();
+    mLastProbes.clear();
+    mLastIds.clear();
+
+    mBuffer.clear();
+    mBuffer.reserve(mFlushSize + (1 << 20));
+
+    mBuffer.append(recordMagic, 4);
+    write(recordVersion);
+}
+
+
+
+void ProbeRecorder::stop()
+{
+    if (mFile.isOpen())
+    {
+        flush();
+        mFile.close();
+    }
+}
+
+
+
+void ProbeRecorder::append(QList<QPoint> probes, QList<QVector3D> values, unsigned int iteration)
+{
+    if (!mFile.isOpen() || probes.isEmpty()) {
+        return;
+    }
+
+    // Probes seen for the first time declared before their values
+
+    if (probes != mLastProbes)
+    {
+        QList<quint32> newIds;
+
+        mLastIds.clear();
+        mLastIds.reserve(probes.size());
+
+        foreach (QPoint probe, probes)
+        {
+            auto it = mIds.constFind(probe);
+
+            if (it == mIds.constEnd())
+            {
+                it = mIds.insert(probe, static_cast<quint32>(mIds.size()));
+                newIds.append(it.value());
+            }
+
+            mLastIds.append(it.value());
+        }
+
+        if (!newIds.isEmpty())
+        {
+            write(static_cast<quint32>(ProbesBlock));
+            write(static_cast<quint32>(newIds.size()));
+
+            for (int i = 0, j = 0; i < probes.size() && j < newIds.size(); i++)
+            {
+                if (mLastIds[i] == newIds[j])
+                {
+                    write(newIds[j]);
+                    write(static_cast<qint32>(probes[i].x()));
+                    write(static_cast<qint32>(probes[i].y()));
+                    j++;
+                }
+            }
+        }
+
+        mLastProbes = probes;
+    }
+
+    write(static_cast<quint32>(ValuesBlock));
+    write(static_cast<quint32>(values.size()));
+    write(static_cast<quint32>(iteration));
+
+    for (int i = 0; i < values.size(); i++)
+    {
+        write(mLastIds[i]);
+        write(values[i].x());
+        write(values[i].y());
+        write(values[i].z());
+    }
+
+    if (mBuffer.size() >= mFlushSize) {
+        flush();
+    }
+}
+
+
+
+void ProbeRecorder::flush()
+{
+    if (mBuffer.isEmpty()) {
+        return;
+    }
+
+    if (mFile.write(mBuffer) != mBuffer.size()) {
+        emit error("Could not write to " + mFile.fileName() + ": " + mFile.errorString());
+    }
+
+    mBuffer.clear();
+}
+
+
+
+void ProbeRecorder::exportCsv(QString recordFilename, QString csvFilename)
+{
+    QFile recordFile(recordFilename);
+
+    if (!recordFile.open(QIODevice::ReadOnly))
+    {
+        emit error("Could not open " + recordFilename + " for reading");
+        return;
+    }
+
+    QFile csvFile(csvFilename);
+
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        emit error("Could not open " + csvFilename + " for writing");
+        return;
+    }
+
+    auto read = [&recordFile](auto& value) {
+        return recordFile.read(reinterpret_cast<char*>(&value), sizeof(value)) == sizeof(value);
+    };
+
+    char magic[4];
+    quint32 version;
+
+    if (recordFile.read(magic, 4) != 4 || memcmp(magic, recordMagic, 4) != 0 || !read(version) || version != recordVersion)
+    {
+        emit error(recordFilename + " is not a probe record file");
+        return;
+    }
+
+    QTextStream out(&csvFile);
+    out << "iteration,probe,x,y,red,green,blue\n";
+
+    QHash<quint32, QPoint> points;
+
+    quint32 type, count;
+
+    while (read(type) && read(count))
+    {
+        if (type == ProbesBlock)
+        {
+            for (quint32 i = 0; i < count; i++)
+            {
+                quint32 id;
+                qint32 x, y;
+
+                if (!read(id) || !read(x) || !read(y)) {
+                    break;
+                }
+
+                points.insert(id, QPoint(x, y));
+            }
+        }
+        else if (type == ValuesBlock)
+        {
+            quint32 iteration;
+
+            if (!read(iteration)) {
+                break;
+            }
+
+            for (quint32 i = 0; i < count; i++)
+            {
+                quint32 id;
+                float red, green, blue;
+
+                if (!read(id) || !read(red) || !read(green) || !read(blue)) {
+                    break;
+                }
+
+                QPoint point = points.value(id);
+
+                out << iteration << ',' << id << ',' << point.x() << ',' << point.y() << ',' << red << ',' << green << ',' << blue << '\n';
+            }
+        }
+        else
+        {
+            emit error(recordFilename + " has an unknown block type");
+            break;
+        }
+    }
+
+    emit exported(csvFilename);
+}
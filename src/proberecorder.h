@@ -0,0 +1,92 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#ifndef PROBERECORDER_H
+#define PROBERECORDER_H
+
+
+
+#include <QObject>
+#include <QFile>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QPoint>
+#include <QVector3D>
+#include <QString>
+
+
+
+// Appends probe values to a binary file from its own thread, batching writes.
+//
+// File layout (native byte order): "FPRB" and a quint32 version, then blocks,
+// each starting with quint32 type and quint32 count:
+//   probes: count times { quint32 id, qint32 x, qint32 y }
+//   values: quint32 iteration, then count times { quint32 id, float red, green, blue }
+
+class ProbeRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProbeRecorder(QObject* parent = nullptr);
+    ~ProbeRecorder();
+
+    enum BlockType : quint32
+    {
+        ProbesBlock = 1,
+        ValuesBlock = 2
+    };
+
+public slots:
+    void start(QString filename);
+    void stop();
+    void append(QList<QPoint> probes, QList<QVector3D> values, unsigned int iteration);
+    void exportCsv(QString recordFilename, QString csvFilename);
+
+signals:
+    void error(QString message);
+    void exported(QString csvFilename);
+
+private:
+    QFile mFile;
+    QByteArray mBuffer;
+    const qsizetype mFlushSize = 4 << 20;
+
+    // Ids assigned to probes on first sight, cached for unchanged probe sets
+
+    QHash<QPoint, quint32> mIds;
+    QList<QPoint> mLastProbes;
+    QList<quint32> mLastIds;
+
+    template <typename T>
+    void write(const T& value);
+
+    void flush();
+};
+
+
+
+#endif // PROBERECORDER_H
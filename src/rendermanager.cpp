@@ -30,6 +30,20 @@
 
 
 
+static quint64 combineVersion(quint64 seed, quint64 value)
+{
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+
+
+static bool fixedPointFormat(TextureFormat format)
+{
+    return format != TextureFormat::RGBA16F && format != TextureFormat::RGBA32F && format != TextureFormat::R11F_G11F_B10F;
+}
+
+
+
 RenderManager::RenderManager(Factory *factory, QObject *parent)
     : QThread { parent },
     mFactory { factory }
@@ -93,6 +107,74 @@ void RenderManager::adjustTimerInterval(long stepTimeNs)
 
 
 
+void RenderManager::setAdaptiveResolution(bool set)
+{
+    mAdaptiveResolution = set;
+
+    mOverBudgetCount = 0;
+    mUnderBudgetCount = 0;
+    mGpuTimeAvgNs = 0.0;
+
+    // Back to requested size when disabled
+
+    if (!mAdaptiveResolution && mResolutionStep > 0)
+    {
+        mResolutionStep = 0;
+        setTextureSize(mBaseTexWidth, mBaseTexHeight);
+        emit effectiveSizeChanged(mTexWidth, mTexHeight);
+    }
+}
+
+
+
+void RenderManager::setIterationsPerFrame(int iterations)
+{
+    mIterationsPerFrame = std::clamp(iterations, 0, mMaxIterationsPerFrame);
+}
+
+
+
+void RenderManager::setIncrementalRender(bool set)
+{
+    mIncrementalRender = set;
+    mOperationVersions.clear();
+}
+
+
+
+void RenderManager::setRegionRendering(bool set)
+{
+    mRegionRendering = set;
+
+    // Texels outside regions are stale: render all operations again
+
+    mOperationVersions.clear();
+    mInputRegions.clear();
+}
+
+
+
+void RenderManager::setLutBaking(bool set)
+{
+    mLutBaking = set;
+
+    // Operations inside chains hold stale outputs: render all of them again
+
+    mOperationVersions.clear();
+
+    if (!mLutBaking)
+    {
+        mLutChains.clear();
+        mLutChainTails.clear();
+
+        mContext->makeCurrent(mSurface);
+        deleteLuts();
+        mContext->doneCurrent();
+    }
+}
+
+
+
 void RenderManager::init(QOpenGLContext* context)
 {
     // Create context
@@ -145,19 +227,69 @@ void RenderManager::init(QOpenGLContext* context)
         mMaxArrayTexLayers = mNumArrayTexLayers;
     }
 
-    genArrayTexture(&mBlendArrayTexId, mNumArrayTexLayers);
-
     // Shader program
 
     mBlenderProgram = new QOpenGLShaderProgram();
     setBlenderProgram();
 
+    mTileProgram = new QOpenGLShaderProgram();
+    setTileProgram();
+
+    // Sampler for tiles cut from working textures: bilinear
+
+    glGenSamplers(1, &mTileSamplerId);
+    glSamplerParameteri(mTileSamplerId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(mTileSamplerId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(mTileSamplerId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(mTileSamplerId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Statistics programs and buffers: partial results per work group, and statistics of inputs
+
+    mStatsProgram = new QOpenGLShaderProgram();
+    mStatsReduceProgram = new QOpenGLShaderProgram();
+    setStatisticsPrograms();
+
+    glCreateBuffers(1, &mStatsPartialBuffer);
+    glNamedBufferStorage(mStatsPartialBuffer, mNumStatsGroups * mNumStatsGroups * 16 * sizeof(GLfloat), nullptr, 0);
+
+    glCreateBuffers(1, &mInputStatsBuffer);
+    glNamedBufferStorage(mInputStatsBuffer, sizeof(GLfloat) * 16, nullptr, 0);
+
+    // Probe program: buffers allocated as probes are set
+
+    mProbeProgram = new QOpenGLShaderProgram();
+    setProbeProgram();
+
+    // Frame hash program, ring of fingerprints and mapped buffer to read it
+
+    mHashProgram = new QOpenGLShaderProgram();
+    setHashProgram();
+
+    // LUT programs: textures allocated as chains are baked
+
+    mLutProgram = new QOpenGLShaderProgram();
+    mLutIdentityProgram = new QOpenGLShaderProgram();
+    setLutPrograms();
+
+    glCreateBuffers(1, &mHashBuffer);
+    glNamedBufferStorage(mHashBuffer, mHashRingSize * 2 * sizeof(GLuint), nullptr, 0);
+
+    GLbitfield hashReadFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glCreateBuffers(1, &mHashReadBuffer);
+    glNamedBufferStorage(mHashReadBuffer, mHashRingSize * 2 * sizeof(GLuint), nullptr, hashReadFlags | GL_CLIENT_STORAGE_BIT);
+    mHashReadData = static_cast<GLuint*>(glMapNamedBufferRange(mHashReadBuffer, 0, mHashRingSize * 2 * sizeof(GLuint), hashReadFlags));
+
     // mIdentityProgram = new QOpenGLShaderProgram();
     // setIdentityProgram();
 
-    // Frame texture: for video recording
+    // Frame texture: for video recording, always at requested size
+
+    genTexture(&mFrameTexId, TextureFormat::RGBA8, mBaseTexWidth, mBaseTexHeight);
 
-    genTexture(&mFrameTexId, TextureFormat::RGBA8);
+    // Timer query: GPU time for adaptive resolution
+
+    glGenQueries(1, &mTimeQuery);
 
     // Pixel buffer object: generate and set up
 
@@ -190,14 +322,46 @@ RenderManager::~RenderManager()
 
     glDeleteVertexArrays(1, &mVao);
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-    glDeleteTextures(1, &mBlendArrayTexId);
+    deleteBlendArrayTextures();
+    deletePassTextures();
 
     delete mBlenderProgram;
+    delete mTileProgram;
     // delete mIdentityProgram;
 
+    glDeleteSamplers(1, &mTileSamplerId);
+
+    delete mStatsProgram;
+    delete mStatsReduceProgram;
+
+    foreach (ImageOperation* operation, mStatsBufferIds.keys()) {
+        deleteStatisticsBuffer(operation);
+    }
+
+    glDeleteBuffers(1, &mStatsPartialBuffer);
+    glDeleteBuffers(1, &mInputStatsBuffer);
+
+    delete mProbeProgram;
+    deleteProbeBuffers();
+
+    delete mHashProgram;
+
+    if (mHashFence) {
+        glDeleteSync(mHashFence);
+    }
+
+    glUnmapNamedBuffer(mHashReadBuffer);
+    glDeleteBuffers(1, &mHashBuffer);
+    glDeleteBuffers(1, &mHashReadBuffer);
+
+    delete mLutProgram;
+    delete mLutIdentityProgram;
+    deleteLuts();
+
     glDeleteBuffers(1, &mPbo);
 
+    glDeleteQueries(1, &mTimeQuery);
+
     mContext->doneCurrent();
 
     delete mOutputImage;
@@ -236,21 +400,69 @@ void RenderManager::iterate()
 
         setImageTextures();
 
-        if (!mSortedOperations.isEmpty())
+        // Statistics computed in previous iterations, if already available
+
+        QList<ImageOperation*> statsOps = readStatistics();
+
+        QList<QPoint> probes;
+        QList<QVector3D> probeValues;
+        unsigned int probesIteration = 0;
+        bool probesAvailable = readProbes(probes, probeValues, probesIteration);
+
+        bool periodChanged = readHashes();
+
+        // Time GPU work only if previous query result has been read, so as not to stall
+
+        bool timing = (mAdaptiveResolution || mIterationsPerFrame == 0) && !mTimeQueryPending;
+
+        // Fast-forward: several iterations back to back, only last one presented and read back
+
+        int iterations = frameIterations();
+
+        if (timing)
         {
-            copyTextures();
-            shiftCopyArrayTextures();
-            render();
+            glBeginQuery(GL_TIME_ELAPSED, mTimeQuery);
+            mTimedIterations = iterations;
         }
 
-        foreach (Seed* seed, mFactory->seeds()) {
-            seed->setClearTexture();
+        for (int i = 0; i < iterations; i++)
+        {
+            if (!mSortedOperations.isEmpty())
+            {
+                copyTextures();
+                shiftCopyArrayTextures();
+                render();
+            }
+
+            foreach (Seed* seed, mFactory->seeds()) {
+                seed->setClearTexture();
+            }
+
+            // Probes and fingerprints of intermediate iterations keep their own iteration numbers
+
+            if (i < iterations - 1)
+            {
+                sampleProbes();
+                hashOutput();
+
+                mIterationNumber++;
+            }
+        }
+
+        if (timing)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            mTimeQueryPending = true;
         }
 
         if (mGrabOutputTexture || mTakeScreenshot) {
             readOutputTexture();
         }
 
+        sampleProbes();
+
+        hashOutput();
+
         glDeleteSync(mFence);
         mFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
@@ -258,11 +470,140 @@ void RenderManager::iterate()
             grabOutputImage();
         }
 
+        if (mTimeQueryPending) {
+            readTimeQuery();
+        }
+
         mContext->doneCurrent();
 
         emit frameReady(reinterpret_cast<quintptr>(mFence));
 
+        foreach (ImageOperation* operation, statsOps) {
+            emit statisticsReady(operation);
+        }
+
+        if (probesAvailable) {
+            emit probesRead(probes, probeValues, probesIteration);
+        }
+
+        if (periodChanged) {
+            emit convergenceChanged(mConvergencePeriod);
+        }
+
         mIterationNumber++;
+
+        if (mAdaptiveResolution && mGpuTimeReady) {
+            adaptResolution();
+        }
+    }
+}
+
+
+
+void RenderManager::readTimeQuery()
+{
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(mTimeQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available == GL_TRUE)
+    {
+        glGetQueryObjectui64v(mTimeQuery, GL_QUERY_RESULT, &mGpuTimeNs);
+        mTimeQueryPending = false;
+        mGpuTimeReady = true;
+
+        double iterationTimeNs = static_cast<double>(mGpuTimeNs) / std::max(mTimedIterations, 1);
+        mGpuTimePerIterationNs = mGpuTimePerIterationNs > 0.0 ? 0.8 * mGpuTimePerIterationNs + 0.2 * iterationTimeNs : iterationTimeNs;
+    }
+}
+
+
+
+float RenderManager::resolutionStepScale()
+{
+    return std::pow(mResolutionStepFactor, mResolutionStep);
+}
+
+
+
+int RenderManager::frameIterations()
+{
+    if (mIterationsPerFrame > 0) {
+        return mIterationsPerFrame;
+    }
+
+    // As many as fit in most of frame budget, from measured GPU time per iteration
+
+    if (mGpuTimePerIterationNs <= 0.0) {
+        return 1;
+    }
+
+    double budgetNs = 1.0e9 / (mFrequency > 0 ? mFrequency : 60.0);
+
+    return std::clamp(static_cast<int>(0.8 * budgetNs / mGpuTimePerIterationNs), 1, mMaxIterationsPerFrame);
+}
+
+
+
+void RenderManager::adaptResolution()
+{
+    mGpuTimeReady = false;
+
+    // Fast-forwarded frames exceed budget on purpose
+
+    if (mIterationsPerFrame != 1) {
+        return;
+    }
+
+    // Needs a target rate
+
+    if (mFrequency <= 0) {
+        return;
+    }
+
+    double budgetNs = 1.0e9 / mFrequency;
+
+    mGpuTimeAvgNs = mGpuTimeAvgNs > 0.0 ? 0.9 * mGpuTimeAvgNs + 0.1 * mGpuTimeNs : mGpuTimeNs;
+
+    // Hysteresis: a step changes area by ~0.72, so going up from below 60% of budget
+    // lands below 90%, the threshold for going down
+
+    if (mGpuTimeAvgNs > 0.9 * budgetNs)
+    {
+        mOverBudgetCount++;
+        mUnderBudgetCount = 0;
+    }
+    else if (mGpuTimeAvgNs < 0.6 * budgetNs)
+    {
+        mUnderBudgetCount++;
+        mOverBudgetCount = 0;
+    }
+    else
+    {
+        mOverBudgetCount = 0;
+        mUnderBudgetCount = 0;
+    }
+
+    int step = mResolutionStep;
+
+    if (mOverBudgetCount >= 10 && step < mNumResolutionSteps - 1) {
+        step++;
+    }
+    else if (mUnderBudgetCount >= 60 && step > 0) {
+        step--;
+    }
+
+    if (step != mResolutionStep)
+    {
+        mResolutionStep = step;
+
+        mOverBudgetCount = 0;
+        mUnderBudgetCount = 0;
+        mGpuTimeAvgNs = 0.0;
+
+        float scale = resolutionStepScale();
+        setTextureSize(scaledSize(mBaseTexWidth, scale), scaledSize(mBaseTexHeight, scale));
+
+        emit effectiveSizeChanged(mTexWidth, mTexHeight);
     }
 }
 
@@ -283,7 +624,7 @@ void RenderManager::setOutputImage()
         delete mOutputImage;
     }
 
-    mOutputImage = new QImage(mTexWidth, mTexHeight, QImage::Format_RGBA8888);
+    mOutputImage = new QImage(mBaseTexWidth, mBaseTexHeight, QImage::Format_RGBA8888);
     mOutputImage->fill(Qt::black);
 }
 
@@ -339,15 +680,18 @@ void RenderManager::readOutputTexture()
 
         GLuint* pReadTexId = mOutputTexId;
 
-        if (mTexFormat != TextureFormat::RGBA8)
+        GLuint width, height;
+        textureSize(*mOutputTexId, width, height);
+
+        if (textureInternalFormat(*mOutputTexId) != GL_RGBA8 || width != mBaseTexWidth || height != mBaseTexHeight)
         {
-            blitTextures(*mOutputTexId, mTexWidth, mTexHeight, mFrameTexId, mTexWidth, mTexHeight);
+            blitTextures(*mOutputTexId, width, height, mFrameTexId, mBaseTexWidth, mBaseTexHeight);
             pReadTexId = &mFrameTexId;
         }
 
         glBindBuffer(GL_PIXEL_PACK_BUFFER, mPbo);
 
-        glGetTextureSubImage(*pReadTexId, 0, 0, 0, 0, mTexWidth, mTexHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(mOutputImage->sizeInBytes()), 0);
+        glGetTextureSubImage(*pReadTexId, 0, 0, 0, 0, mBaseTexWidth, mBaseTexHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, GLsizei(mOutputImage->sizeInBytes()), 0);
 
         glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     }
@@ -448,839 +792,2897 @@ void RenderManager::stopRecording()
 
 
 
-QList<float> RenderManager::rgbPixel(QPoint pos)
+void RenderManager::renderStill(QString filename, int width, int height, int iterations, int tileSize)
 {
-    QList<float> rgb(3, 0.0f);
-
-    if (mOutputTexId)
+    if (!mContext || !mOutputTexId || !*mOutputTexId || mSortedOperations.isEmpty())
     {
-        mContext->makeCurrent(mSurface);
+        emit stillRendered(false, "Nothing to render: no output set.");
+        return;
+    }
 
-        glGetTextureSubImage(*mOutputTexId, 0, pos.x(), pos.y(), 0, 1, 1, 1, GL_RGB, GL_FLOAT, rgb.size() * sizeof(float), rgb.data());
+    QString error;
 
-        mContext->doneCurrent();
+    int halo = stillHalo(iterations, error);
+
+    if (halo < 0)
+    {
+        emit stillRendered(false, error);
+        return;
     }
 
-    return rgb;
-}
+    // Tile size, halo included, limited by maximum texture size
 
+    GLint maxTexSize = 0;
 
+    mContext->makeCurrent(mSurface);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
+    mContext->doneCurrent();
 
-TextureFormat RenderManager::texFormat()
-{
-    return mTexFormat;
-}
+    tileSize = qMin(tileSize, maxTexSize);
 
+    int step = tileSize - 2 * halo;
 
+    if (step <= 0)
+    {
+        emit stillRendered(false, QString("Halo of %1 px does not fit in tiles of %2 px: reduce the number of iterations.").arg(halo).arg(tileSize));
+        return;
+    }
 
-void RenderManager::setTextureFormat(TextureFormat format)
-{
-    mTexFormat = format;
+    // Binary PPM: header, then rows written in place as tiles are done
 
-    QList<GLuint*> oldTexIds;
+    QFile file(filename);
 
-    foreach (Seed* seed, mFactory->seeds()) {
-        oldTexIds.append(seed->textureIds());
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        emit stillRendered(false, QString("Could not open %1 for writing.").arg(filename));
+        return;
+    }
+
+    QByteArray header = QString("P6\n%1 %2\n255\n").arg(width).arg(height).toLatin1();
+    file.write(header);
+
+    if (!file.resize(header.size() + qint64(width) * height * 3))
+    {
+        file.close();
+        emit stillRendered(false, QString("Could not allocate %1.").arg(filename));
+        return;
+    }
+
+    // Working textures set aside, to be restored when done
+
+    QMap<GLuint*, GLuint> workTexIds;
+
+    foreach (GLuint* texId, stillTextureIds()) {
+        workTexIds.insert(texId, *texId);
     }
 
+    QMap<ImageOperation*, std::tuple<TextureFormat, GLuint, GLuint>> workAllocations;
+
     foreach (ImageOperation* operation, mFactory->operations()) {
-        oldTexIds.append(operation->textureIds());
+        workAllocations.insert(operation, std::make_tuple(operation->allocatedTexFormat(), operation->allocatedTexWidth(), operation->allocatedTexHeight()));
     }
 
-    mContext->makeCurrent(mSurface);
+    GLuint workTexWidth = mTexWidth;
+    GLuint workTexHeight = mTexHeight;
+
+    bool success = true;
+
+    QRect imageRect(0, 0, width, height);
+
+    // Tiles reuse texture pointers and iteration number: render every operation
 
-    foreach (GLuint* oldTexId, oldTexIds)
+    bool incrementalRender = mIncrementalRender;
+    mIncrementalRender = false;
+    mDecimation = false;
+
+    bool regionRendering = mRegionRendering;
+    mRegionRendering = false;
+
+    for (int y = 0; y < height && success; y += step)
     {
-        GLuint newTexId = 0;
-        genTexture(&newTexId, mTexFormat);
+        for (int x = 0; x < width && success; x += step)
+        {
+            // Valid part of tile plus halo, clipped to image
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, mReadFbo);
-        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *oldTexId, 0);
+            QRect validRect(x, y, qMin(step, width - x), qMin(step, height - y));
+            QRect tileRect = validRect.adjusted(-halo, -halo, halo, halo).intersected(imageRect);
 
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDrawFbo);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, newTexId, 0);
+            QRectF region(static_cast<qreal>(tileRect.x()) / width, static_cast<qreal>(tileRect.y()) / height, static_cast<qreal>(tileRect.width()) / width, static_cast<qreal>(tileRect.height()) / height);
 
-        glReadBuffer(GL_COLOR_ATTACHMENT0);
-        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+            mTexWidth = tileRect.width();
+            mTexHeight = tileRect.height();
 
-        glBlitFramebuffer(0, 0, mTexWidth, mTexHeight, 0, 0, mTexWidth, mTexHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            adjustOrtho();
 
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            mContext->makeCurrent(mSurface);
 
-        glDeleteTextures(1, oldTexId);
-        *oldTexId = newTexId;
-    }
+            setVao();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+            genTileTextures(workTexIds, region);
+            setOutTextureIds();
 
-    recreateArrayTexture(&mBlendArrayTexId, mNumArrayTexLayers);
+            // Final iterations at output resolution
 
-    foreach (ImageOperation* operation, mFactory->operations()) {
-        if (operation->sampler2DArrayAvail()) {
-            recreateArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth());
+            for (int i = 0; i < iterations; i++)
+            {
+                copyTextures();
+                shiftCopyArrayTextures();
+                render();
+            }
+
+            success = writeTile(file, header.size(), width, tileRect, validRect);
+
+            deleteTileTextures();
+            deleteBlendArrayTextures();
+            deletePassTextures();
+
+            mContext->doneCurrent();
         }
     }
 
-    mContext->doneCurrent();
+    file.close();
 
-    foreach (Seed* seed, mFactory->seeds()) {
-        seed->setOutTextureId();
-    }
+    // Restore working state
 
-    foreach (ImageOperation* operation, mFactory->operations())
-    {
-        operation->setBlitInTextureId();
-        operation->setOutTextureId();
+    for (auto [texId, workTexId] : workTexIds.asKeyValueRange()) {
+        *texId = workTexId;
     }
 
-    emit texturesChanged();
-}
+    for (auto [operation, allocation] : workAllocations.asKeyValueRange()) {
+        operation->setAllocatedTextures(std::get<0>(allocation), std::get<1>(allocation), std::get<2>(allocation));
+    }
 
+    mTexWidth = workTexWidth;
+    mTexHeight = workTexHeight;
 
+    mIncrementalRender = incrementalRender;
+    mDecimation = true;
+    mOperationVersions.clear();
 
-GLuint RenderManager::texWidth()
-{
-    return mTexWidth;
-}
+    mRegionRendering = regionRendering;
+    mInputRegions.clear();
 
+    adjustOrtho();
 
+    mContext->makeCurrent(mSurface);
 
-GLuint RenderManager::texHeight()
-{
-    return mTexHeight;
-}
+    setVao();
+    glViewport(0, 0, mTexWidth, mTexHeight);
 
+    mContext->doneCurrent();
 
+    setOutTextureIds();
 
-void RenderManager::resetIterationNumer()
-{
-    mIterationNumber = 0;
+    if (success) {
+        emit stillRendered(true, QString("Still of %1 x %2 px saved to %3.").arg(width).arg(height).arg(filename));
+    }
+    else {
+        emit stillRendered(false, QString("Could not write to %1.").arg(filename));
+    }
 }
 
 
 
-int RenderManager::iterationNumber()
+int RenderManager::stillHalo(int iterations, QString& error)
 {
-    return mIterationNumber;
-}
-
+    // Distance information travels per iteration: sum of enabled operations' footprints in output pixels
 
+    int footprint = 0;
 
-QString RenderManager::version()
-{
-    return mVersion;
-}
-
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        if (!operation->enabled()) {
+            continue;
+        }
 
-void RenderManager::resize(GLuint width, GLuint height)
-{
-    mOldTexWidth = mTexWidth;
-    mOldTexHeight = mTexHeight;
+        int radius = operation->footprint();
 
-    mTexWidth = width;
-    mTexHeight = height;
+        if (radius < 0)
+        {
+            error = QString("Operation '%1' does not declare a bounded neighbourhood.").arg(operation->name());
+            return -1;
+        }
 
-    setOutputImage();
+        // Scaled operation: radius in its own texels, plus bilinear resampling of input and output
 
-    if (mContext)
-    {
-        mContext->makeCurrent(mSurface);
+        float scale = operation->resolutionScale();
 
-        setVao();
-        foreach (Seed* seed, mFactory->seeds()) {
-            seed->setVao(width, height);
+        if (scale != 1.0f) {
+            footprint += operation->substeps() * static_cast<int>(std::ceil((radius + 2) / scale));
+        }
+        else {
+            footprint += operation->substeps() * radius;
         }
+    }
 
-        setPbo();
+    return footprint * iterations;
+}
 
-        glViewport(0, 0, mTexWidth, mTexHeight);
 
-        resizeTextures();
-        recreateArrayTexture(&mBlendArrayTexId, mNumArrayTexLayers);
 
-        foreach (ImageOperation* operation, mFactory->operations()) {
-            if (operation->sampler2DArrayAvail()) {
-                recreateArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth());
-            }
-        }
+QList<GLuint*> RenderManager::stillTextureIds()
+{
+    QList<GLuint*> texIds;
 
-        mContext->doneCurrent();
+    foreach (Seed* seed, mFactory->seeds()) {
+        texIds.append(seed->textureIds());
+    }
 
-        adjustOrtho();
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        texIds.append(operation->textureIds());
+
+        if (operation->sampler2DArrayAvail()) {
+            texIds.append(operation->arrayTextureId());
+        }
+    }
+
+    for (auto [devId, texId] : mVideoTextures.asKeyValueRange()) {
+        texIds.append(&texId);
     }
+
+    return texIds;
 }
 
 
 
-void RenderManager::setOutputTextureId(GLuint* pTexId)
+void RenderManager::setOutTextureIds()
 {
-    mOutputTexId = pTexId;
+    setVideoTextures();
+
+    foreach (Seed* seed, mFactory->seeds()) {
+        seed->setOutTextureId();
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        operation->setBlitInTextureId();
+        operation->setOutTextureId();
+    }
 }
 
 
 
-void RenderManager::initOperation(QUuid id, ImageOperation* operation)
+void RenderManager::drawTileRegion(GLuint srcTexId, QRectF region, GLuint width, GLuint height)
 {
-    Q_UNUSED(id)
+    // Expects target attached to output framebuffer
+    // Region in texture coordinates: left and top are the lower ones
 
-    // Init and link shaders
+    glViewport(0, 0, width, height);
 
-    operation->init(mContext, mSurface);
-    operation->linkShaders();
+    glBindVertexArray(mVao);
 
-    // Adjust orthographic projection if any
+    mTileProgram->bind();
+    mTileProgram->setUniformValue("region", QVector4D(region.left(), region.top(), region.right(), region.bottom()));
 
-    adjustOperationOrtho(operation);
+    glBindTextureUnit(0, srcTexId);
+    glBindSampler(0, mTileSamplerId);
 
-    // Set parameters
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
-    operation->setAllParameters();
+    glBindSampler(0, 0);
+    glBindTextureUnit(0, 0);
 
-    genOpTextures(operation);
+    mTileProgram->release();
+
+    glBindVertexArray(0);
 }
 
 
 
-void RenderManager::initSeed(QUuid id, Seed* seed)
+GLuint RenderManager::tileTexture(GLuint srcTexId, QRectF region, GLuint width, GLuint height)
 {
-    Q_UNUSED(id)
+    // Region of working texture resampled to tile of same format
 
-    seed->init(static_cast<GLenum>(mTexFormat), mTexWidth, mTexHeight, mContext, mSurface);
-}
+    GLuint tileTexId = 0;
 
+    if (srcTexId)
+    {
+        genTexture(&tileTexId, static_cast<TextureFormat>(textureInternalFormat(srcTexId)), width, height);
 
-void RenderManager::adjustOperationOrtho(ImageOperation* operation)
-{
-    GLfloat left, right, bottom, top;
-    verticesCoords(left, right, bottom, top);
+        glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tileTexId, 0);
 
-    operation->adjustOrtho(left, right, bottom, top);
-}
+        drawTileRegion(srcTexId, region, width, height);
 
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 
-void RenderManager::setSortedOperations(QList<ImageOperation*> sortedOperations)
-{
-    mSortedOperations = sortedOperations;
+    return tileTexId;
 }
 
 
 
-void RenderManager::reset()
+GLuint RenderManager::tileArrayTexture(GLuint srcArrayTexId, GLsizei arrayTexDepth, QRectF region, GLuint width, GLuint height)
 {
-    clearAllOpsTextures();
-    drawAllSeeds();
-    resetIterationNumer();
+    GLuint tileArrayTexId = 0;
+
+    if (srcArrayTexId)
+    {
+        GLenum format = textureInternalFormat(srcArrayTexId);
+
+        genArrayTexture(&tileArrayTexId, arrayTexDepth, static_cast<TextureFormat>(format), width, height);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+
+        // Each layer sampled through a 2D view of it
+
+        for (GLsizei layer = 0; layer < arrayTexDepth; layer++)
+        {
+            GLuint viewTexId = 0;
+            glGenTextures(1, &viewTexId);
+            glTextureView(viewTexId, GL_TEXTURE_2D, srcArrayTexId, format, 0, 1, layer, 1);
+
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, tileArrayTexId, 0, layer);
+
+            drawTileRegion(viewTexId, region, width, height);
+
+            glDeleteTextures(1, &viewTexId);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    return tileArrayTexId;
 }
 
 
 
-void RenderManager::genImageTexture(QByteArray devId)
+void RenderManager::genTileTextures(const QMap<GLuint*, GLuint>& workTexIds, QRectF region)
 {
-    if (!mVideoTextures.contains(devId))
+    foreach (Seed* seed, mFactory->seeds()) {
+        foreach (GLuint* texId, seed->textureIds()) {
+            *texId = tileTexture(workTexIds.value(texId), region, mTexWidth, mTexHeight);
+        }
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations())
     {
-        GLuint newTexId = 0;
-        mContext->makeCurrent(mSurface);
-        genTexture(&newTexId, mTexFormat);
-        clearTexture(&newTexId);
-        mContext->doneCurrent();
+        GLuint width = operationTexWidth(operation);
+        GLuint height = operationTexHeight(operation);
 
-        mVideoTextures.insert(devId, newTexId);
+        foreach (GLuint* texId, operation->textureIds()) {
+            *texId = tileTexture(workTexIds.value(texId), region, width, height);
+        }
 
-        QImage img(mTexWidth, mTexHeight, QImage::Format_RGBA8888);
-        img.fill(Qt::black);
-        mFrameImageMap.insert(devId, img);
+        if (operation->sampler2DArrayAvail())
+        {
+            GLuint* arrayTexId = operation->arrayTextureId();
+            *arrayTexId = tileArrayTexture(workTexIds.value(arrayTexId), operation->arrayTextureDepth(), region, width, height);
+        }
+
+        operation->setAllocatedTextures(operation->allocatedTexFormat(), width, height);
+    }
+
+    for (auto [devId, texId] : mVideoTextures.asKeyValueRange()) {
+        texId = tileTexture(workTexIds.value(&texId), region, mTexWidth, mTexHeight);
     }
 }
 
 
 
-void RenderManager::delImageTexture(QByteArray devId)
+void RenderManager::deleteTileTextures()
 {
-    if (mVideoTextures.contains(devId))
-    {
-        mContext->makeCurrent(mSurface);
-        glDeleteTextures(1, &mVideoTextures[devId]);
-        mContext->doneCurrent();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-        mVideoTextures.remove(devId);
-        mFrameImageMap.remove(devId);
+    foreach (GLuint* texId, stillTextureIds())
+    {
+        if (*texId)
+        {
+            mTextureInfos.remove(*texId);
+            glDeleteTextures(1, texId);
+        }
     }
 }
 
 
-void RenderManager::setVideoTextures()
+
+bool RenderManager::writeTile(QFile& file, qint64 dataOffset, int imageWidth, QRect tileRect, QRect validRect)
 {
-    foreach (Seed* seed, mFactory->seeds())
+    // Output converted to 8-bit RGBA at tile size
+
+    GLuint frameTexId = 0;
+    genTexture(&frameTexId, TextureFormat::RGBA8, tileRect.width(), tileRect.height());
+
+    GLuint outWidth, outHeight;
+    textureSize(*mOutputTexId, outWidth, outHeight);
+
+    blitTextures(*mOutputTexId, outWidth, outHeight, frameTexId, tileRect.width(), tileRect.height());
+
+    // Valid part only, halo discarded
+
+    qint64 rowSize = qint64(validRect.width()) * 3;
+
+    QByteArray pixels(rowSize * validRect.height(), 0);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(frameTexId, 0, validRect.x() - tileRect.x(), validRect.y() - tileRect.y(), 0, validRect.width(), validRect.height(), 1, GL_RGB, GL_UNSIGNED_BYTE, GLsizei(pixels.size()), pixels.data());
+
+    mTextureInfos.remove(frameTexId);
+    glDeleteTextures(1, &frameTexId);
+
+    // Each row at its place in image
+
+    for (int row = 0; row < validRect.height(); row++)
     {
-        QByteArray devId = seed->videoDevId();
-        seed->setVideoTexture(mVideoTextures.value(devId, 0));
+        qint64 offset = dataOffset + (qint64(validRect.y() + row) * imageWidth + validRect.x()) * 3;
+
+        if (!file.seek(offset) || file.write(pixels.constData() + row * rowSize, rowSize) != rowSize) {
+            return false;
+        }
     }
+
+    return true;
 }
 
 
 
-void RenderManager::setFrameImage(QByteArray devId, QImage image)
+void RenderManager::setProbes(QList<QPoint> probes)
 {
-    mFrameImageMap[devId] = image;
+    // Coordinates in base image size, uploaded before next sampling
+
+    mProbes = probes;
+    mProbesChanged = true;
 }
 
 
 
-void RenderManager::setImageTextures()
+void RenderManager::reserveProbeBuffers(GLsizei count)
 {
-    for (auto [devId, image] : mFrameImageMap.asKeyValueRange())
-    {
-        if (!image.isNull() && mVideoTextures.contains(devId))
-        {
-            qreal sx = static_cast<qreal>(mTexWidth)  / image.width();
-            qreal sy = static_cast<qreal>(mTexHeight) / image.height();
-            qreal scale = qMin(1.0, qMin(sx, sy));
+    if (count <= mProbeCapacity) {
+        return;
+    }
 
-            int displayWidth = qRound(image.width() * scale);
-            int displayHeight = qRound(image.height() * scale);
+    // Immutable storage: recreated with doubled capacity
 
-            int offsetX = (mTexWidth  - displayWidth) / 2;
-            int offsetY = (mTexHeight - displayHeight) / 2;
+    deleteProbeBuffers();
 
-            QImage scaled = image.scaled(displayWidth, displayHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    mProbeCapacity = std::max(count, 2 * mProbeCapacity);
 
-            QImage buffer(mTexWidth, mTexHeight, QImage::Format_RGBA8888);
-            buffer.fill(Qt::black);
+    glCreateBuffers(1, &mProbeCoordsBuffer);
+    glNamedBufferStorage(mProbeCoordsBuffer, mProbeCapacity * 2 * sizeof(GLint), nullptr, GL_DYNAMIC_STORAGE_BIT);
 
-            QPainter painter(&buffer);
-            painter.drawImage(offsetX, offsetY, scaled);
+    glCreateBuffers(1, &mProbeValuesBuffer);
+    glNamedBufferStorage(mProbeValuesBuffer, mProbeCapacity * 4 * sizeof(GLfloat), nullptr, 0);
 
-            // mContext->makeCurrent(mSurface);
+    GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
 
-            glBindTexture(GL_TEXTURE_2D, mVideoTextures[devId]);
+    glCreateBuffers(1, &mProbeReadBuffer);
+    glNamedBufferStorage(mProbeReadBuffer, mProbeCapacity * 4 * sizeof(GLfloat), nullptr, flags | GL_CLIENT_STORAGE_BIT);
+    mProbeReadData = static_cast<GLfloat*>(glMapNamedBufferRange(mProbeReadBuffer, 0, mProbeCapacity * 4 * sizeof(GLfloat), flags));
 
-            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    mProbesChanged = true;
+}
 
-            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mTexWidth, mTexHeight, GL_RGBA, GL_UNSIGNED_BYTE, buffer.constBits());
 
-            glBindTexture(GL_TEXTURE_2D, 0);
 
-            // mContext->doneCurrent();
-        }
+void RenderManager::deleteProbeBuffers()
+{
+    if (mProbeFence)
+    {
+        glDeleteSync(mProbeFence);
+        mProbeFence = 0;
+    }
+
+    if (mProbeReadBuffer) {
+        glUnmapNamedBuffer(mProbeReadBuffer);
     }
+
+    glDeleteBuffers(1, &mProbeCoordsBuffer);
+    glDeleteBuffers(1, &mProbeValuesBuffer);
+    glDeleteBuffers(1, &mProbeReadBuffer);
+
+    mProbeCoordsBuffer = 0;
+    mProbeValuesBuffer = 0;
+    mProbeReadBuffer = 0;
+    mProbeReadData = nullptr;
+    mProbeCapacity = 0;
 }
 
 
 
-void RenderManager::setBlenderProgram()
+void RenderManager::sampleProbes()
 {
-    mBlenderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/blender.vert");
-    mBlenderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/blender.frag");
-    mBlenderProgram->link();
+    // One dispatch for all probes, skipped while previous values are in flight
 
-    // Set blender shader attributes
+    if (mProbes.isEmpty() || mProbeFence || !mOutputTexId || !*mOutputTexId) {
+        return;
+    }
 
-    if (mBlenderProgram->isLinked())
+    reserveProbeBuffers(mProbes.size());
+
+    if (mProbesChanged)
     {
-        mBlenderProgram->bind();
+        QList<GLint> coords;
+        coords.reserve(2 * mProbes.size());
 
-        // Vertices coordinates attribute (location = 0)
+        foreach (QPoint probe, mProbes) {
+            coords << probe.x() << probe.y();
+        }
 
-        mBlenderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
-        mBlenderProgram->enableAttributeArray(0);
+        glNamedBufferSubData(mProbeCoordsBuffer, 0, coords.size() * sizeof(GLint), coords.constData());
 
-        // Texture coordinates attribute (location = 1)
+        mProbesChanged = false;
+    }
 
-        mBlenderProgram->setAttributeBuffer(1, GL_FLOAT, 0, 2);
-        mBlenderProgram->enableAttributeArray(1);
+    mDispatchedProbes = mProbes;
+    mDispatchedProbesIteration = mIterationNumber;
 
-        // Input array texture (uniform sampler2DArray inArrayTex)
-        // Set texture unit 0
+    // Output texture may be scaled
 
-        GLint locArrayTex = mBlenderProgram->uniformLocation("inArrayTex");
-        if (locArrayTex >= 0) {
-            glUniform1i(locArrayTex, 0);
-        }
+    GLuint width, height;
+    textureSize(*mOutputTexId, width, height);
 
-        mBlenderProgram->release();
-    }
-}
+    mProbeProgram->bind();
+    mProbeProgram->setUniformValue("numProbes", static_cast<GLuint>(mProbes.size()));
+    mProbeProgram->setUniformValue("scale", QVector2D(static_cast<float>(width) / mBaseTexWidth, static_cast<float>(height) / mBaseTexHeight));
 
+    glBindTextureUnit(0, *mOutputTexId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mProbeCoordsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mProbeValuesBuffer);
 
+    glDispatchCompute((mProbes.size() + 63) / 64, 1, 1);
 
-/*void RenderManager::setIdentityProgram()
-{
-    mIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/identity.vert");
-    mIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/identity.frag");
-    mIdentityProgram->link();
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
-    // Set blender shader attributes
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    glBindTextureUnit(0, 0);
 
-    if (mIdentityProgram->isLinked())
-    {
-        mIdentityProgram->bind();
+    mProbeProgram->release();
 
-        // Vertices coordinates attribute (lcoation = 0)
+    glCopyNamedBufferSubData(mProbeValuesBuffer, mProbeReadBuffer, 0, 0, mProbes.size() * 4 * sizeof(GLfloat));
 
-        mIdentityProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
-        mIdentityProgram->enableAttributeArray(0);
+    mProbeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
 
-        // Texture coordinates attribute (lcoation = 1)
 
-        mIdentityProgram->setAttributeBuffer(1, GL_FLOAT, 0, 2);
-        mIdentityProgram->enableAttributeArray(1);
 
-        // Input texture unit (uniform sampler2D inTexture)
+bool RenderManager::readProbes(QList<QPoint>& probes, QList<QVector3D>& values, unsigned int& iteration)
+{
+    if (!mProbeFence) {
+        return false;
+    }
 
-        GLint locSampler = mIdentityProgram->uniformLocation("inTexture");
-        if (locSampler >= 0)
-            glUniform1i(locSampler, 0);
+    GLenum result = glClientWaitSync(mProbeFence, 0, 0);
 
-        mIdentityProgram->release();
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        return false;
     }
-}*/
 
+    glDeleteSync(mProbeFence);
+    mProbeFence = 0;
 
+    probes = mDispatchedProbes;
+    iteration = mDispatchedProbesIteration;
 
-void RenderManager::verticesCoords(GLfloat& left, GLfloat& right, GLfloat& bottom, GLfloat& top)
-{
-    // Maintain aspect ratio
+    values.reserve(probes.size());
 
-    GLfloat w = static_cast<GLfloat>(mTexWidth);
-    GLfloat h = static_cast<GLfloat>(mTexHeight);
+    for (int i = 0; i < probes.size(); i++) {
+        values.append(QVector3D(mProbeReadData[4 * i], mProbeReadData[4 * i + 1], mProbeReadData[4 * i + 2]));
+    }
 
-    GLfloat ratio = w / h;
+    return true;
+}
 
-    if (mTexWidth > mTexHeight)
+
+
+void RenderManager::setConvergenceDetection(bool set)
+{
+    mConvergenceDetection = set;
+
+    // Next hashed iteration starts a new run
+
+    mHashedIteration = -2;
+    mHashHistory.clear();
+
+    if (mConvergencePeriod != 0)
     {
-        top = 1.0f;
-        bottom = -top;
-        right = top * ratio;
-        left = -right;
+        mConvergencePeriod = 0;
+        emit convergenceChanged(mConvergencePeriod);
     }
-    else
+}
+
+
+
+void RenderManager::hashOutput()
+{
+    if (!mConvergenceDetection || !mOutputTexId || !*mOutputTexId) {
+        return;
+    }
+
+    // Runs of consecutive iterations, broken by resets and by detection being off
+
+    qint64 iteration = mIterationNumber;
+
+    if (iteration != mHashedIteration + 1)
     {
-        right = 1.0f;
-        left = -right;
-        top = right / ratio;
-        bottom = -top;
+        mHashRun++;
+        mHashRunStart = iteration;
+    }
+
+    mHashedIteration = iteration;
+
+    GLuint slot = static_cast<GLuint>(iteration % mHashRingSize);
+
+    glClearNamedBufferSubData(mHashBuffer, GL_R32UI, slot * 2 * sizeof(GLuint), 2 * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    mHashProgram->bind();
+    mHashProgram->setUniformValue("slot", slot);
+    mHashProgram->setUniformValue("levels", mHashLevels);
+
+    glBindTextureUnit(0, *mOutputTexId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mHashBuffer);
+
+    glDispatchCompute(mHashGridSize, mHashGridSize, 1);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindTextureUnit(0, 0);
+
+    mHashProgram->release();
+
+    // Whole ring copied, unless previous copy still in flight
+
+    if (!mHashFence)
+    {
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        glCopyNamedBufferSubData(mHashBuffer, mHashReadBuffer, 0, 0, mHashRingSize * 2 * sizeof(GLuint));
+
+        mHashFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        mHashFenceIteration = iteration;
+        mHashFenceRun = mHashRun;
+        mHashFenceRunStart = mHashRunStart;
     }
 }
 
 
 
-void RenderManager::setVao()
+bool RenderManager::readHashes()
 {
-    // Recompute vertices coordinates
+    if (!mHashFence) {
+        return false;
+    }
 
-    GLfloat left, right, bottom, top;
-    verticesCoords(left, right, bottom, top);
+    GLenum result = glClientWaitSync(mHashFence, 0, 0);
 
-    GLfloat vertCoords[] = {
-        left, bottom,
-        right, bottom,
-        left, top,
-        right, top
-    };
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+        return false;
+    }
 
-    GLfloat texCoords[] = {
-        0.0f, 0.0f,  // Bottom-left
-        1.0f, 0.0f,  // Bottom-right
-        0.0f, 1.0f,  // Top-left
-        1.0f, 1.0f   // Top-right
-    };
+    glDeleteSync(mHashFence);
+    mHashFence = 0;
 
-    glBindVertexArray(mVao);
+    if (!mConvergenceDetection) {
+        return false;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVboPos);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertCoords), vertCoords, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // History restarted on a new run, or if ring was overwritten before being read
 
-    glBindBuffer(GL_ARRAY_BUFFER, mVboTex);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(texCoords), texCoords, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (mHashFenceRun != mReadHashRun)
+    {
+        mHashHistory.clear();
+        mReadHashRun = mHashFenceRun;
+        mReadHashIteration = mHashFenceRunStart - 1;
+    }
 
-    glBindVertexArray(0);
+    qint64 first = mReadHashIteration + 1;
+
+    if (first < mHashFenceIteration - mHashRingSize + 1)
+    {
+        mHashHistory.clear();
+        first = mHashFenceIteration - mHashRingSize + 1;
+    }
+
+    for (qint64 iteration = first; iteration <= mHashFenceIteration; iteration++)
+    {
+        qint64 slot = iteration % mHashRingSize;
+        mHashHistory.append((static_cast<quint64>(mHashReadData[2 * slot + 1]) << 32) | mHashReadData[2 * slot]);
+    }
+
+    mReadHashIteration = std::max(mReadHashIteration, mHashFenceIteration);
+
+    qsizetype maxSize = (mPeriodRepeats + 1) * mMaxPeriod;
+
+    if (mHashHistory.size() > maxSize) {
+        mHashHistory.remove(0, mHashHistory.size() - maxSize);
+    }
+
+    int period = detectPeriod();
+
+    if (period != mConvergencePeriod)
+    {
+        mConvergencePeriod = period;
+        return true;
+    }
+
+    return false;
 }
 
 
 
-void RenderManager::adjustOrtho()
+int RenderManager::detectPeriod()
 {
-    GLfloat left, right, bottom, top;
-    verticesCoords(left, right, bottom, top);
+    // Smallest period whose last repeats all match: 1 is a fixed point, 0 means none
 
-    foreach (ImageOperation* operation, mFactory->operations()) {
-        operation->adjustOrtho(left, right, bottom, top);
+    qsizetype size = mHashHistory.size();
+
+    for (int period = 1; period <= mMaxPeriod; period++)
+    {
+        qsizetype needed = (mPeriodRepeats + 1) * period;
+
+        if (size < needed) {
+            break;
+        }
+
+        bool periodic = true;
+
+        for (qsizetype i = size - needed + period; i < size && periodic; i++) {
+            periodic = mHashHistory[i] == mHashHistory[i - period];
+        }
+
+        if (periodic) {
+            return period;
+        }
     }
 
-    // Orthographic projection: blender
+    return 0;
+}
 
-    QMatrix4x4 matrix;
-    matrix.setToIdentity();
-    matrix.ortho(left, right, bottom, top, -1.0, 1.0);
+
+
+TextureFormat RenderManager::texFormat()
+{
+    return mTexFormat;
+}
+
+
+
+void RenderManager::setTextureFormat(TextureFormat format)
+{
+    mTexFormat = format;
 
     mContext->makeCurrent(mSurface);
-    mBlenderProgram->bind();
 
-    int locOrtho = mBlenderProgram->uniformLocation("ortho");
-    mBlenderProgram->setUniformValue(locOrtho, matrix);
+    foreach (Seed* seed, mFactory->seeds()) {
+        foreach (GLuint* texId, seed->textureIds()) {
+            regenTexture(texId, mTexFormat, mTexWidth, mTexHeight);
+        }
+    }
+
+    // Operations with their own texture format keep it
+
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        if (operation->texFormatInherited())
+        {
+            foreach (GLuint* texId, operation->textureIds()) {
+                regenTexture(texId, operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+            }
+
+            if (operation->sampler2DArrayAvail()) {
+                recreateArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth(), operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+            }
+
+            operation->setAllocatedTextures(operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    mBlenderProgram->release();
     mContext->doneCurrent();
+
+    foreach (Seed* seed, mFactory->seeds()) {
+        seed->setOutTextureId();
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        operation->setBlitInTextureId();
+        operation->setOutTextureId();
+    }
+
+    emit texturesChanged();
 }
 
 
 
-void RenderManager::genTexture(GLuint* texId, TextureFormat texFormat)
+void RenderManager::updateOperationTextures(ImageOperation* operation)
 {
-    // Allocated on immutable storage (glTexStorage2D)
-    // To be called within active OpenGL context
+    // Regenerate operation's textures with its current format and resolution scale
 
-    glGenTextures(1, texId);
+    TextureFormat format = operationTexFormat(operation);
+    GLuint width = operationTexWidth(operation);
+    GLuint height = operationTexHeight(operation);
 
-    glBindTexture(GL_TEXTURE_2D, *texId);
+    mContext->makeCurrent(mSurface);
 
-    glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(texFormat), mTexWidth, mTexHeight);
+    foreach (GLuint* texId, operation->textureIds()) {
+        regenTexture(texId, format, width, height);
+    }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (operation->sampler2DArrayAvail()) {
+        recreateArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth(), format, width, height);
+    }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    operation->setAllocatedTextures(format, width, height);
+
+    mContext->doneCurrent();
+
+    foreach (ImageOperation* op, mFactory->operations())
+    {
+        op->setBlitInTextureId();
+        op->setOutTextureId();
+    }
+
+    emit texturesChanged();
+}
+
+
+
+GLuint RenderManager::texWidth()
+{
+    return mBaseTexWidth;
+}
+
+
+
+GLuint RenderManager::texHeight()
+{
+    return mBaseTexHeight;
+}
+
+
+
+void RenderManager::resetIterationNumer()
+{
+    mIterationNumber = 0;
+}
+
+
+
+int RenderManager::iterationNumber()
+{
+    return mIterationNumber;
+}
+
+
+
+QString RenderManager::version()
+{
+    return mVersion;
+}
+
+
+void RenderManager::resize(GLuint width, GLuint height)
+{
+    mBaseTexWidth = width;
+    mBaseTexHeight = height;
+
+    setOutputImage();
+
+    if (mContext)
+    {
+        mContext->makeCurrent(mSurface);
+
+        setPbo();
+
+        // Frame texture stays at requested size
+
+        regenTexture(&mFrameTexId, TextureFormat::RGBA8, mBaseTexWidth, mBaseTexHeight);
+
+        mContext->doneCurrent();
+    }
+
+    float scale = resolutionStepScale();
+    setTextureSize(scaledSize(width, scale), scaledSize(height, scale));
+
+    if (mResolutionStep > 0) {
+        emit effectiveSizeChanged(mTexWidth, mTexHeight);
+    }
+}
+
+
+
+void RenderManager::setTextureSize(GLuint width, GLuint height)
+{
+    mTexWidth = width;
+    mTexHeight = height;
+
+    if (mContext)
+    {
+        mContext->makeCurrent(mSurface);
+
+        setVao();
+        foreach (Seed* seed, mFactory->seeds()) {
+            seed->setVao(width, height);
+        }
+
+        glViewport(0, 0, mTexWidth, mTexHeight);
+
+        resizeTextures();
+        deleteBlendArrayTextures();
+        deletePassTextures();
+
+        foreach (ImageOperation* operation, mFactory->operations()) {
+            if (operation->sampler2DArrayAvail()) {
+                recreateArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth(), operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+            }
+        }
+
+        mContext->doneCurrent();
+
+        adjustOrtho();
+    }
+}
+
+
+
+void RenderManager::setOutputTextureId(GLuint* pTexId)
+{
+    mOutputTexId = pTexId;
+}
+
+
+
+void RenderManager::initOperation(QUuid id, ImageOperation* operation)
+{
+    Q_UNUSED(id)
+
+    // Preloaded operation: program linked, parameters set and textures allocated already
+    // Textures regenerated only if size or format changed since
+
+    if (operation->initialized())
+    {
+        adjustOperationOrtho(operation);
+
+        if (operationTexturesStale(operation)) {
+            updateOperationTextures(operation);
+        }
+
+        return;
+    }
+
+    // Init and link shaders
+
+    operation->init(mContext, mSurface);
+    operation->linkShaders();
+
+    // Adjust orthographic projection if any
+
+    adjustOperationOrtho(operation);
+
+    // Set parameters
+
+    operation->setAllParameters();
+
+    genOpTextures(operation);
+}
+
+
+
+void RenderManager::initSeed(QUuid id, Seed* seed)
+{
+    Q_UNUSED(id)
+
+    seed->init(static_cast<GLenum>(mTexFormat), mTexWidth, mTexHeight, mContext, mSurface);
+
+    foreach (GLuint* texId, seed->textureIds()) {
+        mTextureInfos.insert(*texId, { static_cast<GLenum>(mTexFormat), mTexWidth, mTexHeight });
+    }
+}
+
+
+void RenderManager::adjustOperationOrtho(ImageOperation* operation)
+{
+    GLfloat left, right, bottom, top;
+    verticesCoords(left, right, bottom, top);
+
+    operation->adjustOrtho(left, right, bottom, top);
+}
+
+
+void RenderManager::setSortedOperations(QList<ImageOperation*> sortedOperations)
+{
+    mSortedOperations = sortedOperations;
+    mOperationVersions.clear();
+    mInputRegions.clear();
+}
+
+
+
+void RenderManager::reset()
+{
+    clearAllOpsTextures();
+    drawAllSeeds();
+    resetIterationNumer();
+}
+
+
+
+void RenderManager::genImageTexture(QByteArray devId)
+{
+    if (!mVideoTextures.contains(devId))
+    {
+        GLuint newTexId = 0;
+        mContext->makeCurrent(mSurface);
+        genTexture(&newTexId, mTexFormat);
+        clearTexture(&newTexId);
+        mContext->doneCurrent();
+
+        mVideoTextures.insert(devId, newTexId);
+
+        QImage img(mTexWidth, mTexHeight, QImage::Format_RGBA8888);
+        img.fill(Qt::black);
+        mFrameImageMap.insert(devId, img);
+    }
+}
+
+
+
+void RenderManager::delImageTexture(QByteArray devId)
+{
+    if (mVideoTextures.contains(devId))
+    {
+        mContext->makeCurrent(mSurface);
+        mTextureInfos.remove(mVideoTextures[devId]);
+        glDeleteTextures(1, &mVideoTextures[devId]);
+        mContext->doneCurrent();
+
+        mVideoTextures.remove(devId);
+        mFrameImageMap.remove(devId);
+    }
+}
+
+
+void RenderManager::setVideoTextures()
+{
+    foreach (Seed* seed, mFactory->seeds())
+    {
+        QByteArray devId = seed->videoDevId();
+        seed->setVideoTexture(mVideoTextures.value(devId, 0));
+    }
+}
+
+
+
+void RenderManager::setFrameImage(QByteArray devId, QImage image)
+{
+    mFrameImageMap[devId] = image;
+}
+
+
+
+void RenderManager::setImageTextures()
+{
+    for (auto [devId, image] : mFrameImageMap.asKeyValueRange())
+    {
+        if (!image.isNull() && mVideoTextures.contains(devId))
+        {
+            qreal sx = static_cast<qreal>(mTexWidth)  / image.width();
+            qreal sy = static_cast<qreal>(mTexHeight) / image.height();
+            qreal scale = qMin(1.0, qMin(sx, sy));
+
+            int displayWidth = qRound(image.width() * scale);
+            int displayHeight = qRound(image.height() * scale);
+
+            int offsetX = (mTexWidth  - displayWidth) / 2;
+            int offsetY = (mTexHeight - displayHeight) / 2;
+
+            QImage scaled = image.scaled(displayWidth, displayHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+            QImage buffer(mTexWidth, mTexHeight, QImage::Format_RGBA8888);
+            buffer.fill(Qt::black);
+
+            QPainter painter(&buffer);
+            painter.drawImage(offsetX, offsetY, scaled);
+
+            // mContext->makeCurrent(mSurface);
+
+            glBindTexture(GL_TEXTURE_2D, mVideoTextures[devId]);
+
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, mTexWidth, mTexHeight, GL_RGBA, GL_UNSIGNED_BYTE, buffer.constBits());
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            // mContext->doneCurrent();
+        }
+    }
+}
+
+
+
+void RenderManager::setBlenderProgram()
+{
+    mBlenderProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/blender.vert");
+    mBlenderProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/blender.frag");
+    mBlenderProgram->link();
+
+    // Set blender shader attributes
+
+    if (mBlenderProgram->isLinked())
+    {
+        mBlenderProgram->bind();
+
+        // Vertices coordinates attribute (location = 0)
+
+        mBlenderProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+        mBlenderProgram->enableAttributeArray(0);
+
+        // Texture coordinates attribute (location = 1)
+
+        mBlenderProgram->setAttributeBuffer(1, GL_FLOAT, 0, 2);
+        mBlenderProgram->enableAttributeArray(1);
+
+        // Input array texture (uniform sampler2DArray inArrayTex)
+        // Set texture unit 0
+
+        GLint locArrayTex = mBlenderProgram->uniformLocation("inArrayTex");
+        if (locArrayTex >= 0) {
+            glUniform1i(locArrayTex, 0);
+        }
+
+        mBlenderProgram->release();
+    }
+}
+
+
+
+void RenderManager::setTileProgram()
+{
+    mTileProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/tile.vert");
+    mTileProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/tile.frag");
+    mTileProgram->link();
+
+    // Input texture (uniform sampler2D inTexture): texture unit 0
+
+    if (mTileProgram->isLinked())
+    {
+        mTileProgram->bind();
+
+        GLint locSampler = mTileProgram->uniformLocation("inTexture");
+        if (locSampler >= 0) {
+            glUniform1i(locSampler, 0);
+        }
+
+        mTileProgram->release();
+    }
+}
+
+
+
+void RenderManager::setProbeProgram()
+{
+    mProbeProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/probe.comp");
+    mProbeProgram->link();
+
+    // Output texture (uniform sampler2D inTexture): texture unit 0
+
+    if (mProbeProgram->isLinked())
+    {
+        mProbeProgram->bind();
+
+        GLint locSampler = mProbeProgram->uniformLocation("inTexture");
+        if (locSampler >= 0) {
+            glUniform1i(locSampler, 0);
+        }
+
+        mProbeProgram->release();
+    }
+}
+
+
+
+void RenderManager::setHashProgram()
+{
+    mHashProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/frame_hash.comp");
+    mHashProgram->link();
+
+    // Output texture (uniform sampler2D inTexture): texture unit 0
+
+    if (mHashProgram->isLinked())
+    {
+        mHashProgram->bind();
+
+        GLint locSampler = mHashProgram->uniformLocation("inTexture");
+        if (locSampler >= 0) {
+            glUniform1i(locSampler, 0);
+        }
+
+        mHashProgram->release();
+    }
+}
+
+
+
+void RenderManager::setLutPrograms()
+{
+    mLutProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/tile.vert");
+    mLutProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lut.frag");
+    mLutProgram->link();
+
+    // Input texture on unit 0, LUT on unit 1
+
+    if (mLutProgram->isLinked())
+    {
+        mLutProgram->bind();
+        mLutProgram->setUniformValue("inTexture", 0);
+        mLutProgram->setUniformValue("lut", 1);
+        mLutProgram->setUniformValue("lutSize", static_cast<GLfloat>(mLutSize));
+        mLutProgram->release();
+    }
+
+    mLutIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/tile.vert");
+    mLutIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/lut_identity.frag");
+    mLutIdentityProgram->link();
+
+    if (mLutIdentityProgram->isLinked())
+    {
+        mLutIdentityProgram->bind();
+        mLutIdentityProgram->setUniformValue("lutSize", static_cast<GLint>(mLutSize));
+        mLutIdentityProgram->release();
+    }
+}
+
+
+
+void RenderManager::setStatisticsPrograms()
+{
+    mStatsProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/statistics.comp");
+    mStatsProgram->link();
+
+    mStatsReduceProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/statistics_reduce.comp");
+    mStatsReduceProgram->link();
+
+    // Input texture (uniform sampler2D inTexture): texture unit 0
+
+    if (mStatsProgram->isLinked())
+    {
+        mStatsProgram->bind();
+
+        GLint locSampler = mStatsProgram->uniformLocation("inTexture");
+        if (locSampler >= 0) {
+            glUniform1i(locSampler, 0);
+        }
+
+        mStatsProgram->release();
+    }
+}
+
+
+
+/*void RenderManager::setIdentityProgram()
+{
+    mIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/identity.vert");
+    mIdentityProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/identity.frag");
+    mIdentityProgram->link();
+
+    // Set blender shader attributes
+
+    if (mIdentityProgram->isLinked())
+    {
+        mIdentityProgram->bind();
+
+        // Vertices coordinates attribute (lcoation = 0)
+
+        mIdentityProgram->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+        mIdentityProgram->enableAttributeArray(0);
+
+        // Texture coordinates attribute (lcoation = 1)
+
+        mIdentityProgram->setAttributeBuffer(1, GL_FLOAT, 0, 2);
+        mIdentityProgram->enableAttributeArray(1);
+
+        // Input texture unit (uniform sampler2D inTexture)
+
+        GLint locSampler = mIdentityProgram->uniformLocation("inTexture");
+        if (locSampler >= 0)
+            glUniform1i(locSampler, 0);
+
+        mIdentityProgram->release();
+    }
+}*/
+
+
+
+void RenderManager::verticesCoords(GLfloat& left, GLfloat& right, GLfloat& bottom, GLfloat& top)
+{
+    // Maintain aspect ratio
+
+    GLfloat w = static_cast<GLfloat>(mTexWidth);
+    GLfloat h = static_cast<GLfloat>(mTexHeight);
+
+    GLfloat ratio = w / h;
+
+    if (mTexWidth > mTexHeight)
+    {
+        top = 1.0f;
+        bottom = -top;
+        right = top * ratio;
+        left = -right;
+    }
+    else
+    {
+        right = 1.0f;
+        left = -right;
+        top = right / ratio;
+        bottom = -top;
+    }
+}
+
+
+
+void RenderManager::setVao()
+{
+    // Recompute vertices coordinates
+
+    GLfloat left, right, bottom, top;
+    verticesCoords(left, right, bottom, top);
+
+    GLfloat vertCoords[] = {
+        left, bottom,
+        right, bottom,
+        left, top,
+        right, top
+    };
+
+    GLfloat texCoords[] = {
+        0.0f, 0.0f,  // Bottom-left
+        1.0f, 0.0f,  // Bottom-right
+        0.0f, 1.0f,  // Top-left
+        1.0f, 1.0f   // Top-right
+    };
+
+    glBindVertexArray(mVao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVboPos);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertCoords), vertCoords, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mVboTex);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(texCoords), texCoords, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(0);
+}
+
+
+
+void RenderManager::adjustOrtho()
+{
+    GLfloat left, right, bottom, top;
+    verticesCoords(left, right, bottom, top);
+
+    foreach (ImageOperation* operation, mFactory->operations()) {
+        operation->adjustOrtho(left, right, bottom, top);
+    }
+
+    // Orthographic projection: blender
+
+    QMatrix4x4 matrix;
+    matrix.setToIdentity();
+    matrix.ortho(left, right, bottom, top, -1.0, 1.0);
+
+    mContext->makeCurrent(mSurface);
+    mBlenderProgram->bind();
+
+    int locOrtho = mBlenderProgram->uniformLocation("ortho");
+    mBlenderProgram->setUniformValue(locOrtho, matrix);
+
+    mBlenderProgram->release();
+    mContext->doneCurrent();
+}
+
+
+
+TextureFormat RenderManager::operationTexFormat(ImageOperation* operation)
+{
+    TextureFormat format = operation->texFormatInherited() ? mTexFormat : operation->texFormat();
+
+    // Compute operations bind their outputs as images: formats without image support promoted
+
+    return operation->isCompute() ? imageTextureFormat(format) : format;
+}
+
+
+
+bool RenderManager::operationTexturesStale(ImageOperation* operation)
+{
+    return operation->allocatedTexWidth() != operationTexWidth(operation) ||
+           operation->allocatedTexHeight() != operationTexHeight(operation) ||
+           operation->allocatedTexFormat() != operationTexFormat(operation);
+}
+
+
+
+GLenum RenderManager::textureInternalFormat(GLuint texId)
+{
+    auto info = mTextureInfos.constFind(texId);
+
+    if (info != mTextureInfos.constEnd()) {
+        return info->format;
+    }
+
+    GLint format = 0;
+
+    if (texId) {
+        glGetTextureLevelParameteriv(texId, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+    }
+
+    return static_cast<GLenum>(format);
+}
+
+
+
+GLuint RenderManager::scaledSize(GLuint size, float scale)
+{
+    GLuint scaled = static_cast<GLuint>(qRound(size * scale));
+    return scaled > 0 ? scaled : 1;
+}
+
+
+
+GLuint RenderManager::operationTexWidth(ImageOperation* operation)
+{
+    return scaledSize(mTexWidth, operation->resolutionScale());
+}
+
+
+
+GLuint RenderManager::operationTexHeight(ImageOperation* operation)
+{
+    return scaledSize(mTexHeight, operation->resolutionScale());
+}
+
+
+
+void RenderManager::textureSize(GLuint texId, GLuint& width, GLuint& height)
+{
+    auto info = mTextureInfos.constFind(texId);
+
+    if (info != mTextureInfos.constEnd())
+    {
+        width = info->width;
+        height = info->height;
+        return;
+    }
+
+    GLint w = 0;
+    GLint h = 0;
+
+    if (texId)
+    {
+        glGetTextureLevelParameteriv(texId, 0, GL_TEXTURE_WIDTH, &w);
+        glGetTextureLevelParameteriv(texId, 0, GL_TEXTURE_HEIGHT, &h);
+    }
+
+    width = static_cast<GLuint>(w);
+    height = static_cast<GLuint>(h);
+}
+
+
+
+void RenderManager::genTexture(GLuint* texId, TextureFormat texFormat)
+{
+    genTexture(texId, texFormat, mTexWidth, mTexHeight);
+}
+
+
+
+void RenderManager::genTexture(GLuint* texId, TextureFormat texFormat, GLuint width, GLuint height)
+{
+    // Allocated on immutable storage (glTexStorage2D)
+    // To be called within active OpenGL context
+
+    glGenTextures(1, texId);
+
+    glBindTexture(GL_TEXTURE_2D, *texId);
+
+    glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(texFormat), width, height);
+
+    mTextureInfos.insert(*texId, { static_cast<GLenum>(texFormat), width, height });
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+
+
+void RenderManager::genOpTextures(ImageOperation* operation)
+{
+    mContext->makeCurrent(mSurface);
+
+    TextureFormat format = operationTexFormat(operation);
+    GLuint width = operationTexWidth(operation);
+    GLuint height = operationTexHeight(operation);
+
+    foreach (GLuint* texId, operation->textureIds())
+    {
+        genTexture(texId, format, width, height);
+        clearTexture(texId);
+    }
+
+    if (operation->sampler2DArrayAvail()) {
+        genArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth(), format, width, height);
+    }
+
+    operation->setAllocatedTextures(format, width, height);
+
+    mContext->doneCurrent();
+}
+
+
+
+void RenderManager::genArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth, TextureFormat texFormat, GLuint width, GLuint height)
+{
+    glGenTextures(1, arrayTexId);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, *arrayTexId);
+
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, static_cast<GLenum>(texFormat), width, height, arrayTexDepth);
+
+    mTextureInfos.insert(*arrayTexId, { static_cast<GLenum>(texFormat), width, height });
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+
+
+void RenderManager::blitTextures(GLuint srcTexId, GLuint srcTexWidth, GLuint srcTexHeight, GLuint dstTexId, GLuint dstTexWidth, GLuint dstTexHeight)
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mReadFbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, srcTexId, 0);
+
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDrawFbo);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dstTexId, 0);
+
+    glBlitFramebuffer(0, 0, srcTexWidth, srcTexHeight, 0, 0, dstTexWidth, dstTexHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+}
+
+
+
+void RenderManager::regenTexture(GLuint* texId, TextureFormat texFormat, GLuint width, GLuint height)
+{
+    // Contents may change: render all operations next iteration
+
+    mOperationVersions.clear();
+
+    // Generate new texture and blit old one to it
+
+    GLuint oldWidth, oldHeight;
+    textureSize(*texId, oldWidth, oldHeight);
+
+    GLuint newTexId = 0;
+    genTexture(&newTexId, texFormat, width, height);
+
+    blitTextures(*texId, oldWidth, oldHeight, newTexId, width, height);
+
+    mTextureInfos.remove(*texId);
+    glDeleteTextures(1, texId);
+    *texId = newTexId;
+}
+
+
+
+void RenderManager::copyTexture(GLuint srcTexId, GLuint dstTexId)
+{
+    // Direct copy if formats and sizes match, otherwise convert and resample through blit
+
+    GLuint srcWidth, srcHeight, dstWidth, dstHeight;
+    textureSize(srcTexId, srcWidth, srcHeight);
+    textureSize(dstTexId, dstWidth, dstHeight);
+
+    if (textureInternalFormat(srcTexId) == textureInternalFormat(dstTexId) && srcWidth == dstWidth && srcHeight == dstHeight) {
+        glCopyImageSubData(srcTexId, GL_TEXTURE_2D, 0, 0, 0, 0, dstTexId, GL_TEXTURE_2D, 0, 0, 0, 0, dstWidth, dstHeight, 1);
+    }
+    else {
+        blitTextures(srcTexId, srcWidth, srcHeight, dstTexId, dstWidth, dstHeight);
+    }
+}
+
+
+
+void RenderManager::copyTextureToLayer(GLuint srcTexId, GLuint arrayTexId, GLint layer)
+{
+    // Direct copy if formats and sizes match, otherwise convert and resample through blit
+
+    GLuint srcWidth, srcHeight, dstWidth, dstHeight;
+    textureSize(srcTexId, srcWidth, srcHeight);
+    textureSize(arrayTexId, dstWidth, dstHeight);
+
+    if (textureInternalFormat(srcTexId) == textureInternalFormat(arrayTexId) && srcWidth == dstWidth && srcHeight == dstHeight)
+    {
+        glCopyImageSubData(srcTexId, GL_TEXTURE_2D, 0, 0, 0, 0, arrayTexId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, dstWidth, dstHeight, 1);
+    }
+    else
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, mReadFbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, srcTexId, 0);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDrawFbo);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, arrayTexId, 0, layer);
+
+        glBlitFramebuffer(0, 0, srcWidth, srcHeight, 0, 0, dstWidth, dstHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    }
+}
+
+
+
+void RenderManager::resizeTextures()
+{
+    // Store old texture Ids, generate new textures and blit old to new ones
+
+    foreach (Seed* seed, mFactory->seeds()) {
+        foreach (GLuint* texId, seed->textureIds()) {
+            regenTexture(texId, mTexFormat, mTexWidth, mTexHeight);
+        }
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        foreach (GLuint* texId, operation->textureIds()) {
+            regenTexture(texId, operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+        }
+
+        operation->setAllocatedTextures(operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+    }
+
+    // Resize video textures
+
+    for (auto [devId, texId] : mVideoTextures.asKeyValueRange()) {
+        regenTexture(&texId, mTexFormat, mTexWidth, mTexHeight);
+    }
+
+    setVideoTextures();
+
+    // Set output texture Ids
+
+    foreach (Seed* seed, mFactory->seeds())
+    {
+        seed->resizeImage();
+        seed->setOutTextureId();
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations())
+    {
+        operation->setBlitInTextureId();
+        operation->setOutTextureId();
+        // operation->resetInputData();
+    }
+
+    emit texturesChanged();
+}
+
+
+
+void RenderManager::recreateArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth, TextureFormat texFormat, GLuint width, GLuint height)
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    mTextureInfos.remove(*arrayTexId);
+    glDeleteTextures(1, arrayTexId);
+    genArrayTexture(arrayTexId, arrayTexDepth, texFormat, width, height);
+}
+
+
+
+GLuint RenderManager::blendArrayTexture(TextureFormat format, GLuint width, GLuint height)
+{
+    // Blend array textures are generated on demand, one per format and size in use
+
+    auto key = std::make_tuple(format, width, height);
+
+    if (!mBlendArrayTexIds.contains(key))
+    {
+        GLuint arrayTexId = 0;
+        genArrayTexture(&arrayTexId, mNumArrayTexLayers, format, width, height);
+        mBlendArrayTexIds.insert(key, arrayTexId);
+    }
+
+    return mBlendArrayTexIds.value(key);
+}
+
+
+
+void RenderManager::deleteBlendArrayTextures()
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    foreach (GLuint arrayTexId, mBlendArrayTexIds)
+    {
+        mTextureInfos.remove(arrayTexId);
+        glDeleteTextures(1, &arrayTexId);
+    }
+
+    mBlendArrayTexIds.clear();
+}
+
+
+
+GLuint RenderManager::passTexture(TextureFormat format, GLuint width, GLuint height, int slot)
+{
+    // Intermediate textures of multi-pass operations, shared among them: fully rewritten each pass
+    // Two slots per format and size, so that a pass never reads and writes the same texture
+    // Third slot: ping-pong partner of output texture when sub-stepping
+
+    auto key = std::make_tuple(format, width, height, slot);
+
+    if (!mPassTexIds.contains(key))
+    {
+        GLuint texId = 0;
+        genTexture(&texId, format, width, height);
+        mPassTexIds.insert(key, texId);
+    }
+
+    return mPassTexIds.value(key);
+}
+
+
+
+void RenderManager::deletePassTextures()
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    foreach (GLuint texId, mPassTexIds)
+    {
+        mTextureInfos.remove(texId);
+        glDeleteTextures(1, &texId);
+    }
+
+    mPassTexIds.clear();
+}
+
+
+
+void RenderManager::shiftCopyArrayTextures()
+{
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        if (operation->sampler2DArrayAvail())
+        {
+            // Shift layers back by copying
+
+            for (GLint z = operation->arrayTextureDepth() - 2; z >= 0; z--) {
+                glCopyImageSubData(*operation->arrayTextureId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, z, *operation->arrayTextureId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, z + 1, operationTexWidth(operation), operationTexHeight(operation), 1);
+            }
+
+            // Copy input texture to first layer
+
+            copyTextureToLayer(operation->inTextureId(), *operation->arrayTextureId(), 0);
+        }
+    }
+}
+
+
+
+void RenderManager::copyTexturesToBlendArrayTexture(QList<GLuint*> textures, GLuint arrayTexId)
+{
+    int nTextures = textures.size();
+    if (nTextures > mMaxArrayTexLayers) {
+        nTextures = mMaxArrayTexLayers;
+    }
+
+    for (int i = 0; i < nTextures; i++) {
+        copyTextureToLayer(*textures[i], arrayTexId, i);
+    }
+}
+
+
+
+void RenderManager::clearTexture(GLuint* texId)
+{
+    mOperationVersions.clear();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texId, 0);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+
+void RenderManager::clearArrayTexture(GLuint* texId, GLsizei arrayTexDepth)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+
+    for (GLsizei layer = 0; layer < arrayTexDepth; layer++)
+    {
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, *texId, 0, layer);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+
+void RenderManager::clearAllOpsTextures()
+{
+    QList<GLuint*> texIds;
+
+    foreach (ImageOperation* operation, mFactory->operations()) {
+        texIds.append(operation->textureIds());
+    }
+
+    mContext->makeCurrent(mSurface);
+
+    foreach (GLuint* texId, texIds) {
+        clearTexture(texId);
+    }
+
+    foreach (ImageOperation* operation, mFactory->operations()) {
+        if (operation->sampler2DArrayAvail()) {
+            clearArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth());
+        }
+    }
+
+    mContext->doneCurrent();
+}
+
+
+
+void RenderManager::holdOutput()
+{
+    // Copy of current output, kept while its operation gets replaced
+
+    if (!mOutputTexId || !*mOutputTexId) {
+        return;
+    }
+
+    mContext->makeCurrent(mSurface);
+
+    GLuint width, height;
+    textureSize(*mOutputTexId, width, height);
+
+    if (mHeldOutputTexId)
+    {
+        mTextureInfos.remove(mHeldOutputTexId);
+        glDeleteTextures(1, &mHeldOutputTexId);
+    }
+
+    genTexture(&mHeldOutputTexId, static_cast<TextureFormat>(textureInternalFormat(*mOutputTexId)), width, height);
+    copyTexture(*mOutputTexId, mHeldOutputTexId);
+
+    mContext->doneCurrent();
+}
+
+
+
+void RenderManager::carryOverOutput(ImageOperation* operation)
+{
+    // Held output copied to all textures of operation, feedback continuing from it
+    // Done once operation's textures have their final size: copies resample otherwise
+
+    if (!mHeldOutputTexId) {
+        return;
+    }
+
+    mContext->makeCurrent(mSurface);
+
+    foreach (GLuint* texId, operation->textureIds())
+    {
+        if (*texId) {
+            copyTexture(mHeldOutputTexId, *texId);
+        }
+    }
+
+    mTextureInfos.remove(mHeldOutputTexId);
+    glDeleteTextures(1, &mHeldOutputTexId);
+    mHeldOutputTexId = 0;
+
+    mContext->doneCurrent();
+}
+
+
+
+qint64 RenderManager::operationTextureBytes(ImageOperation* operation)
+{
+    qint64 texelBytes = textureFormatBytes(operationTexFormat(operation));
+    qint64 imageBytes = texelBytes * operationTexWidth(operation) * operationTexHeight(operation);
+
+    qint64 bytes = imageBytes * operation->textureIds().size();
+
+    if (operation->sampler2DArrayAvail()) {
+        bytes += imageBytes * operation->arrayTextureDepth();
+    }
+
+    return bytes;
+}
+
+
+
+void RenderManager::drawAllSeeds()
+{
+    foreach (Seed* seed, mFactory->seeds()) {
+        seed->draw();
+    }
+}
+
+
+
+void RenderManager::copyTextures()
+{
+    // Expects active OpenGL context
+
+    foreach (ImageOperation* operation, mSortedOperations) {
+        if (operation->blitEnabled()) {
+            copyTexture(operation->blitInTextureId(), operation->blitOutTextureId());
+        }
+    }
+}
+
+
+
+void RenderManager::blend(ImageOperation *operation)
+{
+    // Copy input textures to blend 2D array texture and wait for copy to finish before using it
+
+    GLuint arrayTexId = blendArrayTexture(operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation));
+
+    copyTexturesToBlendArrayTexture(operation->inputTextures(), arrayTexId);
+    // glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // Conversions and resampling blit through read and draw framebuffers: rebind output one
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+
+    // Bind blend output texture, where render will occur
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, operation->blendOutTextureId(), 0);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    mBlenderProgram->bind();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexId);
+
+    // Set blend factors
+
+    QList<float> weights(mNumArrayTexLayers, 0.0f);
+    int i = 0;
+    for (auto factor : operation->inputBlendFactors())
+    {
+        weights[i++] = factor->value();
+
+        if (i > mNumArrayTexLayers) {
+            break;
+        }
+    }
+
+    GLint locWeights = mBlenderProgram->uniformLocation("weights");
+    glUniform1fv(locWeights, mNumArrayTexLayers, weights.constData());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // Clean up
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    mBlenderProgram->release();
+}
+
+
+
+void RenderManager::renderOperation(ImageOperation* operation)
+{
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, operation->outTextureId(), 0);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    operation->program()->bind();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, operation->inTextureId());
+
+    glBindSampler(0, operation->samplerId());
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glBindSampler(0, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    operation->program()->release();
+}
+
+
+
+void RenderManager::renderSubsteps(ImageOperation* operation)
+{
+    // Each step reads previous one's output: ping-pong between scratch and output textures, last step into output
+
+    int substeps = operation->substeps();
+
+    GLuint inTexId = operation->inTextureId();
+
+    for (int step = 0; step < substeps; step++)
+    {
+        GLuint outTexId = operation->outTextureId();
+
+        if ((substeps - 1 - step) % 2 == 1) {
+            outTexId = passTexture(operationTexFormat(operation), operationTexWidth(operation), operationTexHeight(operation), 2);
+        }
+
+        renderPasses(operation, inTexId, outTexId);
+
+        inTexId = outTexId;
+    }
+}
+
+
+
+void RenderManager::renderPasses(ImageOperation* operation, GLuint srcTexId, GLuint outTexId)
+{
+    // Each pass reads previous one's output, at its own resolution relative to operation's
+
+    TextureFormat format = operationTexFormat(operation);
+    GLuint width = operationTexWidth(operation);
+    GLuint height = operationTexHeight(operation);
+
+    GLuint inTexId = srcTexId;
+
+    for (int pass = 0; pass < operation->numPasses(); pass++)
+    {
+        GLuint passWidth = scaledSize(width, operation->passScale(pass));
+        GLuint passHeight = scaledSize(height, operation->passScale(pass));
+
+        GLuint passTexId = passTexture(format, passWidth, passHeight, pass % 2);
+
+        GLuint inWidth, inHeight;
+        textureSize(inTexId, inWidth, inHeight);
+
+        glViewport(0, 0, passWidth, passHeight);
+
+        operation->setInputResampled(inWidth != passWidth || inHeight != passHeight);
+        operation->renderPass(pass, inTexId, passTexId, srcTexId);
+
+        inTexId = passTexId;
+    }
+
+    // Main pass
+
+    GLuint inWidth, inHeight;
+    textureSize(inTexId, inWidth, inHeight);
+
+    glViewport(0, 0, width, height);
+
+    operation->setInputResampled(inWidth != width || inHeight != height);
+    operation->renderPass(operation->numPasses(), inTexId, outTexId, srcTexId);
+}
+
+
+
+void RenderManager::computeStatistics(GLuint texId, GLuint bufferId)
+{
+    // Mean, minimum, maximum and variance of texture, written to buffer without leaving GPU
+
+    GLuint width, height;
+    textureSize(texId, width, height);
+
+    // First stage: partial results per work group
+
+    mStatsProgram->bind();
+
+    glBindTextureUnit(0, texId);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mStatsPartialBuffer);
+
+    glDispatchCompute(mNumStatsGroups, mNumStatsGroups, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Second stage: partial results combined by a single work group
+
+    mStatsReduceProgram->bind();
+    mStatsReduceProgram->setUniformValue("numPartials", mNumStatsGroups * mNumStatsGroups);
+    mStatsReduceProgram->setUniformValue("numPixels", static_cast<GLfloat>(width) * static_cast<GLfloat>(height));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, bufferId);
+
+    glDispatchCompute(1, 1, 1);
+
+    // Statistics next read as uniform block or copied to client
+
+    glMemoryBarrier(GL_UNIFORM_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    glBindTextureUnit(0, 0);
+
+    mStatsReduceProgram->release();
+}
+
+
+
+void RenderManager::outputStatistics(ImageOperation* operation)
+{
+    // Skip while previous statistics are in flight, so that reading them never stalls
+
+    if (mStatsFences.contains(operation)) {
+        return;
+    }
+
+    if (!mStatsBufferIds.contains(operation))
+    {
+        GLuint bufferId = 0;
+        glCreateBuffers(1, &bufferId);
+        glNamedBufferStorage(bufferId, sizeof(GLfloat) * 16, nullptr, 0);
+        mStatsBufferIds.insert(operation, bufferId);
+    }
+
+    computeStatistics(operation->outTextureId(), mStatsBufferIds.value(operation));
+
+    mStatsFences.insert(operation, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
+
+
+
+QList<ImageOperation*> RenderManager::readStatistics()
+{
+    QList<ImageOperation*> readOps;
+
+    foreach (ImageOperation* operation, mStatsBufferIds.keys())
+    {
+        // Operations removed or not monitored any longer
+
+        if (!mSortedOperations.contains(operation) || !operation->statisticsEnabled())
+        {
+            deleteStatisticsBuffer(operation);
+            continue;
+        }
+
+        if (!mStatsFences.contains(operation)) {
+            continue;
+        }
+
+        GLenum result = glClientWaitSync(mStatsFences.value(operation), 0, 0);
+
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            GLfloat data[16];
+            glGetNamedBufferSubData(mStatsBufferIds.value(operation), 0, sizeof(data), data);
+
+            ImageStatistics statistics;
+            statistics.mean = QVector4D(data[0], data[1], data[2], data[3]);
+            statistics.minimum = QVector4D(data[4], data[5], data[6], data[7]);
+            statistics.maximum = QVector4D(data[8], data[9], data[10], data[11]);
+            statistics.variance = QVector4D(data[12], data[13], data[14], data[15]);
+
+            operation->setStatistics(statistics);
+
+            glDeleteSync(mStatsFences.take(operation));
+
+            readOps.append(operation);
+        }
+    }
+
+    return readOps;
+}
+
+
+
+void RenderManager::deleteStatisticsBuffer(ImageOperation* operation)
+{
+    if (mStatsFences.contains(operation)) {
+        glDeleteSync(mStatsFences.take(operation));
+    }
+
+    GLuint bufferId = mStatsBufferIds.take(operation);
+    glDeleteBuffers(1, &bufferId);
+}
+
+
+
+void RenderManager::render()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+
+    glBindVertexArray(mVao);
+
+    mRenderCount++;
+
+    staggerUpdatePhases();
+
+    if (mLutBaking) {
+        findLutChains();
+    }
+
+    if (mRegionRendering) {
+        findRenderRegions();
+    }
+
+    // Versions of seed outputs: video frames change every iteration
+
+    mOutputVersions.clear();
+
+    foreach (Seed* seed, mFactory->seeds())
+    {
+        quint64 version = combineVersion(seed->version(), *seed->pOutTextureId());
+
+        if (seed->type() == 3) {
+            version = combineVersion(version, mRenderCount);
+        }
+
+        mOutputVersions.insert(seed->pOutTextureId(), version);
+    }
+
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        // Skip operation if its version matches that of its last render: output texture still holds the result
+
+        bool dirty = false;
+        quint64 version = operationVersion(operation, dirty);
+
+        foreach (GLuint* texId, operation->pOutTextureIds()) {
+            mOutputVersions.insert(texId, version);
+        }
+
+        // Operations inside a baked chain are not rendered: its last one applies the LUT
+
+        ImageOperation* lutTail = mLutBaking ? mLutChainTails.value(operation, nullptr) : nullptr;
+
+        if (lutTail && lutTail != operation)
+        {
+            mOperationVersions.remove(operation);
+            continue;
+        }
+
+        // Decimated operation keeps previous output between updates, so it publishes the version it last rendered
+        // Otherwise downstream operations would record a version their input does not hold yet
+
+        if (!updateDue(operation))
+        {
+            foreach (GLuint* texId, operation->pOutTextureIds()) {
+                mOutputVersions.insert(texId, mOperationVersions.value(operation));
+            }
+
+            continue;
+        }
+
+        if (mIncrementalRender && !dirty && mOperationVersions.contains(operation) && mOperationVersions.value(operation) == version) {
+            continue;
+        }
+
+        mOperationVersions.insert(operation, version);
+
+        // Viewport of operation's own resolution
+
+        GLuint width = operationTexWidth(operation);
+        GLuint height = operationTexHeight(operation);
+
+        glViewport(0, 0, width, height);
+
+        if (lutTail)
+        {
+            bool scissor = enableScissor(operation, width, height);
+
+            renderLut(operation);
+
+            if (scissor) {
+                glDisable(GL_SCISSOR_TEST);
+            }
+
+            if (operation->statisticsEnabled()) {
+                outputStatistics(operation);
+            }
+
+            continue;
+        }
+
+        if (operation->blendEnabled()) {
+            blend(operation);
+        }
+
+        // Statistics of input, read by operation as uniform block
+
+        if (operation->enabled() && !operation->statisticsBlockName().isEmpty() && operation->inTextureId() != 0)
+        {
+            computeStatistics(operation->inTextureId(), mInputStatsBuffer);
+            glBindBufferBase(GL_UNIFORM_BUFFER, 0, mInputStatsBuffer);
+        }
+
+        if (operation->enabled() && (operation->numPasses() > 0 || operation->substeps() > 1))
+        {
+            renderSubsteps(operation);
+        }
+        else
+        {
+            // Input of different size gets resampled bilinearly
+
+            GLuint inWidth, inHeight;
+            textureSize(operation->inTextureId(), inWidth, inHeight);
+
+            operation->setInputResampled(inWidth != width || inHeight != height);
+
+            bool scissor = enableScissor(operation, width, height);
+
+            operation->render();
+
+            if (scissor) {
+                glDisable(GL_SCISSOR_TEST);
+            }
+        }
+
+        if (operation->statisticsEnabled()) {
+            outputStatistics(operation);
+        }
+    }
+
+    glViewport(0, 0, mTexWidth, mTexHeight);
+
+    glBindVertexArray(0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+
+
+quint64 RenderManager::operationVersion(ImageOperation* operation, bool& dirty)
+{
+    // Own parameters, program and textures
+
+    quint64 version = combineVersion(reinterpret_cast<quintptr>(operation), operation->version());
+    version = combineVersion(version, *operation->pOutTextureId());
+
+    // Input history in array texture shifts every iteration
+
+    dirty = operation->sampler2DArrayAvail();
+
+    foreach (InputData* input, operation->inputData())
+    {
+        // Blit inputs carry previous iteration's output, inputs not yet rendered are unknown
+
+        if (input->type() == InputType::Blit || !mOutputVersions.contains(input->pTextureId())) {
+            dirty = true;
+        }
+        else {
+            version = combineVersion(version, mOutputVersions.value(input->pTextureId()));
+        }
+
+        version = combineVersion(version, *input->pTextureId());
+        version = combineVersion(version, std::bit_cast<quint32>(input->blendFactor()->value()));
+    }
+
+    // Texels outside a previous region are stale
+
+    if (mRegionRendering)
+    {
+        QRectF region = mRenderRegions.value(operation, QRectF(0.0, 0.0, 1.0, 1.0));
+
+        version = combineVersion(version, std::bit_cast<quint64>(region.x()));
+        version = combineVersion(version, std::bit_cast<quint64>(region.y()));
+        version = combineVersion(version, std::bit_cast<quint64>(region.width()));
+        version = combineVersion(version, std::bit_cast<quint64>(region.height()));
+    }
+
+    if (dirty) {
+        version = combineVersion(version, mRenderCount);
+    }
+
+    return version;
+}
+
+
+
+QRectF RenderManager::maskRegion(float radius)
+{
+    // Bounding box of centred circle whose radius is relative to shorter side
+
+    qreal rx = radius;
+    qreal ry = radius;
+
+    if (mTexWidth >= mTexHeight) {
+        rx *= static_cast<qreal>(mTexHeight) / mTexWidth;
+    }
+    else {
+        ry *= static_cast<qreal>(mTexWidth) / mTexHeight;
+    }
+
+    return QRectF(0.5 - rx, 0.5 - ry, 2.0 * rx, 2.0 * ry);
 }
 
 
 
-void RenderManager::genOpTextures(ImageOperation* operation)
+void RenderManager::findRenderRegions()
 {
-    mContext->makeCurrent(mSurface);
+    // Regions read of each output, propagated from output backwards: outputs missing are read whole
 
-    foreach (GLuint* texId, operation->textureIds())
-    {
-        genTexture(texId, mTexFormat);
-        clearTexture(texId);
-    }
+    const QRectF whole(0.0, 0.0, 1.0, 1.0);
 
-    if (operation->sampler2DArrayAvail()) {
-        genArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth());
+    QMap<GLuint*, QRectF> readRegions;
+
+    auto addRegion = [&](GLuint* texId, QRectF region) {
+        if (!readRegions.contains(texId) || readRegions.value(texId).isEmpty()) {
+            readRegions.insert(texId, region);
+        }
+        else if (!region.isEmpty()) {
+            readRegions.insert(texId, readRegions.value(texId).united(region));
+        }
+    };
+
+    // Displayed output also read by probes, histograms and hashes
+
+    if (mOutputTexId) {
+        addRegion(mOutputTexId, whole);
     }
 
-    mContext->doneCurrent();
-}
+    // Blit inputs read next iteration: regions found in previous one
 
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        foreach (InputData* input, operation->inputData())
+        {
+            if (input->type() == InputType::Blit) {
+                addRegion(input->pTextureId(), mInputRegions.value(operation, whole));
+            }
+        }
+    }
 
+    mRenderRegions.clear();
+    mInputRegions.clear();
 
-void RenderManager::genArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth)
-{
-    glGenTextures(1, arrayTexId);
+    for (auto it = mSortedOperations.crbegin(); it != mSortedOperations.crend(); ++it)
+    {
+        ImageOperation* operation = *it;
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, *arrayTexId);
+        // Union over outputs read, all written at once; statistics cover whole output
 
-    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, static_cast<GLenum>(mTexFormat), mTexWidth, mTexHeight, arrayTexDepth);
+        QRectF region;
+        bool read = false;
 
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        foreach (GLuint* texId, operation->pOutTextureIds())
+        {
+            if (readRegions.contains(texId))
+            {
+                QRectF outRegion = readRegions.value(texId);
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-}
+                if (!read || region.isEmpty()) {
+                    region = outRegion;
+                }
+                else if (!outRegion.isEmpty()) {
+                    region = region.united(outRegion);
+                }
 
+                read = true;
+            }
+        }
 
+        if (!read || operation->statisticsEnabled()) {
+            region = whole;
+        }
 
-void RenderManager::blitTextures(GLuint srcTexId, GLuint srcTexWidth, GLuint srcTexHeight, GLuint dstTexId, GLuint dstTexWidth, GLuint dstTexHeight)
-{
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, mReadFbo);
-    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, srcTexId, 0);
+        region = region.intersected(whole);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mDrawFbo);
-    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dstTexId, 0);
+        mRenderRegions.insert(operation, region);
 
-    glBlitFramebuffer(0, 0, srcTexWidth, srcTexHeight, 0, 0, dstTexWidth, dstTexHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        // Inputs read over neighbourhood of region, one texel more for bilinear resampling, and only inside mask
 
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-}
+        QRectF inRegion = region;
 
+        if (operation->enabled() && !region.isEmpty())
+        {
+            int radius = operation->footprint();
 
+            if (radius < 0) {
+                inRegion = whole;
+            }
+            else
+            {
+                qreal dx = static_cast<qreal>(operation->substeps() * radius + 1) / operationTexWidth(operation);
+                qreal dy = static_cast<qreal>(operation->substeps() * radius + 1) / operationTexHeight(operation);
 
-void RenderManager::resizeTextures()
-{
-    // Store old texture Ids, generate new textures and blit old to new ones
+                inRegion = region.adjusted(-dx, -dy, dx, dy).intersected(whole);
+            }
 
-    QList<GLuint*> oldTexIds;
+            float maskRadius = operation->regionRadius();
 
-    foreach (Seed* seed, mFactory->seeds()) {
-        foreach (GLuint* texId, seed->textureIds()) {
-            oldTexIds.append(texId);
+            if (maskRadius >= 0.0f) {
+                inRegion = inRegion.intersected(maskRegion(maskRadius));
+            }
         }
-    }
 
-    foreach (ImageOperation* operation, mFactory->operations()) {
-        foreach (GLuint* texId, operation->textureIds()) {
-            oldTexIds.append(texId);
+        mInputRegions.insert(operation, inRegion);
+
+        foreach (InputData* input, operation->inputData())
+        {
+            if (input->type() != InputType::Blit) {
+                addRegion(input->pTextureId(), inRegion);
+            }
         }
     }
+}
 
-    foreach (GLuint* oldTexId, oldTexIds)
-    {
-        GLuint newTexId = 0;
-        genTexture(&newTexId, mTexFormat);
 
-        blitTextures(*oldTexId, mOldTexWidth, mOldTexHeight, newTexId, mTexWidth, mTexHeight);
 
-        glDeleteTextures(1, oldTexId);
-        *oldTexId = newTexId;
+bool RenderManager::enableScissor(ImageOperation* operation, GLuint width, GLuint height)
+{
+    // Single-pass fragment operations only: passes and substeps read neighbours of intermediate textures
+
+    if (!mRegionRendering || !operation->enabled() || operation->isCompute() || operation->numPasses() > 0 || operation->substeps() > 1) {
+        return false;
     }
 
-    // Resize frame texture
+    QRectF region = mRenderRegions.value(operation, QRectF(0.0, 0.0, 1.0, 1.0));
 
-    GLuint newTexId = 0;
-    genTexture(&newTexId, TextureFormat::RGBA8);
-    blitTextures(mFrameTexId, mOldTexWidth, mOldTexHeight, newTexId, mTexWidth, mTexHeight);
-    glDeleteTextures(1, &mFrameTexId);
-    mFrameTexId = newTexId;
+    if (region == QRectF(0.0, 0.0, 1.0, 1.0)) {
+        return false;
+    }
 
-    // Resize video textures
+    GLint x0 = static_cast<GLint>(std::floor(region.left() * width));
+    GLint y0 = static_cast<GLint>(std::floor(region.top() * height));
+    GLint x1 = static_cast<GLint>(std::ceil(region.right() * width));
+    GLint y1 = static_cast<GLint>(std::ceil(region.bottom() * height));
 
-    for (auto [devId, texId] : mVideoTextures.asKeyValueRange())
-    {
-        GLuint newTexId = 0;
-        genTexture(&newTexId, mTexFormat);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x0, y0, qMax(0, x1 - x0), qMax(0, y1 - y0));
 
-        blitTextures(texId, mOldTexWidth, mOldTexHeight, newTexId, mTexWidth, mTexHeight);
+    return true;
+}
 
-        glDeleteTextures(1, &texId);
-        mVideoTextures[devId] = newTexId;
-    }
 
-    setVideoTextures();
 
-    // Set output texture Ids
+void RenderManager::staggerUpdatePhases()
+{
+    // Recomputed only when decimated operations or their settings change
 
-    foreach (Seed* seed, mFactory->seeds())
-    {
-        seed->resizeImage();
-        seed->setOutTextureId();
-    }
+    quint64 key = 0;
 
-    foreach (ImageOperation* operation, mFactory->operations())
+    foreach (ImageOperation* operation, mSortedOperations)
     {
-        operation->setBlitInTextureId();
-        operation->setOutTextureId();
-        // operation->resetInputData();
+        if (operation->updateInterval() > 1)
+        {
+            key = combineVersion(key, reinterpret_cast<quintptr>(operation));
+            key = combineVersion(key, operation->updateInterval());
+            key = combineVersion(key, static_cast<quint64>(operation->updatePhase() + 1));
+        }
     }
 
-    emit texturesChanged();
-}
+    if (key == mUpdatePhasesKey) {
+        return;
+    }
 
+    mUpdatePhasesKey = key;
+    mUpdatePhases.clear();
 
+    // Updates per iteration over horizon: fixed phases first, then automatic ones where load is least
 
-void RenderManager::recreateArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth)
-{
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-    glDeleteTextures(1, arrayTexId);
-    genArrayTexture(arrayTexId, arrayTexDepth);
-}
+    QList<int> load(mUpdateHorizon, 0);
 
+    auto addLoad = [&](int interval, int phase) {
+        for (int t = phase; t < mUpdateHorizon; t += interval) {
+            load[t]++;
+        }
+    };
 
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        if (operation->updateInterval() > 1 && operation->updatePhase() >= 0)
+        {
+            mUpdatePhases.insert(operation, operation->updatePhase());
+            addLoad(operation->updateInterval(), operation->updatePhase());
+        }
+    }
 
-void RenderManager::shiftCopyArrayTextures()
-{
     foreach (ImageOperation* operation, mSortedOperations)
     {
-        if (operation->sampler2DArrayAvail())
+        int interval = operation->updateInterval();
+
+        if (interval <= 1 || operation->updatePhase() >= 0) {
+            continue;
+        }
+
+        int bestPhase = 0;
+        int bestLoad = -1;
+
+        for (int phase = 0; phase < interval; phase++)
         {
-            // Shift layers back by copying
+            int phaseLoad = 0;
 
-            for (GLint z = operation->arrayTextureDepth() - 2; z >= 0; z--) {
-                glCopyImageSubData(*operation->arrayTextureId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, z, *operation->arrayTextureId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, z + 1, mTexWidth, mTexHeight, 1);
+            for (int t = phase; t < mUpdateHorizon; t += interval) {
+                phaseLoad += load[t];
             }
 
-            // Copy input texture to first layer
-
-            glCopyImageSubData(operation->inTextureId(), GL_TEXTURE_2D, 0, 0, 0, 0, *operation->arrayTextureId(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, mTexWidth, mTexHeight, 1);
+            if (bestLoad < 0 || phaseLoad < bestLoad)
+            {
+                bestPhase = phase;
+                bestLoad = phaseLoad;
+            }
         }
+
+        mUpdatePhases.insert(operation, bestPhase);
+        addLoad(interval, bestPhase);
     }
 }
 
 
 
-void RenderManager::copyTexturesToBlendArrayTexture(QList<GLuint*> textures)
+bool RenderManager::updateDue(ImageOperation* operation)
 {
-    int nTextures = textures.size();
-    if (nTextures > mMaxArrayTexLayers) {
-        nTextures = mMaxArrayTexLayers;
-    }
+    int interval = operation->updateInterval();
 
-    for (int i = 0; i < nTextures; i++) {
-        glCopyImageSubData(*textures[i], GL_TEXTURE_2D, 0, 0, 0, 0, mBlendArrayTexId, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, mTexWidth, mTexHeight, 1);
+    if (!mDecimation || interval <= 1) {
+        return true;
     }
+
+    return static_cast<int>(mIterationNumber % interval) == mUpdatePhases.value(operation, 0);
 }
 
 
 
-void RenderManager::clearTexture(GLuint* texId)
+bool RenderManager::lutCandidate(ImageOperation* operation)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, *texId, 0);
-
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Single-input fragment operation, colours in [0, 1] so LUT covers them
+
+    return operation->pointwise() &&
+           operation->enabled() &&
+           !operation->blendEnabled() &&
+           !operation->isCompute() &&
+           operation->numPasses() == 0 &&
+           operation->sampler2DAvail() &&
+           !operation->sampler2DArrayAvail() &&
+           operation->statisticsBlockName().isEmpty() &&
+           operation->inputData().size() == 1 &&
+           operation->substeps() == 1 &&
+           operation->outputNames().isEmpty() &&
+           fixedPointFormat(operationTexFormat(operation));
 }
 
 
 
-void RenderManager::clearArrayTexture(GLuint* texId, GLsizei arrayTexDepth)
+void RenderManager::findLutChains()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
+    mLutChains.clear();
+    mLutChainTails.clear();
 
-    for (GLsizei layer = 0; layer < arrayTexDepth; layer++)
-    {
-        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, *texId, 0, layer);
-        glClear(GL_COLOR_BUFFER_BIT);
+    // Number of readers of each output, final output included
+
+    QMap<GLuint*, int> numReaders;
+
+    foreach (ImageOperation* operation, mSortedOperations) {
+        foreach (InputData* input, operation->inputData()) {
+            numReaders[input->pTextureId()]++;
+        }
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-}
+    if (mOutputTexId) {
+        numReaders[mOutputTexId]++;
+    }
 
+    // Candidate extends chain of operation producing its input if nothing else reads that output
 
+    QMap<GLuint*, ImageOperation*> producers;
 
-void RenderManager::clearAllOpsTextures()
-{
-    QList<GLuint*> texIds;
+    foreach (ImageOperation* operation, mSortedOperations)
+    {
+        if (!lutCandidate(operation)) {
+            continue;
+        }
 
-    foreach (ImageOperation* operation, mFactory->operations()) {
-        texIds.append(operation->textureIds());
-    }
+        InputData* input = operation->inputData().first();
+        ImageOperation* previous = producers.value(input->pTextureId(), nullptr);
 
-    mContext->makeCurrent(mSurface);
+        bool extends = previous &&
+                       input->type() == InputType::Normal &&
+                       numReaders.value(input->pTextureId()) == 1 &&
+                       !previous->blitEnabled() &&
+                       !previous->statisticsEnabled() &&
+                       operationTexFormat(previous) == operationTexFormat(operation) &&
+                       operationTexWidth(previous) == operationTexWidth(operation) &&
+                       operationTexHeight(previous) == operationTexHeight(operation);
 
-    foreach (GLuint* texId, texIds) {
-        clearTexture(texId);
-    }
+        QList<ImageOperation*> chain;
 
-    foreach (ImageOperation* operation, mFactory->operations()) {
-        if (operation->sampler2DArrayAvail()) {
-            clearArrayTexture(operation->arrayTextureId(), operation->arrayTextureDepth());
+        if (extends) {
+            chain = mLutChains.take(previous);
+        }
+
+        chain.append(operation);
+
+        mLutChains.insert(operation, chain);
+
+        foreach (ImageOperation* member, chain) {
+            mLutChainTails.insert(member, operation);
         }
+
+        producers.insert(operation->pOutTextureId(), operation);
     }
 
-    mContext->doneCurrent();
-}
+    // Single operations gain nothing from a LUT
 
+    foreach (ImageOperation* operation, mLutChains.keys())
+    {
+        if (mLutChains.value(operation).size() < 2)
+        {
+            mLutChains.remove(operation);
+            mLutChainTails.remove(operation);
+        }
+    }
 
+    // LUTs of chains no longer present
 
-void RenderManager::drawAllSeeds()
-{
-    foreach (Seed* seed, mFactory->seeds()) {
-        seed->draw();
+    foreach (ImageOperation* operation, mLutTexIds.keys())
+    {
+        if (!mLutChains.contains(operation))
+        {
+            GLuint lutTexId = mLutTexIds.take(operation);
+            glDeleteTextures(1, &lutTexId);
+            mLutVersions.remove(operation);
+        }
     }
 }
 
 
 
-void RenderManager::copyTextures()
+quint64 RenderManager::lutChainVersion(const QList<ImageOperation*>& chain)
 {
-    // Expects active OpenGL context
+    quint64 version = static_cast<quint64>(operationTexFormat(chain.last()));
 
-    foreach (ImageOperation* operation, mSortedOperations) {
-        if (operation->blitEnabled()) {
-            glCopyImageSubData(operation->blitInTextureId(), GL_TEXTURE_2D, 0, 0, 0, 0, operation->blitOutTextureId(), GL_TEXTURE_2D, 0, 0, 0, 0, mTexWidth, mTexHeight, 1);
-        }
+    foreach (ImageOperation* operation, chain)
+    {
+        version = combineVersion(version, reinterpret_cast<quintptr>(operation));
+        version = combineVersion(version, operation->version());
     }
+
+    return version;
 }
 
 
 
-void RenderManager::blend(ImageOperation *operation)
+void RenderManager::bakeLut(ImageOperation* operation, const QList<ImageOperation*>& chain)
 {
-    // Copy input textures to blend 2D array texture and wait for copy to finish before using it
+    TextureFormat format = operationTexFormat(operation);
+    GLsizei atlasWidth = mLutSize * mLutSize;
 
-    copyTexturesToBlendArrayTexture(operation->inputTextures());
-    // glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glViewport(0, 0, atlasWidth, mLutSize);
 
-    // Bind blend output texture, where render will occur
+    // Identity cube, rendered once
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, operation->blendOutTextureId(), 0);
+    if (!mLutIdentityTexId)
+    {
+        genTexture(&mLutIdentityTexId, TextureFormat::RGBA32F, atlasWidth, mLutSize);
 
-    glClear(GL_COLOR_BUFFER_BIT);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mLutIdentityTexId, 0);
 
-    mBlenderProgram->bind();
+        mLutIdentityProgram->bind();
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        mLutIdentityProgram->release();
+    }
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, mBlendArrayTexId);
+    // Ping-pong atlases in chain's format: each output quantized and clamped as when rendered
 
-    // Set blend factors
+    if (!mLutAtlasTexIds[0] || mLutAtlasFormat != format)
+    {
+        glDeleteTextures(2, mLutAtlasTexIds);
 
-    QList<float> weights(mNumArrayTexLayers, 0.0f);
-    int i = 0;
-    for (auto factor : operation->inputBlendFactors())
+        genTexture(&mLutAtlasTexIds[0], format, atlasWidth, mLutSize);
+        genTexture(&mLutAtlasTexIds[1], format, atlasWidth, mLutSize);
+
+        mLutAtlasFormat = format;
+    }
+
+    GLuint lutTexId = mLutTexIds.value(operation, 0);
+
+    if (!lutTexId || textureInternalFormat(lutTexId) != static_cast<GLenum>(format))
     {
-        weights[i++] = factor->value();
+        glDeleteTextures(1, &lutTexId);
 
-        if (i > mNumArrayTexLayers) {
-            break;
-        }
+        glCreateTextures(GL_TEXTURE_3D, 1, &lutTexId);
+        glTextureStorage3D(lutTexId, 1, static_cast<GLenum>(format), mLutSize, mLutSize, mLutSize);
+
+        glTextureParameteri(lutTexId, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(lutTexId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(lutTexId, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(lutTexId, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(lutTexId, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        mLutTexIds.insert(operation, lutTexId);
     }
 
-    GLint locWeights = mBlenderProgram->uniformLocation("weights");
-    glUniform1fv(locWeights, mNumArrayTexLayers, weights.constData());
+    // Chain rendered over identity cube with operations' own programs
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    GLuint inTexId = mLutIdentityTexId;
 
-    // Clean up
+    for (int i = 0; i < chain.size(); i++)
+    {
+        GLuint outTexId = mLutAtlasTexIds[i % 2];
 
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        chain[i]->setInputResampled(false);
+        chain[i]->renderPass(chain[i]->numPasses(), inTexId, outTexId);
 
-    mBlenderProgram->release();
+        inTexId = outTexId;
+    }
+
+    // Atlas slices into LUT layers
+
+    for (GLsizei z = 0; z < mLutSize; z++) {
+        glCopyImageSubData(inTexId, GL_TEXTURE_2D, 0, z * mLutSize, 0, 0, lutTexId, GL_TEXTURE_3D, 0, 0, 0, z, mLutSize, mLutSize, 1);
+    }
+
+    glViewport(0, 0, operationTexWidth(operation), operationTexHeight(operation));
 }
 
 
 
-void RenderManager::renderOperation(ImageOperation* operation)
+void RenderManager::renderLut(ImageOperation* operation)
 {
+    QList<ImageOperation*> chain = mLutChains.value(operation);
+    ImageOperation* head = chain.first();
+
+    // Rebake only when parameters of chain changed
+
+    if (!mLutTexIds.contains(operation) || mLutVersions.value(operation) != lutChainVersion(chain))
+    {
+        bakeLut(operation, chain);
+        mLutVersions.insert(operation, lutChainVersion(chain));
+    }
+
+    // Single lookup from first operation's input into last operation's output
+
+    GLuint inTexId = head->inTextureId();
+
+    GLuint inWidth, inHeight;
+    textureSize(inTexId, inWidth, inHeight);
+
+    bool resampled = inWidth != operationTexWidth(operation) || inHeight != operationTexHeight(operation);
+
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, operation->outTextureId(), 0);
 
     glClear(GL_COLOR_BUFFER_BIT);
 
-    operation->program()->bind();
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, operation->inTextureId());
+    mLutProgram->bind();
 
-    glBindSampler(0, operation->samplerId());
+    glBindTextureUnit(0, inTexId);
+    glBindSampler(0, resampled ? mTileSamplerId : head->samplerId());
+    glBindTextureUnit(1, mLutTexIds.value(operation));
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
     glBindSampler(0, 0);
+    glBindTextureUnit(0, 0);
+    glBindTextureUnit(1, 0);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    operation->program()->release();
+    mLutProgram->release();
 }
 
 
 
-void RenderManager::render()
+void RenderManager::deleteLuts()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, mOutFbo);
-
-    glBindVertexArray(mVao);
-
-    foreach (ImageOperation* operation, mSortedOperations)
-    {
-        if (operation->blendEnabled()) {
-            blend(operation);
-        }
-
-        operation->render();
+    foreach (GLuint lutTexId, mLutTexIds) {
+        glDeleteTextures(1, &lutTexId);
     }
 
-    glBindVertexArray(0);
+    mLutTexIds.clear();
+    mLutVersions.clear();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteTextures(2, mLutAtlasTexIds);
+    mLutAtlasTexIds[0] = 0;
+    mLutAtlasTexIds[1] = 0;
+
+    glDeleteTextures(1, &mLutIdentityTexId);
+    mLutIdentityTexId = 0;
 }
@@ -33,15 +33,27 @@
 #include "factory.h"
 #include "recorder.h"
 
+#include <cmath>
+#include <tuple>
+#include <algorithm>
+#include <bit>
 #include <QThread>
 #include <QOpenGLFunctions_4_5_Core>
 #include <QOpenGLContext>
 #include <QOffscreenSurface>
 #include <QOpenGLShaderProgram>
 #include <QImage>
+#include <QFile>
+#include <QRect>
+#include <QRectF>
+#include <QVector2D>
+#include <QVector3D>
+#include <QVector4D>
+#include <QPoint>
 #include <QChronoTimer>
 #include <QMutex>
 #include <QQueue>
+#include <QHash>
 
 
 
@@ -58,13 +70,20 @@ public:
     void setTargetFps(double fps);
     void adjustTimerInterval(long stepTimeNs);
 
+    void setAdaptiveResolution(bool set);
+    void setConvergenceDetection(bool set);
+    void setIterationsPerFrame(int iterations);
+    void setIncrementalRender(bool set);
+    void setLutBaking(bool set);
+    void setRegionRendering(bool set);
+
     void init(QOpenGLContext* context);
 
     bool active() const;
     void setActive(bool set);
 
     void sendOutputImage(bool set);
-    QList<float> rgbPixel(QPoint pos);
+    void setProbes(QList<QPoint> probes);
 
     TextureFormat texFormat();
 
@@ -75,6 +94,12 @@ public:
 
     void drawAllSeeds();
 
+    // Preloaded operations: current output carried over to them, and their texture memory
+
+    void holdOutput();
+    void carryOverOutput(ImageOperation* operation);
+    qint64 operationTextureBytes(ImageOperation* operation);
+
     int iterationNumber();
 
     QString version();
@@ -83,6 +108,11 @@ signals:
     void texturesChanged();
     void frameRecorded(int number);
     void frameReady(quintptr fence);
+    void effectiveSizeChanged(GLuint width, GLuint height);
+    void stillRendered(bool success, QString message);
+    void statisticsReady(ImageOperation* operation);
+    void probesRead(QList<QPoint> probes, QList<QVector3D> values, unsigned int iteration);
+    void convergenceChanged(int period);
 
 public slots:
     void iterate();
@@ -99,6 +129,7 @@ public slots:
     void setSortedOperations(QList<ImageOperation*> sortedOperations);
 
     void setTextureFormat(TextureFormat format);
+    void updateOperationTextures(ImageOperation* operation);
 
     void reset();
     void resetIterationNumer();
@@ -115,6 +146,8 @@ public slots:
 
     void takeScreenshot(QString filename);
 
+    void renderStill(QString filename, int width, int height, int iterations, int tileSize);
+
 private:
     QString mVersion = "1.0 alpha";
 
@@ -138,8 +171,30 @@ private:
     GLuint mTexWidth = 2048;
     GLuint mTexHeight = 2048;
 
-    GLuint mOldTexWidth = 2048;
-    GLuint mOldTexHeight = 2048;
+    GLuint mBaseTexWidth = 2048;
+    GLuint mBaseTexHeight = 2048;
+
+    // Adaptive resolution: textures scaled down in steps to hold target rate
+
+    bool mAdaptiveResolution = false;
+    const float mResolutionStepFactor = 0.85f;
+    const int mNumResolutionSteps = 9;
+    int mResolutionStep = 0;
+    int mOverBudgetCount = 0;
+    int mUnderBudgetCount = 0;
+    double mGpuTimeAvgNs = 0.0;
+
+    GLuint mTimeQuery = 0;
+    bool mTimeQueryPending = false;
+    GLuint64 mGpuTimeNs = 0;
+    bool mGpuTimeReady = false;
+
+    // Fast-forward: iterations per presented frame, 0 meaning as many as fit in frame budget
+
+    int mIterationsPerFrame = 1;
+    const int mMaxIterationsPerFrame = 1024;
+    int mTimedIterations = 1;
+    double mGpuTimePerIterationNs = 0.0;
 
     TextureFormat mTexFormat = TextureFormat::RGBA8;
 
@@ -151,19 +206,119 @@ private:
     const GLint mNumArrayTexLayers = 32;
 
     QOpenGLShaderProgram* mBlenderProgram;
+    QOpenGLShaderProgram* mTileProgram;
+    GLuint mTileSamplerId = 0;
     // QOpenGLShaderProgram* mIdentityProgram;
 
+    // Image statistics: two-stage reduction on GPU, results kept in small buffers
+
+    QOpenGLShaderProgram* mStatsProgram;
+    QOpenGLShaderProgram* mStatsReduceProgram;
+    const GLuint mNumStatsGroups = 16;
+    GLuint mStatsPartialBuffer = 0;
+    GLuint mInputStatsBuffer = 0;
+    QMap<ImageOperation*, GLuint> mStatsBufferIds;
+    QMap<ImageOperation*, GLsync> mStatsFences;
+
+    // Pixel probes of output: sampled in one dispatch, read back through mapped buffer a frame later
+
+    QOpenGLShaderProgram* mProbeProgram;
+    QList<QPoint> mProbes;
+    QList<QPoint> mDispatchedProbes;
+    unsigned int mDispatchedProbesIteration = 0;
+    bool mProbesChanged = false;
+    GLsizei mProbeCapacity = 0;
+    GLuint mProbeCoordsBuffer = 0;
+    GLuint mProbeValuesBuffer = 0;
+    GLuint mProbeReadBuffer = 0;
+    GLfloat* mProbeReadData = nullptr;
+    GLsync mProbeFence = 0;
+
+    // Convergence detection: output fingerprint hashed every iteration into a ring on GPU,
+    // whole ring read back when previous copy is done, so that no iteration is missed.
+    // Fingerprint history of a run of consecutive iterations searched for periods up to maximum.
+
+    QOpenGLShaderProgram* mHashProgram;
+    bool mConvergenceDetection = false;
+    const GLuint mHashGridSize = 32;
+    const float mHashLevels = 255.0f;
+    const qint64 mHashRingSize = 256;
+    GLuint mHashBuffer = 0;
+    GLuint mHashReadBuffer = 0;
+    GLuint* mHashReadData = nullptr;
+    GLsync mHashFence = 0;
+    qint64 mHashedIteration = -2;
+    int mHashRun = 0;
+    qint64 mHashRunStart = 0;
+    qint64 mHashFenceIteration = 0;
+    int mHashFenceRun = 0;
+    qint64 mHashFenceRunStart = 0;
+    int mReadHashRun = -1;
+    qint64 mReadHashIteration = -1;
+    QList<quint64> mHashHistory;
+    const int mMaxPeriod = 64;
+    const int mPeriodRepeats = 3;
+    int mConvergencePeriod = 0;
+
+    // Incremental evaluation: operations whose version did not change keep their last output
+
+    bool mIncrementalRender = true;
+    quint64 mRenderCount = 0;
+    QMap<ImageOperation*, quint64> mOperationVersions;
+    QMap<GLuint*, quint64> mOutputVersions;
+
+    // Regions of operation outputs read downstream, in texture coordinates, found backwards from masks
+
+    bool mRegionRendering = true;
+    QMap<ImageOperation*, QRectF> mRenderRegions;
+    QMap<ImageOperation*, QRectF> mInputRegions;
+
+    // Temporal decimation: phases of operations updated every few iterations, staggered over a horizon
+
+    bool mDecimation = true;
+    const int mUpdateHorizon = 240;
+    quint64 mUpdatePhasesKey = 0;
+    QMap<ImageOperation*, int> mUpdatePhases;
+
+    // Chains of pointwise operations baked into 3D LUTs, keyed by chain's last operation
+
+    bool mLutBaking = false;
+    const GLsizei mLutSize = 64;
+    QOpenGLShaderProgram* mLutProgram;
+    QOpenGLShaderProgram* mLutIdentityProgram;
+    GLuint mLutIdentityTexId = 0;
+    GLuint mLutAtlasTexIds[2] = { 0, 0 };
+    TextureFormat mLutAtlasFormat = TextureFormat::RGBA8;
+    QMap<ImageOperation*, QList<ImageOperation*>> mLutChains;
+    QMap<ImageOperation*, ImageOperation*> mLutChainTails;
+    QMap<ImageOperation*, GLuint> mLutTexIds;
+    QMap<ImageOperation*, quint64> mLutVersions;
+
     GLuint mVao;
     GLuint mVboPos;
     GLuint mVboTex;
 
     GLuint* mOutputTexId = nullptr;
-    GLuint mBlendArrayTexId = 0;
+    QMap<std::tuple<TextureFormat, GLuint, GLuint>, GLuint> mBlendArrayTexIds;
+    QMap<std::tuple<TextureFormat, GLuint, GLuint, int>, GLuint> mPassTexIds;
+
+    // Formats and sizes of textures, recorded where allocated: no driver queries per frame
+    // Entries of textures deleted by their owners linger until their ids are reused and overwritten
+
+    struct TextureInfo
+    {
+        GLenum format;
+        GLuint width;
+        GLuint height;
+    };
+
+    QHash<GLuint, TextureInfo> mTextureInfos;
 
     bool mActive = false;
     unsigned int mIterationNumber = 0;
 
     GLuint mFrameTexId = 0;
+    GLuint mHeldOutputTexId = 0;
     GLuint mPbo = 0;
     GLsync mFence = 0;
     bool mGrabOutputTexture = false;
@@ -181,22 +336,52 @@ private:
     Recorder* recorder = nullptr;
 
     void setBlenderProgram();
+    void setTileProgram();
+    void setStatisticsPrograms();
+    void setProbeProgram();
+    void setHashProgram();
+    void setLutPrograms();
     // void setIdentityProgram();
 
+    void readTimeQuery();
+    float resolutionStepScale();
+    int frameIterations();
+    void adaptResolution();
+    void setTextureSize(GLuint width, GLuint height);
+
     void verticesCoords(GLfloat& left, GLfloat& right, GLfloat& bottom, GLfloat& top);
     void setVao();
     void adjustOrtho();
 
+    TextureFormat operationTexFormat(ImageOperation* operation);
+    GLenum textureInternalFormat(GLuint texId);
+    bool operationTexturesStale(ImageOperation* operation);
+
+    GLuint scaledSize(GLuint size, float scale);
+    GLuint operationTexWidth(ImageOperation* operation);
+    GLuint operationTexHeight(ImageOperation* operation);
+    void textureSize(GLuint texId, GLuint& width, GLuint& height);
+
     void genTexture(GLuint* texId, TextureFormat texFormat);
+    void genTexture(GLuint* texId, TextureFormat texFormat, GLuint width, GLuint height);
+    void regenTexture(GLuint* texId, TextureFormat texFormat, GLuint width, GLuint height);
     void genOpTextures(ImageOperation* operation);
     void resizeTextures();
 
     void blitTextures(GLuint srcTexId, GLuint srcTexWidth, GLuint srcTexHeight, GLuint newTexId, GLuint dstTexWidth, GLuint dstTexHeight);
 
-    void copyTexturesToBlendArrayTexture(QList<GLuint*> textures);
+    void copyTexture(GLuint srcTexId, GLuint dstTexId);
+    void copyTextureToLayer(GLuint srcTexId, GLuint arrayTexId, GLint layer);
 
-    void genArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth);
-    void recreateArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth);
+    GLuint blendArrayTexture(TextureFormat format, GLuint width, GLuint height);
+    void deleteBlendArrayTextures();
+
+    GLuint passTexture(TextureFormat format, GLuint width, GLuint height, int slot);
+    void deletePassTextures();
+    void copyTexturesToBlendArrayTexture(QList<GLuint*> textures, GLuint arrayTexId);
+
+    void genArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth, TextureFormat texFormat, GLuint width, GLuint height);
+    void recreateArrayTexture(GLuint* arrayTexId, GLsizei arrayTexDepth, TextureFormat texFormat, GLuint width, GLuint height);
 
     void shiftCopyArrayTextures();
 
@@ -206,9 +391,52 @@ private:
     void copyTextures();
     void blend(ImageOperation* operation);
     void renderOperation(ImageOperation* operation);
+    void renderSubsteps(ImageOperation* operation);
+    void renderPasses(ImageOperation* operation, GLuint srcTexId, GLuint outTexId);
     void render();
+    quint64 operationVersion(ImageOperation* operation, bool& dirty);
+
+    QRectF maskRegion(float radius);
+    void findRenderRegions();
+    bool enableScissor(ImageOperation* operation, GLuint width, GLuint height);
+
+    void staggerUpdatePhases();
+    bool updateDue(ImageOperation* operation);
+
+    bool lutCandidate(ImageOperation* operation);
+    void findLutChains();
+    quint64 lutChainVersion(const QList<ImageOperation*>& chain);
+    void bakeLut(ImageOperation* operation, const QList<ImageOperation*>& chain);
+    void renderLut(ImageOperation* operation);
+    void deleteLuts();
+
+    void computeStatistics(GLuint texId, GLuint bufferId);
+    void outputStatistics(ImageOperation* operation);
+    QList<ImageOperation*> readStatistics();
+    void deleteStatisticsBuffer(ImageOperation* operation);
+
+    void reserveProbeBuffers(GLsizei count);
+    void deleteProbeBuffers();
+    void sampleProbes();
+    bool readProbes(QList<QPoint>& probes, QList<QVector3D>& values, unsigned int& iteration);
+
+    void hashOutput();
+    bool readHashes();
+    int detectPeriod();
 
     void setImageTextures();
+
+    // Tiled still rendering
+
+    int stillHalo(int iterations, QString& error);
+    QList<GLuint*> stillTextureIds();
+    void setOutTextureIds();
+    void drawTileRegion(GLuint srcTexId, QRectF region, GLuint width, GLuint height);
+    GLuint tileTexture(GLuint srcTexId, QRectF region, GLuint width, GLuint height);
+    GLuint tileArrayTexture(GLuint srcArrayTexId, GLsizei arrayTexDepth, QRectF region, GLuint width, GLuint height);
+    void genTileTextures(const QMap<GLuint*, GLuint>& workTexIds, QRectF region);
+    void deleteTileTextures();
+    bool writeTile(QFile& file, qint64 dataOffset, int imageWidth, QRect tileRect, QRect validRect);
 };
 
 
@@ -24,12 +24,11 @@
 
 #include "rgbwidget.h"
 #include <QGraphicsOpacityEffect>
+#include <algorithm>
 
 
-RGBWidget::RGBWidget(int w, int h, QWidget* parent) :
-    QOpenGLWidget(parent),
-    texWidth { w },
-    texHeight { h }
+RGBWidget::RGBWidget(QWidget* parent) :
+    QOpenGLWidget(parent)
 {
     /*QSurfaceFormat format;
     format.setDepthBufferSize(24);
@@ -46,24 +45,32 @@ RGBWidget::RGBWidget(int w, int h, QWidget* parent) :
 
 RGBWidget::~RGBWidget()
 {
+    makeCurrent();
+
     if (vao && vao->isCreated())
         vao->destroy();
 
-    if (vbo && vbo->isCreated())
-        vbo->destroy();
+    // Buffers exist only if shown once: OpenGL functions unresolved otherwise
 
-    if (vao3D && vao3D->isCreated())
-        vao3D->destroy();
+    if (isValid())
+    {
+        glDeleteBuffers(1, &densityBuffer);
 
-    if (vbo3D && vbo3D->isCreated())
-        vbo3D->destroy();
+        if (pathBuffer) {
+            glUnmapNamedBuffer(pathBuffer);
+        }
+
+        glDeleteBuffers(1, &pathBuffer);
+        glDeleteVertexArrays(1, &pathVao);
+    }
 
     if (program) delete program;
+    if (densityComputeProgram) delete densityComputeProgram;
+    if (densityProgram) delete densityProgram;
     if (program3D) delete program3D;
     if (vao) delete vao;
-    if (vbo) delete vbo;
-    if (vao3D) delete vao3D;
-    if (vbo3D) delete vbo3D;
+
+    doneCurrent();
 }
 
 
@@ -75,6 +82,8 @@ void RGBWidget::initializeGL()
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
     program = new QOpenGLShaderProgram();
@@ -85,6 +94,25 @@ void RGBWidget::initializeGL()
     if (!program->link())
         qDebug() << "Shader link error:\n" << program->log();
 
+    densityComputeProgram = new QOpenGLShaderProgram();
+    if (!densityComputeProgram->addShaderFromSourceFile(QOpenGLShader::Compute, ":/shaders/rgb_density.comp"))
+        qDebug() << "Compute shader error:\n" << densityComputeProgram->log();
+    if (!densityComputeProgram->link())
+        qDebug() << "Shader link error:\n" << densityComputeProgram->log();
+
+    densityProgram = new QOpenGLShaderProgram();
+    if (!densityProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/rgb_density.vert"))
+        qDebug() << "Vertex shader error:\n" << densityProgram->log();
+    if (!densityProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, ":/shaders/rgb_density.frag"))
+        qDebug() << "Fragment shader error:\n" << densityProgram->log();
+    if (!densityProgram->link())
+        qDebug() << "Shader link error:\n" << densityProgram->log();
+
+    // Density grid: maximum count followed by one counter per bin
+
+    glCreateBuffers(1, &densityBuffer);
+    glNamedBufferStorage(densityBuffer, (maxDensityBins * maxDensityBins * maxDensityBins + 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
     program3D = new QOpenGLShaderProgram();
     if (!program3D->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/shaders/3d.vert"))
         qDebug() << "Vertex shader error:\n" << program3D->log();
@@ -93,21 +121,17 @@ void RGBWidget::initializeGL()
     if (!program3D->link())
         qDebug() << "Shader link error:\n" << program3D->log();
 
+    // Empty vertex array: points generated from vertex index
+
     vao = new QOpenGLVertexArrayObject();
     vao->create();
 
-    vbo = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-    vbo->create();
-    vbo->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    glCreateVertexArrays(1, &pathVao);
+    glEnableVertexArrayAttrib(pathVao, 0);
+    glVertexArrayAttribFormat(pathVao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(pathVao, 0, 0);
 
-    setupBuffer(texWidth, texHeight);
-
-    vao3D = new QOpenGLVertexArrayObject();
-    vao3D->create();
-
-    vbo3D = new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
-    vbo3D->create();
-    vbo3D->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    allocatePathBuffer();
 
     computeTransformMatrix();
 }
@@ -120,35 +144,33 @@ void RGBWidget::paintGL()
 
     // Draw RGB points
 
-    program->bind();
-
-    if (textureID)
-        glBindTexture(GL_TEXTURE_2D, *textureID);
-    else
-        glBindTexture(GL_TEXTURE_2D, 0);
+    if (textureID && *textureID)
+    {
+        GLint texWidth = 0, texHeight = 0;
+        glGetTextureLevelParameteriv(*textureID, 0, GL_TEXTURE_WIDTH, &texWidth);
+        glGetTextureLevelParameteriv(*textureID, 0, GL_TEXTURE_HEIGHT, &texHeight);
 
-    vao->bind();
-    glDrawArrays(GL_POINTS, 0, numPoints);
-    vao->release();
+        if (texWidth > 0 && texHeight > 0)
+        {
+            if (cloudMode == CloudMode::Density)
+                drawDensity(texWidth, texHeight);
+            else
+                drawPoints(texWidth, texHeight);
+        }
+    }
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Draw RGB lines: one strip per path, straight from ring buffer
 
-    program->release();
+    if (pathBuffer && !pathFirsts.isEmpty())
+    {
+        program3D->bind();
+        glBindVertexArray(pathVao);
 
-    // Draw RGB lines
+        glMultiDrawArrays(GL_LINE_STRIP, pathFirsts.constData(), pathCounts.constData(), pathFirsts.size());
 
-    program3D->bind();
-    vao3D->bind();
-
-    GLint first = 0;
-    foreach (GLuint nv, numVertices)
-    {
-        glDrawArrays(GL_LINES, first, nv);
-        first += nv;
+        glBindVertexArray(0);
+        program3D->release();
     }
-
-    vao3D->release();
-    program3D->release();
 }
 
 
@@ -168,55 +190,161 @@ void RGBWidget::setTextureID(GLuint* id)
 
 
 
-void RGBWidget::setupBuffer(int w, int h)
+void RGBWidget::drawPoints(int texWidth, int texHeight)
 {
+    int step = pointStep;
+
+    if (step == 0)
+    {
+        step = 1;
+        while ((texWidth / step) * (texHeight / step) > maxPoints)
+            step *= 2;
+    }
+
+    int gridWidth = (texWidth + step - 1) / step;
+    int gridHeight = (texHeight + step - 1) / step;
+
+    program->bind();
+    glUniform2i(program->uniformLocation("gridSize"), gridWidth, gridHeight);
+    program->setUniformValue("sampleStep", step);
+
+    glBindTextureUnit(0, *textureID);
+
+    vao->bind();
+    glDrawArrays(GL_POINTS, 0, gridWidth * gridHeight);
+    vao->release();
+
+    glBindTextureUnit(0, 0);
+
+    program->release();
+}
+
+
+
+void RGBWidget::drawDensity(int texWidth, int texHeight)
+{
+    GLuint numBins = densityBins * densityBins * densityBins;
+
+    // Scatter colours into grid
+
+    glClearNamedBufferSubData(densityBuffer, GL_R32UI, 0, (numBins + 1) * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, densityBuffer);
+    glBindTextureUnit(0, *textureID);
+
+    densityComputeProgram->bind();
+    densityComputeProgram->setUniformValue("numBins", densityBins);
+    glDispatchCompute((texWidth + 15) / 16, (texHeight + 15) / 16, 1);
+    densityComputeProgram->release();
+
+    glBindTextureUnit(0, 0);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Draw one point per bin, sized and faded by density
+
+    densityProgram->bind();
+    densityProgram->setUniformValue("numBins", densityBins);
+    densityProgram->setUniformValue("pointSize", 0.5f * scale * height() / densityBins);
+
     vao->bind();
-    vbo->bind();
+    glDrawArrays(GL_POINTS, 0, numBins);
+    vao->release();
+
+    densityProgram->release();
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+}
+
 
-    QList<QVector2D> texCoords;
 
-    for (int y = 0; y < h; y++)
+void RGBWidget::reservePathRegions(int numRegions, int capacity)
+{
+    pathRegions = numRegions;
+    pathCapacity = capacity;
+
+    // Allocated on initialization otherwise
+
+    if (isValid())
     {
-        for (int x = 0; x < w; x++)
-        {
-            texCoords.append(QVector2D(x / static_cast<float>(w), y / static_cast<float>(h)));
-        }
+        makeCurrent();
+        allocatePathBuffer();
+        doneCurrent();
     }
+}
 
-    vbo->allocate(texCoords.constData(), texCoords.size() * sizeof(QVector2D));
 
-    int texLocation = program->attributeLocation("texCoord");
-    program->enableAttributeArray(texLocation);
-    program->setAttributeBuffer(texLocation, GL_FLOAT, 0, 2);
 
-    vbo->release();
-    vao->release();
+void RGBWidget::allocatePathBuffer()
+{
+    if (pathRegions <= allocatedRegions && pathCapacity == allocatedCapacity)
+        return;
+
+    int numRegions = std::max(pathRegions, 1);
+
+    GLsizeiptr regionSize = 2 * pathCapacity * 3 * sizeof(GLfloat);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    GLuint buffer = 0;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, numRegions * regionSize, nullptr, flags);
+
+    if (pathBuffer)
+    {
+        // Histories kept if only number of regions grows
+
+        if (pathCapacity == allocatedCapacity)
+            glCopyNamedBufferSubData(pathBuffer, buffer, 0, 0, allocatedRegions * regionSize);
+
+        glUnmapNamedBuffer(pathBuffer);
+        glDeleteBuffers(1, &pathBuffer);
+    }
 
-    numPoints = w * h;
+    pathBuffer = buffer;
+    pathData = static_cast<GLfloat*>(glMapNamedBufferRange(pathBuffer, 0, numRegions * regionSize, flags));
+
+    allocatedRegions = numRegions;
+    allocatedCapacity = pathCapacity;
+
+    glVertexArrayVertexBuffer(pathVao, 0, pathBuffer, 0, 3 * sizeof(GLfloat));
 }
 
 
 
-void RGBWidget::setLines(QList<GLfloat> vertices)
+void RGBWidget::writePathPoint(int region, int slot, QVector3D color)
 {
-    makeCurrent();
+    if (!pathData || region >= allocatedRegions || slot >= allocatedCapacity)
+        return;
 
-    vao3D->bind();
+    // Written at slot and its copy one capacity ahead
 
-    vbo3D->bind();
-    vbo3D->allocate(vertices.data(), vertices.size() * sizeof(GLfloat));
+    GLfloat* point = pathData + 3 * (2 * region * allocatedCapacity + slot);
+    GLfloat* copy = point + 3 * allocatedCapacity;
 
-    program3D->bind();
+    for (int i = 0; i < 3; i++) {
+        point[i] = color[i];
+        copy[i] = color[i];
+    }
+}
 
-    int posLocation = program3D->attributeLocation("pos");
-    program3D->enableAttributeArray(posLocation);
-    program3D->setAttributeBuffer(posLocation, GL_FLOAT, 0, 3);
 
-    program3D->release();
-    vbo3D->release();
-    vao3D->release();
 
-    doneCurrent();
+void RGBWidget::setPaths(QList<ColorPath> paths)
+{
+    pathFirsts.clear();
+    pathCounts.clear();
+
+    if (pathCapacity != allocatedCapacity)
+        return;
+
+    foreach (ColorPath path, paths)
+    {
+        if (path.size() > 1 && path.region() < allocatedRegions)
+        {
+            pathFirsts.append(2 * path.region() * allocatedCapacity + path.first());
+            pathCounts.append(path.size());
+        }
+    }
 }
 
 
@@ -246,6 +374,10 @@ void RGBWidget::computeTransformMatrix()
     program->setUniformValue("transform", transform);
     program->release();
 
+    densityProgram->bind();
+    densityProgram->setUniformValue("transform", transform);
+    densityProgram->release();
+
     program3D->bind();
     program3D->setUniformValue("transform", transform);
     program3D->release();
@@ -307,6 +439,43 @@ void RGBWidget::mouseMoveEvent(QMouseEvent* event)
 
 
 
+void RGBWidget::contextMenuEvent(QContextMenuEvent* event)
+{
+    QMenu menu;
+
+    QMenu* pointsMenu = menu.addMenu("Points");
+
+    foreach (int step, QList<int>({ 0, 1, 2, 4, 8 }))
+    {
+        QString text = step == 0 ? "Automatic" : (step == 1 ? "Every pixel" : QString("1 in %1").arg(step * step));
+
+        QAction* action = pointsMenu->addAction(text, this, [=, this]() {
+            cloudMode = CloudMode::Points;
+            pointStep = step;
+            update();
+        });
+        action->setCheckable(true);
+        action->setChecked(cloudMode == CloudMode::Points && step == pointStep);
+    }
+
+    QMenu* densityMenu = menu.addMenu("Density");
+
+    foreach (GLuint bins, QList<GLuint>({ 32, 64, 128 }))
+    {
+        QAction* action = densityMenu->addAction(QString("%1³ bins").arg(bins), this, [=, this]() {
+            cloudMode = CloudMode::Density;
+            densityBins = bins;
+            update();
+        });
+        action->setCheckable(true);
+        action->setChecked(cloudMode == CloudMode::Density && bins == densityBins);
+    }
+
+    menu.exec(event->globalPos());
+}
+
+
+
 QVector3D RGBWidget::getArcBallVector(const QPoint& screenPoint)
 {
     QVector3D vector = QVector3D(1.0f - 2.0f * screenPoint.x() / width(), 2.0f * screenPoint.y() / height() - 1.0f, 0.0f);
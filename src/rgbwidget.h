@@ -25,11 +25,12 @@
 
 
 #include <cmath>
+#include "colorpath.h"
+
 #include <QOpenGLWidget>
-#include <QOpenGLExtraFunctions>
+#include <QOpenGLFunctions_4_5_Core>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLVertexArrayObject>
-#include <QOpenGLBuffer>
 #include <QIcon>
 #include <QMatrix4x4>
 #include <QVector3D>
@@ -38,25 +39,38 @@
 #include <QCloseEvent>
 #include <QWheelEvent>
 #include <QMouseEvent>
+#include <QContextMenuEvent>
+#include <QMenu>
+
 
 
+// Output colours plotted in RGB space, either as subsampled points or binned into a density grid
 
-class RGBWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions
+enum class CloudMode
+{
+    Points,
+    Density
+};
+
+
+
+class RGBWidget : public QOpenGLWidget, protected QOpenGLFunctions_4_5_Core
 {
     Q_OBJECT
 
 public:
-    RGBWidget(int w, int h, QWidget* parent = nullptr);
+    RGBWidget(QWidget* parent = nullptr);
     virtual ~RGBWidget() override;
 
     void initializeGL() override;
     void paintGL() override;
     void resizeGL(int w, int h) override;
 
-    void setupBuffer(int w, int h);
     void setTextureID(GLuint *id);
-    void setLines(QList<GLfloat> vertices);
-    void setNumVertices(QList<GLuint> nv){ numVertices = nv; }
+
+    void reservePathRegions(int numRegions, int capacity);
+    void writePathPoint(int region, int slot, QVector3D color);
+    void setPaths(QList<ColorPath> paths);
 
 signals:
     void closing();
@@ -66,21 +80,43 @@ protected:
     void wheelEvent(QWheelEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
+    void contextMenuEvent(QContextMenuEvent* event) override;
 
 private:
     QOpenGLShaderProgram* program = nullptr;
     QOpenGLVertexArrayObject* vao = nullptr;
-    QOpenGLBuffer* vbo = nullptr;
+
+    QOpenGLShaderProgram* densityComputeProgram = nullptr;
+    QOpenGLShaderProgram* densityProgram = nullptr;
+    GLuint densityBuffer = 0;
 
     QOpenGLShaderProgram* program3D = nullptr;
-    QOpenGLVertexArrayObject* vao3D = nullptr;
-    QOpenGLBuffer* vbo3D = nullptr;
+
+    // Path histories: one ring region per path in a persistently mapped buffer
+
+    GLuint pathVao = 0;
+    GLuint pathBuffer = 0;
+    GLfloat* pathData = nullptr;
+    int pathRegions = 0;
+    int pathCapacity = 2;
+    int allocatedRegions = 0;
+    int allocatedCapacity = 0;
+    QList<GLint> pathFirsts;
+    QList<GLsizei> pathCounts;
 
     GLuint* textureID = nullptr;
-    int texWidth, texHeight;
-    int numPoints;
 
-    QList<GLuint> numVertices;
+    CloudMode cloudMode = CloudMode::Points;
+
+    // Points mode: one point every step texels, automatic step (0) keeps at most maxPoints
+
+    int pointStep = 0;
+    const int maxPoints = 1 << 20;
+
+    // Density mode: bins per colour channel
+
+    static const GLuint maxDensityBins = 128;
+    GLuint densityBins = 64;
 
     float scale = 1.0f;
     QMatrix4x4 rotation;
@@ -89,6 +125,11 @@ private:
     QQuaternion rotationQuaternion;
     QPoint prevPos;
 
+    void drawPoints(int texWidth, int texHeight);
+    void drawDensity(int texWidth, int texHeight);
+
+    void allocatePathBuffer();
+
     void computeTransformMatrix();
     QVector3D getArcBallVector(const QPoint& point);
 };
@@ -313,6 +313,8 @@ void Seed::resizeImage()
 {
     if (!mImage.isNull())
     {
+        mVersion++;
+
         qreal sx = static_cast<qreal>(mTexWidth)  / mImage.width();
         qreal sy = static_cast<qreal>(mTexHeight) / mImage.height();
         qreal scale = qMin(1.0, qMin(sx, sy));
@@ -386,6 +388,13 @@ bool Seed::fixed() const
 
 
 
+quint64 Seed::version() const
+{
+    return mVersion;
+}
+
+
+
 void Seed::setFixed(bool set)
 {
     mFixed = set;
@@ -421,6 +430,7 @@ void Seed::setClearTexture()
     {
         *pOutTexId = mClearTexId;
         mCleared = true;
+        mVersion++;
     }
 }
 
@@ -428,6 +438,8 @@ void Seed::setClearTexture()
 
 void Seed::setOutTextureId()
 {
+    mVersion++;
+
     if (mFixed || !mCleared)
     {
         if (mType == 0 || mType == 1) {
@@ -449,6 +461,8 @@ void Seed::setOutTextureId()
 
 void Seed::genTextures(GLenum texFormat, GLuint width, GLuint height)
 {
+    mVersion++;
+
     // Allocated on immutable storage (glTexStorage2D)
 
     foreach (GLuint* texId, textureIds())
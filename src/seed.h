@@ -79,11 +79,17 @@ public:
 
     void setVideoTexture(GLuint texId);
 
+    quint64 version() const;
+
 private:
     int mType = 0;
     bool mFixed = false;
     bool mCleared = true;
 
+    // Incremented whenever output texture or its contents change
+
+    quint64 mVersion = 0;
+
     QString mImageFilename;
     QImage mImage;
 
@@ -113,6 +113,8 @@ SeedWidget::SeedWidget(QUuid id, Seed* seed, VideoInputControl* videoInCtrl, QWi
 
     setLayout(mainLayout);
 
+    setWindowTitle("Seed");
+
     setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Maximum);
 }
 
@@ -0,0 +1,250 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "sortbenchmark.h"
+#include "operationsorter.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+
+
+SortBenchmark::SortBenchmark() :
+    mRandom { 12345 }
+{
+}
+
+
+
+SortBenchmark::~SortBenchmark()
+{
+    clearGraph();
+}
+
+
+
+void SortBenchmark::buildGraph(int numNodes)
+{
+    clearGraph();
+
+    QList<ImageOperationNode*> nodes;
+
+    for (int i = 0; i < numNodes; i++)
+    {
+        ImageOperation* operation = new ImageOperation();
+        operation->setName(QString("Operation %1").arg(i % 16));
+        mOperations.append(operation);
+
+        ImageOperationNode* node = new ImageOperationNode(QUuid::createUuid(), operation);
+        mNodes.insert(node->id(), node);
+        nodes.append(node);
+    }
+
+    // Each node reads one to three of the previous fifty, and every fiftieth one is fed back from further on
+
+    for (int i = 1; i < numNodes; i++)
+    {
+        int numInputs = mRandom.bounded(1, 4);
+
+        for (int j = 0; j < numInputs; j++)
+        {
+            ImageOperationNode* srcNode = nodes[mRandom.bounded(qMax(0, i - 50), i)];
+
+            if (!nodes[i]->isInput(srcNode->id())) {
+                connectNodes(srcNode, nodes[i], InputType::Normal);
+            }
+        }
+
+        if (i % 50 == 0 && i + 1 < numNodes)
+        {
+            ImageOperationNode* srcNode = nodes[mRandom.bounded(i + 1, numNodes)];
+            connectNodes(srcNode, nodes[i], InputType::Blit);
+        }
+    }
+}
+
+
+
+void SortBenchmark::clearGraph()
+{
+    qDeleteAll(mNodes);
+    mNodes.clear();
+
+    qDeleteAll(mOperations);
+    mOperations.clear();
+}
+
+
+
+void SortBenchmark::connectNodes(ImageOperationNode* srcNode, ImageOperationNode* dstNode, InputType type)
+{
+    dstNode->addInput(srcNode, new InputData(type, srcNode->pOutTextureId(), 1.0f));
+    srcNode->addOutput(dstNode);
+}
+
+
+
+int SortBenchmark::numEdges()
+{
+    int count = 0;
+
+    foreach (ImageOperationNode* node, mNodes) {
+        count += node->numInputs();
+    }
+
+    return count;
+}
+
+
+
+int SortBenchmark::legacySort()
+{
+    // Previous algorithm, repeated passes over pending nodes, as reference
+
+    QList<ImageOperation*> sortedOperations;
+    QMap<QUuid, ImageOperationNode*> pendingNodes = mNodes;
+
+    foreach (ImageOperationNode* node, mNodes) {
+        node->setComputed(false);
+    }
+
+    foreach (ImageOperationNode* node, mNodes)
+    {
+        if (node->numInputs() == 0 && node->numOutputs() == 0)
+        {
+            pendingNodes.remove(node->id());
+        }
+        else if ((node->numInputs() == 0 && node->numOutputs() > 0) || (node->numInputs() > 0 && node->numNonNormalInputs() == node->numInputs()))
+        {
+            sortedOperations.append(node->operation());
+            pendingNodes.remove(node->id());
+            node->setComputed(true);
+        }
+    }
+
+    while (!pendingNodes.empty())
+    {
+        QList<ImageOperationNode*> computedNodes;
+
+        foreach (ImageOperationNode* node, pendingNodes)
+        {
+            if (node->allInputsComputed())
+            {
+                sortedOperations.append(node->operation());
+                computedNodes.append(node);
+                node->setComputed(true);
+            }
+        }
+
+        foreach (ImageOperationNode* node, computedNodes) {
+            pendingNodes.remove(node->id());
+        }
+
+        if (computedNodes.empty()) {
+            break;
+        }
+    }
+
+    return sortedOperations.size();
+}
+
+
+
+void SortBenchmark::run()
+{
+    QList<int> sizes = { 250, 500, 1000, 2000 };
+
+    foreach (int size, sizes)
+    {
+        buildGraph(size);
+
+        QElapsedTimer timer;
+
+        // Previous algorithm
+
+        timer.start();
+
+        for (int i = 0; i < mRepeats; i++) {
+            legacySort();
+        }
+
+        double legacyTime = timer.nsecsElapsed() * 1.0e-6 / mRepeats;
+
+        // Level sort from scratch
+
+        OperationSorter sorter;
+
+        timer.restart();
+
+        for (int i = 0; i < mRepeats; i++)
+        {
+            OperationSorter freshSorter;
+            freshSorter.sort(mNodes);
+        }
+
+        double sortTime = timer.nsecsElapsed() * 1.0e-6 / mRepeats;
+
+        // Edits: an edge removed and added back, order kept within levels
+
+        sorter.sort(mNodes);
+
+        QList<ImageOperationNode*> nodes = mNodes.values();
+        qint64 editTimeNs = 0;
+
+        for (int i = 0; i < mRepeats; i++)
+        {
+            ImageOperationNode* dstNode = nodes[mRandom.bounded(nodes.size())];
+
+            QMap<QUuid, InputData*> inputs = dstNode->inputs();
+
+            if (inputs.isEmpty() || inputs.first()->type() != InputType::Normal) {
+                continue;
+            }
+
+            ImageOperationNode* srcNode = mNodes.value(inputs.firstKey());
+
+            dstNode->removeInput(srcNode);
+            srcNode->removeOutput(dstNode);
+
+            timer.restart();
+            sorter.sort(mNodes);
+            editTimeNs += timer.nsecsElapsed();
+
+            connectNodes(srcNode, dstNode, InputType::Normal);
+
+            timer.restart();
+            sorter.sort(mNodes);
+            editTimeNs += timer.nsecsElapsed();
+        }
+
+        double editTime = editTimeNs * 1.0e-6 / (2 * mRepeats);
+
+        qInfo().noquote() << QString("%1 nodes, %2 edges, %3 levels: previous sort %4 ms, level sort %5 ms, after edit %6 ms (%7 sorted)")
+            .arg(size).arg(numEdges()).arg(sorter.numLevels())
+            .arg(legacyTime, 0, 'f', 3).arg(sortTime, 0, 'f', 3).arg(editTime, 0, 'f', 3)
+            .arg(sorter.sortedNodes().size());
+    }
+
+    clearGraph();
+}
@@ -0,0 +1,69 @@
+/*
+*  Copyright 2025 Jose Maria Castelo Ares
+*
+*  Contact: <jose.maria.castelo@gmail.com>
+*  Repository: <https://github.com/jmcastelo/fosforo>
+*
+*  This file is part of Fosforo.
+*
+*  Fosforo is free software: you can redistribute it and/or modify
+*  it under the terms of the GNU General Public License as published by
+*  the Free Software Foundation, either version 3 of the License, or
+*  (at your option) any later version.
+*
+*  Fosforo is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with Fosforo.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef SORTBENCHMARK_H
+#define SORTBENCHMARK_H
+
+
+
+#include "imageoperation.h"
+#include "imageoperationnode.h"
+#include "inputdata.h"
+
+#include <QList>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QUuid>
+
+
+
+// Times sorting of synthetic operation graphs: from scratch, and again after single edge edits
+
+class SortBenchmark
+{
+public:
+    SortBenchmark();
+    ~SortBenchmark();
+
+    void run();
+
+private:
+    QMap<QUuid, ImageOperationNode*> mNodes;
+    QList<ImageOperation*> mOperations;
+
+    QRandomGenerator mRandom;
+
+    int mRepeats = 20;
+
+    void buildGraph(int numNodes);
+    void clearGraph();
+    void connectNodes(ImageOperationNode* srcNode, ImageOperationNode* dstNode, InputType type);
+    int numEdges();
+
+    int legacySort();
+};
+
+
+
+#endif // SORTBENCHMARK_H
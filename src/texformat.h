@@ -4,6 +4,7 @@
 
 
 #include <QOpenGLFunctions>
+#include <QString>
 
 
 
@@ -13,13 +14,14 @@ enum class TextureFormat {
     RGBA4 = GL_RGBA4,
     RGBA8 = GL_RGBA8,
     //RGBA8_SNORM = GL_RGBA8_SNORM,
-    //RGB10_A2 = GL_RGB10_A2,
+    RGB10_A2 = GL_RGB10_A2,
     //RGB10_A2UI = GL_RGB10_A2UI,
     RGBA12 = GL_RGBA12,
     //SRGB8_ALPHA8 = GL_SRGB8_ALPHA8,
     RGBA16 = GL_RGBA16,
     RGBA16F = GL_RGBA16F,
-    RGBA32F = GL_RGBA32F
+    RGBA32F = GL_RGBA32F,
+    R11F_G11F_B10F = GL_R11F_G11F_B10F
     //RGBA8I = GL_RGBA8I,
     //RGBA8UI = GL_RGBA8UI,
     //RGBA16I = GL_RGBA16I,
@@ -30,4 +32,89 @@ enum class TextureFormat {
 
 
 
+inline int textureFormatBytes(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::RGBA2: return 1;
+        case TextureFormat::RGBA4: return 2;
+        case TextureFormat::RGBA8: return 4;
+        case TextureFormat::RGB10_A2: return 4;
+        case TextureFormat::RGBA12: return 6;
+        case TextureFormat::RGBA16: return 8;
+        case TextureFormat::RGBA16F: return 8;
+        case TextureFormat::RGBA32F: return 16;
+        case TextureFormat::R11F_G11F_B10F: return 4;
+        default: return 4;
+    }
+}
+
+
+
+// Whether a stored value names one of the formats above
+
+inline bool isTextureFormat(int value)
+{
+    switch (static_cast<TextureFormat>(value))
+    {
+        case TextureFormat::RGBA2:
+        case TextureFormat::RGBA4:
+        case TextureFormat::RGBA8:
+        case TextureFormat::RGB10_A2:
+        case TextureFormat::RGBA12:
+        case TextureFormat::RGBA16:
+        case TextureFormat::RGBA16F:
+        case TextureFormat::RGBA32F:
+        case TextureFormat::R11F_G11F_B10F:
+            return true;
+        default:
+            return false;
+    }
+}
+
+
+
+// Nearest format usable with image load/store, as written by compute shaders
+
+inline TextureFormat imageTextureFormat(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::RGBA2: return TextureFormat::RGBA8;
+        case TextureFormat::RGBA4: return TextureFormat::RGBA8;
+        case TextureFormat::RGBA12: return TextureFormat::RGBA16;
+        default: return format;
+    }
+}
+
+
+
+inline QString textureFormatToString(TextureFormat format)
+{
+    switch (format)
+    {
+        case TextureFormat::RGBA2: return "RGBA2";
+        case TextureFormat::RGBA4: return "RGBA4";
+        case TextureFormat::RGBA8: return "RGBA8";
+        //case TextureFormat::RGBA8_SNORM: return "RGBA8_SNORM";
+        case TextureFormat::RGB10_A2: return "RGB10_A2";
+        //case TextureFormat::RGB10_A2UI: return "RGB10_A2";
+        case TextureFormat::RGBA12: return "RGBA12";
+        //case TextureFormat::SRGB8_ALPHA8: return "SRGB8_ALPHA8";
+        case TextureFormat::RGBA16: return "RGBA16";
+        case TextureFormat::RGBA16F: return "RGBA16F";
+        case TextureFormat::RGBA32F: return "RGBA32F";
+        case TextureFormat::R11F_G11F_B10F: return "R11F_G11F_B10F";
+        //case TextureFormat::RGBA8I: return "RGBA8I";
+        //case TextureFormat::RGBA8UI: return "RGBA8UI";
+        //case TextureFormat::RGBA16I: return "RGBA16I";
+        //case TextureFormat::RGBA16UI: return "RGBA16UI";
+        //case TextureFormat::RGBA32I: return "RGBA32I";
+        //case TextureFormat::RGBA32UI: return "RGBA32UI";
+        default: return "Unknown";
+    }
+}
+
+
+
 #endif // TEXFORMAT_H